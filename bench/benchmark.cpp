@@ -0,0 +1,118 @@
+#include "generator.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tmxpp.hpp>
+#include <utility>
+
+using tmx::bench::Format;
+using tmx::bench::MapSpec;
+
+namespace {
+    // Generating the largest maps takes a while and they are hundreds of megabytes, so only the map used by the
+    // current group of benchmarks is kept. Benchmarks are registered grouped by map to make use of that
+    const std::string& cachedMap(const MapSpec& spec) {
+        static MapSpec cachedSpec{.size = -1};
+        static std::string cached;
+        if(cachedSpec.size != spec.size || cachedSpec.objects != spec.objects ||
+            cachedSpec.properties != spec.properties || cachedSpec.format != spec.format) {
+            cached = tmx::bench::generateMap(spec);
+            cachedSpec = spec;
+        }
+        return cached;
+    }
+
+    void setCounters(benchmark::State& state, const MapSpec& spec, std::size_t bytes) {
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+        state.counters["cells/s"] = benchmark::Counter(
+            static_cast<double>(spec.size) * spec.size, benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    // Whole parse as done by Map::parseFromData
+    void parse(benchmark::State& state, MapSpec spec) {
+        const std::string& data = cachedMap(spec);
+        for(auto _ : state) {
+            tmx::Map map;
+            map.parseFromData(data);
+            benchmark::DoNotOptimize(map);
+        }
+        setCounters(state, spec, data.size());
+    }
+
+    // Reading of the document alone, tile data is kept encoded
+    void parseXML(benchmark::State& state, MapSpec spec) {
+        const std::string& data = cachedMap(spec);
+        tmx::ParseOptions options;
+        options.lazyTileData = true;
+        for(auto _ : state) {
+            tmx::Map map;
+            map.parseFromData(data, options);
+            benchmark::DoNotOptimize(map);
+        }
+        setCounters(state, spec, data.size());
+    }
+
+    // Decoding and decompression of tile data, the document is parsed and the map destroyed outside of the measured
+    // time. For compressed data it covers base64 decoding, decompression and copying into cells, which are one call
+    void decode(benchmark::State& state, MapSpec spec) {
+        const std::string& data = cachedMap(spec);
+        tmx::ParseOptions options;
+        options.lazyTileData = true;
+        std::optional<tmx::Map> map;
+        for(auto _ : state) {
+            state.PauseTiming();
+            map.emplace();
+            map->parseFromData(data, options);
+            state.ResumeTiming();
+            for(const tmx::Layer& layer : map->layers()) {
+                if(layer.type() == tmx::Layer::Type::TILE) {
+                    layer.tileLayer().ensureDecoded();
+                }
+            }
+            benchmark::DoNotOptimize(*map);
+        }
+        setCounters(state, spec, data.size());
+    }
+
+    // Objects with properties and shapes on a map with almost no tile data
+    void parseObjects(benchmark::State& state, MapSpec spec) {
+        const std::string& data = cachedMap(spec);
+        for(auto _ : state) {
+            tmx::Map map;
+            map.parseFromData(data);
+            benchmark::DoNotOptimize(map);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * data.size()));
+        state.counters["objects/s"] =
+            benchmark::Counter(static_cast<double>(spec.objects), benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    template <typename Function>
+    void add(const std::string& name, Function function, const MapSpec& spec) {
+        benchmark::RegisterBenchmark(name.c_str(), function, spec)->Unit(benchmark::kMillisecond);
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    for(int size : {256, 1024, 4096, 8192}) {
+        for(Format format : {Format::CSV, Format::BASE64, Format::ZLIB, Format::GZIP, Format::ZSTD}) {
+            MapSpec spec{.size = size, .format = format};
+            std::string suffix = "/" + std::string(tmx::bench::formatName(format)) + "/" + std::to_string(size);
+            add("Parse" + suffix, parse, spec);
+            add("XML" + suffix, parseXML, spec);
+            add((format == Format::CSV || format == Format::BASE64 ? "Decode" : "DecodeDecompress") + suffix, decode, spec);
+        }
+    }
+    for(int objects : {1000, 10000, 100000}) {
+        add("Objects/" + std::to_string(objects), parseObjects, MapSpec{.size = 16, .objects = objects});
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "generator.hpp"
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <tmxpp.hpp>
+
+namespace {
+    // splitmix64, standard library distributions are not guaranteed to give the same values everywhere
+    class Random {
+    public:
+        explicit Random(std::uint64_t seed) : state(seed) {}
+
+        std::uint64_t next() {
+            std::uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+            value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+            return value ^ (value >> 31U);
+        }
+
+        int below(int bound) { return static_cast<int>(next() % static_cast<std::uint64_t>(bound)); }
+
+    private:
+        std::uint64_t state;
+    };
+
+    void append(std::string& out, std::uint64_t value) {
+        char buffer[20];
+        auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    }
+
+    void append(std::string& out, int value) {
+        char buffer[12];
+        auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    }
+
+    void appendTiles(std::string& out, const tmx::bench::MapSpec& spec, Random& random) {
+        constexpr std::uint64_t flipHorizontal = 0x80000000;
+        std::uint64_t tile = 1;
+        for(int y = 0; y < spec.size; y++) {
+            for(int x = 0; x < spec.size; x++) {
+                // Runs of about eight tiles, an empty cell every so often and a few flipped tiles
+                int roll = random.below(64);
+                if(roll < 8) {
+                    tile = 1 + random.below(256);
+                } else if(roll == 8) {
+                    tile = 0;
+                }
+                append(out, roll == 9 && tile != 0 ? tile | flipHorizontal : tile);
+                if(x != spec.size - 1 || y != spec.size - 1) {
+                    out += ',';
+                }
+            }
+            out += '\n';
+        }
+    }
+
+    void appendObjects(std::string& out, const tmx::bench::MapSpec& spec, Random& random) {
+        int extent = spec.size * 16;
+        for(int i = 0; i < spec.objects; i++) {
+            out += "  <object id=\"";
+            append(out, i + 1);
+            out += "\" name=\"object ";
+            append(out, i + 1);
+            out += "\" type=\"";
+            out += i % 3 == 0 ? "enemy" : (i % 3 == 1 ? "pickup" : "trigger");
+            out += "\" x=\"";
+            append(out, random.below(extent));
+            out += "\" y=\"";
+            append(out, random.below(extent));
+            out += "\" width=\"32\" height=\"16\">\n";
+
+            if(spec.properties > 0) {
+                out += "   <properties>\n";
+                for(int j = 0; j < spec.properties; j++) {
+                    out += "    <property name=\"property";
+                    append(out, j);
+                    switch(j % 4) {
+                        case 0:
+                            out += "\" type=\"int\" value=\"";
+                            append(out, random.below(1000));
+                            break;
+                        case 1:
+                            out += "\" type=\"float\" value=\"";
+                            append(out, random.below(100));
+                            out += ".5";
+                            break;
+                        case 2:
+                            out += "\" type=\"bool\" value=\"";
+                            out += random.below(2) == 0 ? "true" : "false";
+                            break;
+                        default:
+                            out += "\" value=\"text value ";
+                            append(out, random.below(1000));
+                            break;
+                    }
+                    out += "\"/>\n";
+                }
+                out += "   </properties>\n";
+            }
+
+            switch(i % 4) {
+                case 1:
+                    out += "   <ellipse/>\n";
+                    break;
+                case 2:
+                    out += "   <point/>\n";
+                    break;
+                case 3:
+                    out += "   <polygon points=\"0,0 32,0 32,16 16,24 0,16\"/>\n";
+                    break;
+                default:
+                    break;
+            }
+            out += "  </object>\n";
+        }
+    }
+} // namespace
+
+std::string_view tmx::bench::formatName(Format format) {
+    switch(format) {
+        case Format::CSV:
+            return "csv";
+        case Format::BASE64:
+            return "base64";
+        case Format::ZLIB:
+            return "zlib";
+        case Format::GZIP:
+            return "gzip";
+        case Format::ZSTD:
+            return "zstd";
+    }
+    return "";
+}
+
+std::string tmx::bench::generateMap(const MapSpec& spec) {
+    Random random(spec.seed);
+    std::string out;
+    out.reserve((static_cast<std::size_t>(spec.size) * spec.size * 4) + (static_cast<std::size_t>(spec.objects) * 400));
+
+    out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<map version=\"1.10\" tiledversion=\"1.11.0\" orientation=\"orthogonal\" renderorder=\"right-down\" "
+           "width=\"";
+    append(out, spec.size);
+    out += "\" height=\"";
+    append(out, spec.size);
+    out += "\" tilewidth=\"16\" tileheight=\"16\" infinite=\"0\" nextlayerid=\"3\" nextobjectid=\"";
+    append(out, spec.objects + 1);
+    out += "\">\n"
+           " <tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"256\" "
+           "columns=\"16\">\n"
+           "  <image source=\"tiles.png\" width=\"256\" height=\"256\"/>\n"
+           " </tileset>\n"
+           " <layer id=\"1\" name=\"ground\" width=\"";
+    append(out, spec.size);
+    out += "\" height=\"";
+    append(out, spec.size);
+    out += "\">\n  <data encoding=\"csv\">\n";
+    appendTiles(out, spec, random);
+    out += "</data>\n </layer>\n <objectgroup id=\"2\" name=\"objects\">\n";
+    appendObjects(out, spec, random);
+    out += " </objectgroup>\n</map>\n";
+
+    if(spec.format == Format::CSV) {
+        return out;
+    }
+
+    // Other encodings are produced by the writer from the CSV version, its output is the same as Tiled's
+    tmx::Map map;
+    map.parseFromData(out);
+    tmx::SaveOptions options;
+    options.encoding = tmx::SaveOptions::Encoding::BASE64;
+    switch(spec.format) {
+        case Format::ZLIB:
+            options.compression = tmx::SaveOptions::Compression::ZLIB;
+            break;
+        case Format::GZIP:
+            options.compression = tmx::SaveOptions::Compression::GZIP;
+            break;
+        case Format::ZSTD:
+            options.compression = tmx::SaveOptions::Compression::ZSTD;
+            break;
+        default:
+            break;
+    }
+    return map.saveToData(options);
+}
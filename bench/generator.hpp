@@ -0,0 +1,28 @@
+#ifndef TMXPP_BENCH_GENERATOR_HPP
+#define TMXPP_BENCH_GENERATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace tmx::bench {
+    enum class Format : unsigned char { CSV, BASE64, ZLIB, GZIP, ZSTD };
+
+    struct MapSpec {
+        // Maps are square, size is width and height in tiles
+        int size = 256;
+        int objects = 0;
+        // Number of custom properties of every object
+        int properties = 4;
+        Format format = Format::CSV;
+        std::uint64_t seed = 1;
+    };
+
+    [[nodiscard]] std::string_view formatName(Format format);
+
+    // Builds a TMX map with one tile layer and an object group. Output depends only on the spec, tile data has
+    // runs of repeating tiles with occasional flipped ones, so it compresses about as well as hand made maps
+    [[nodiscard]] std::string generateMap(const MapSpec& spec);
+} // namespace tmx::bench
+
+#endif
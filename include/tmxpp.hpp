@@ -1,12 +1,18 @@
 #ifndef TMXPP_HPP
 #define TMXPP_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <span>
+#include <stop_token>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -26,10 +32,6 @@
     Namespace::Type& Namespace::Type::operator=(Namespace::Type&&) noexcept = default; \
     Namespace::Type::~Type() = default;
 
-namespace tinyxml2 {
-    class XMLElement;
-}
-
 namespace tmx {
     struct Point;
     struct IntPoint;
@@ -43,9 +45,32 @@ namespace tmx {
 
     enum class Type : unsigned char;
 
-    using LoaderType = std::function<std::string(std::filesystem::path)>;
+    class Buffer;
+    using LoaderType = std::function<Buffer(std::filesystem::path)>;
+
+    struct ParseProgress;
+    using ProgressCallback = std::function<void(const ParseProgress&)>;
+    struct ParseStats;
+    enum class LayerType : unsigned char;
+    struct LayerInfo;
+    struct ObjectInfo;
+    using LayerFilter = std::function<bool(const LayerInfo&)>;
+    using ObjectFilter = std::function<bool(const ObjectInfo&)>;
+    class TemplateCache;
+    struct ParseOptions;
+    struct SaveOptions;
+    struct MapChanges;
+    struct FlatLayer;
+    struct AtlasOptions;
+    struct AtlasLayout;
+    class TileGrid;
+    struct VisibleCells;
+    struct BatchOptions;
+    class TileBatches;
+    class CollisionGrid;
 
     class Exception;
+    class CancelledException;
     class PropertyValue;
     class Properties;
     class Map;
@@ -55,9 +80,12 @@ namespace tmx {
     class TileLayer;
     class ImageLayer;
     class ObjectGroup;
+    class GroupLayer;
     class Object;
     class Text;
     class Layer;
+    class FileWatcher;
+    using TilePredicate = std::function<bool(const Tile&)>;
 
     namespace internal {
         template <typename T>
@@ -65,6 +93,15 @@ namespace tmx {
 
         class AbstractLayer;
         class DataBlock;
+        class Element;
+        class BinaryWriter;
+        class BinaryReader;
+        class XmlWriter;
+        struct ObjectTemplate;
+        struct TemplateContext;
+
+        // Returns the handle of an image in the map being parsed
+        using ImageRegistry = std::function<int(const Image& image)>;
     }
 } // namespace tmx
 
@@ -99,6 +136,234 @@ private:
     std::string error;
 };
 
+// Contiguous file contents handed to the parser. Buffer either owns the bytes (moved std::string or
+// arbitrary owner released with the last copy of the buffer) or is a view into memory kept alive by the caller
+class tmx::Buffer {
+public:
+    Buffer() = default;
+    Buffer(std::string data); // NOLINT(google-explicit-constructor)
+    Buffer(const char* data, std::size_t size) noexcept;
+    Buffer(const char* data, std::size_t size, std::shared_ptr<const void> owner) noexcept;
+
+    [[nodiscard]] static Buffer fromFile(const std::filesystem::path& path);
+
+    [[nodiscard]] const char* data() const noexcept { return ptr; }
+    [[nodiscard]] std::size_t size() const noexcept { return length; }
+    [[nodiscard]] std::string_view view() const noexcept { return {ptr, length}; }
+    [[nodiscard]] const std::shared_ptr<const void>& owner() const noexcept { return holder; }
+
+private:
+    const char* ptr = "";
+    std::size_t length = 0;
+    std::shared_ptr<const void> holder;
+};
+
+class tmx::CancelledException : public Exception {
+public:
+    CancelledException() : Exception("Parsing was cancelled") {}
+};
+
+struct tmx::ParseProgress {
+    enum class Stage : unsigned char { XML_PARSED, TILESET_LOADED, LAYER_PARSED, FINISHED };
+
+    Stage stage = Stage::XML_PARSED;
+    int index = 0; // index of the loaded tileset or layer
+    int count = 0; // total number of tilesets or layers, 0 if not known in advance
+    std::size_t bytesParsed = 0;
+    std::size_t bytesTotal = 0;
+};
+
+// Where time goes while parsing, collected when tmxpp is built with TMXPP_PROFILING and ParseOptions::stats is set.
+// Scopes nest: a map contains its tilesets and layers, a layer contains decoding, which contains decompression
+struct tmx::ParseStats {
+    enum class Phase : unsigned char { MAP, TILESET, LAYER, DECODE, DECOMPRESS, OBJECTS };
+
+    struct Scope {
+        Phase phase = Phase::MAP;
+        // Layer or tileset name
+        std::string name;
+        int depth = 0;
+        std::uint64_t nanoseconds = 0;
+        // Time not spent in nested scopes, for a map it is mostly reading the document
+        std::uint64_t selfNanoseconds = 0;
+        std::uint64_t bytesIn = 0;
+        std::uint64_t bytesOut = 0;
+        // Only counted if the application calls recordAllocation() from its operator new
+        std::uint64_t allocations = 0;
+    };
+
+    // Scopes in the order they began, so nested scopes follow their parent. Every parse appends to it
+    std::vector<Scope> scopes;
+
+    // Sum of all scopes of the phase
+    [[nodiscard]] Scope total(Phase phase) const;
+
+    // Counts an allocation made by the calling thread. tmxpp doesn't replace operator new, applications that
+    // want allocation counts call this from their replacement
+    static void recordAllocation() noexcept;
+};
+
+enum class tmx::LayerType : unsigned char { EMPTY, TILE, IMAGE, OBJECT, GROUP };
+
+// Attributes known before contents of a layer or object are parsed, passed to filters in ParseOptions.
+// A rejected group is skipped with all layers inside it
+struct tmx::LayerInfo {
+    LayerType type = LayerType::EMPTY;
+    int id = 0;
+    std::string_view name;
+    std::string_view className;
+};
+
+struct tmx::ObjectInfo {
+    int id = 0;
+    std::string_view name;
+    std::string_view className;
+};
+
+// Object templates (.tx and .tj files) parsed once and shared by all objects instantiated from them. Set
+// ParseOptions::templateCache to share templates between maps loaded with the same loader. Entries are never
+// invalidated, clear the cache after template files change. Thread-safe. Parsing with a moved-from cache throws
+class tmx::TemplateCache {
+    friend class Object;
+
+public:
+    TemplateCache();
+    TemplateCache(const TemplateCache&) = delete;
+    TemplateCache(TemplateCache&& other) noexcept;
+    TemplateCache& operator=(const TemplateCache&) = delete;
+    TemplateCache& operator=(TemplateCache&& other) noexcept;
+    ~TemplateCache();
+
+    void clear();
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct Data;
+    std::unique_ptr<Data> d;
+};
+
+struct tmx::ParseOptions {
+    // STREAMING reads the document in a single forward pass without building a DOM,
+    // DOM builds a tinyxml2 document first, which also makes element counts in progress known in advance
+    enum class Backend : unsigned char { STREAMING, DOM };
+
+    Backend backend = Backend::STREAMING;
+    // Called from the parsing thread after each stage
+    ProgressCallback progress = nullptr;
+    // Checked between stages, parsing throws CancelledException once stop is requested
+    std::stop_token stopToken;
+    // When set, Map::parseFromFile keeps baked copies of parsed maps in this directory and loads them instead
+    // of parsing while the map and its external tilesets are unchanged
+    std::filesystem::path cacheDirectory;
+    // Keep encoded tile layer data and decode each layer on first access instead of while parsing
+    bool lazyTileData = false;
+
+    // Layers and objects rejected by filters are skipped without being decoded or stored
+    LayerFilter layerFilter = nullptr;
+    ObjectFilter objectFilter = nullptr;
+    bool skipProperties = false;
+    // Text objects are not stored
+    bool skipText = false;
+    // Tileset <tile> elements (animations, collision shapes, per-tile images and properties) are not parsed
+    bool skipTileMetadata = false;
+    // Neither embedded nor external tilesets are loaded
+    bool skipTilesets = false;
+    // Templates of objects are cached for a single parse unless a cache is set
+    std::shared_ptr<TemplateCache> templateCache = nullptr;
+
+    // Profiling, has no effect unless tmxpp is built with TMXPP_PROFILING. Scopes of the parse are appended to
+    // stats, and callbacks are called from the parsing thread when a scope begins and ends
+    ParseStats* stats = nullptr;
+    std::function<void(ParseStats::Phase phase, std::string_view name)> scopeBegin = nullptr;
+    std::function<void(ParseStats::Phase phase)> scopeEnd = nullptr;
+};
+
+struct tmx::SaveOptions {
+    enum class Encoding : unsigned char { CSV, BASE64 };
+    enum class Compression : unsigned char { NONE, ZLIB, GZIP, ZSTD };
+
+    Encoding encoding = Encoding::CSV;
+    // Only allowed with base64 encoding
+    Compression compression = Compression::NONE;
+    // Codec specific compression level, -1 uses the codec default
+    int compressionLevel = -1;
+    // Tile layers are encoded and compressed in parallel, 0 uses std::thread::hardware_concurrency()
+    unsigned int threads = 0;
+};
+
+// Result of Map::reload(), lists everything that differs from the previously loaded version of the map
+struct tmx::MapChanges {
+    // Area in cells
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    struct LayerChange {
+        enum class Kind : unsigned char { ADDED, REMOVED, MODIFIED };
+
+        Kind kind = Kind::MODIFIED;
+        // Index in Map::flatLayers() of the reloaded map, or of the previous one for removed layers. Groups are not
+        // reported, changes of a group are reported for every layer inside it
+        int index = 0;
+        int id = 0;
+        LayerType type = LayerType::EMPTY;
+        // Anything other than tile data changed: attributes, properties, objects or attributes of a parent group
+        bool attributesChanged = false;
+        // Changed cells of a tile layer, a single rect covering the whole layer if it was added or resized
+        std::vector<Rect> dirtyRects;
+    };
+
+    // Map attributes or properties changed
+    bool mapChanged = false;
+    // Layers that are present in both versions are in a different order
+    bool orderChanged = false;
+    // Indices of changed or added tilesets, all of them when the number of tilesets changed
+    std::vector<int> tilesets;
+    std::vector<LayerChange> layers;
+
+    [[nodiscard]] bool empty() const { return !mapChanged && !orderChanged && tilesets.empty() && layers.empty(); }
+};
+
+// Tile, image or object layer with attributes of the groups containing it already applied, see Map::flatLayers()
+struct tmx::FlatLayer {
+    const Layer* layer = nullptr;
+    // Innermost group containing the layer, nullptr for top level layers
+    const GroupLayer* group = nullptr;
+    int depth = 0;
+    // Sum of offsets
+    Point offset;
+    // Product of opacities
+    double opacity = 1;
+    // Product of tint colors, channel by channel. Layers without a tint color count as white
+    Color tintColor{.r = 255, .g = 255, .b = 255, .a = 255};
+    // False if the layer or any group containing it is hidden
+    bool visible = true;
+    // Product of parallax factors
+    Point parallaxFactor{.x = 1, .y = 1};
+};
+
+// Reports modifications of a set of files, e.g. Map::sourceFiles() to trigger Map::reload(). Uses inotify on Linux
+// and compares modification times elsewhere. Files that are replaced by renaming over them are detected as well
+class tmx::FileWatcher {
+public:
+    explicit FileWatcher(const std::vector<std::filesystem::path>& paths);
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher(FileWatcher&& other) noexcept;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    FileWatcher& operator=(FileWatcher&& other) noexcept;
+    ~FileWatcher();
+
+    // Returns true if any of the files was written since the previous call, never blocks
+    [[nodiscard]] bool poll();
+
+private:
+    struct Data;
+    std::unique_ptr<Data> d;
+};
+
 template <typename T>
 class tmx::internal::DPointer {
 public:
@@ -154,11 +419,16 @@ public:
     [[nodiscard]] const Properties& classValue() const;
 
 private:
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
+
     struct Data;
     internal::DPointer<Data> d;
 };
 
 class tmx::Properties {
+    friend class PropertyValue;
+
 public:
     __TMXPP_CLASS_HEADER_DEF__(Properties)
 
@@ -167,10 +437,15 @@ public:
     [[nodiscard]] const std::map<std::string, PropertyValue>& properties() const;
 
 protected:
-    void parse(tinyxml2::XMLElement* root);
+    // Properties not set here are looked up in base, which is shared rather than copied
+    void inheritProperties(std::shared_ptr<const Properties> base);
+    void parse(internal::Element& root);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
 private:
-    void parseProperty(tinyxml2::XMLElement* property);
+    void parseProperty(internal::Element& property);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -183,14 +458,42 @@ public:
     enum class StaggerAxis : unsigned char { X_AXIS, Y_AXIS };
     enum class StaggerIndex : unsigned char { EVEN, ODD };
 
-    __TMXPP_CLASS_HEADER_DEF__(Map)
-
-    void parseFromData(const std::string& data);
-    void parseFromFile(const std::filesystem::path& path, const LoaderType& loader = nullptr);
-
-    [[nodiscard]] std::string version() const;
-    [[nodiscard]] std::string tiledVersion() const;
-    [[nodiscard]] std::string className() const;
+    Map();
+    // Flattened layers are rebuilt for copies, they point into layers of the map they belong to
+    Map(const Map& other);
+    Map(Map&& other) noexcept;
+    Map& operator=(const Map& other);
+    Map& operator=(Map&& other) noexcept;
+    ~Map();
+
+    void parseFromData(const std::string& data, const ParseOptions& options = {});
+    void parseFromData(const Buffer& data, const ParseOptions& options = {});
+    void parseFromFile(
+        const std::filesystem::path& path, const LoaderType& loader = nullptr, const ParseOptions& options = {});
+
+    [[nodiscard]] static std::future<Map> parseFromFileAsync(
+        std::filesystem::path path, LoaderType loader = nullptr, ParseOptions options = {});
+
+    // Baked maps are a compact binary snapshot of an already parsed map with external tilesets resolved.
+    // When loaded from a buffer that has an owner (e.g. a memory mapped file), tile data is used in place
+    void loadBaked(const std::filesystem::path& path, const LoaderType& loader = nullptr);
+    void loadBakedFromData(const Buffer& data);
+    [[nodiscard]] std::string bake() const;
+    void bakeToFile(const std::filesystem::path& path) const;
+
+    // Writes the map as TMX. External tilesets are referenced by their source, paths are written as they were read
+    [[nodiscard]] std::string saveToData(const SaveOptions& options = {}) const;
+    void saveToFile(const std::filesystem::path& path, const SaveOptions& options = {}) const;
+
+    // Parses the file the map was loaded from again with the same loader and options, except progress, stats and
+    // scope callbacks. Tile data and external tilesets that didn't change are reused without decoding them again
+    MapChanges reload();
+    // File the map was loaded from followed by its external tilesets and object templates
+    [[nodiscard]] std::vector<std::filesystem::path> sourceFiles() const;
+
+    [[nodiscard]] const std::string& version() const;
+    [[nodiscard]] const std::string& tiledVersion() const;
+    [[nodiscard]] const std::string& className() const;
     [[nodiscard]] Orientation orientation() const;
     [[nodiscard]] RenderOrder renderOrder() const;
     [[nodiscard]] int compressionLevel() const;
@@ -206,12 +509,32 @@ public:
     [[nodiscard]] bool infinite() const;
 
     [[nodiscard]] const std::vector<Tileset>& tilesets() const;
+    // Top level layers, groups contain the rest
     [[nodiscard]] const std::vector<Layer>& layers() const;
+    // All layers except groups in drawing order, computed once after loading so renderers don't have to walk the
+    // group tree every frame. Pointers refer to layers of this map
+    [[nodiscard]] const std::vector<FlatLayer>& flatLayers() const;
+    // Distinct image files of tilesets, tiles and image layers, Image::handle() is an index into it. Paths are
+    // relative to the working directory like the map path, so an image shared by tilesets in different directories
+    // is listed once
+    [[nodiscard]] const std::vector<std::filesystem::path>& images() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
-    void parseTilesets(tinyxml2::XMLElement* root);
-    void parseLayers(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root);
+    void parseTileset(internal::Element& element);
+    void parseLayer(internal::Element& element, std::vector<Layer>& layers);
+    void flatten();
+    [[nodiscard]] int registerImage(const Image& image, const std::filesystem::path& directory);
+    [[nodiscard]] const TileLayer* previousTileLayer(int id) const;
+    [[nodiscard]] MapChanges changesSince(const Map& previous) const;
+    void serializeAttributes(internal::BinaryWriter& writer) const;
+    [[nodiscard]] bool acceptLayer(const internal::Element& element, LayerType type) const;
+    void parseFromCache(const std::filesystem::path& path, const LoaderType& loader, const ParseOptions& options);
+    void save(internal::XmlWriter& writer, const SaveOptions& options, const std::vector<std::string>& layerData) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
+    void checkCancelled() const;
+    void reportProgress(ParseProgress::Stage stage, int index, int count, std::size_t position) const;
 
     struct Data;
     internal::DPointer<Data> d;
@@ -240,13 +563,16 @@ public:
 
     __TMXPP_CLASS_HEADER_DEF__(Tileset)
 
-    void parseFromData(const std::string& data);
-    void parseFromFile(const std::filesystem::path& path, const LoaderType& loader = nullptr);
+    // Only backend is used from options
+    void parseFromData(const std::string& data, const ParseOptions& options = {});
+    void parseFromData(const Buffer& data, const ParseOptions& options = {});
+    void parseFromFile(
+        const std::filesystem::path& path, const LoaderType& loader = nullptr, const ParseOptions& options = {});
 
     [[nodiscard]] int firstGID() const;
-    [[nodiscard]] std::string source() const;
-    [[nodiscard]] std::string name() const;
-    [[nodiscard]] std::string className() const;
+    [[nodiscard]] const std::string& source() const;
+    [[nodiscard]] const std::string& name() const;
+    [[nodiscard]] const std::string& className() const;
     [[nodiscard]] int tileWidth() const;
     [[nodiscard]] int tileHeight() const;
     [[nodiscard]] int spacing() const;
@@ -266,8 +592,14 @@ public:
     [[nodiscard]] const std::vector<Tile>& tiles() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
-    void parseTiles(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root, const ParseOptions& options);
+    void parseTile(internal::Element& element, const ParseOptions& options);
+    void loadSource(const std::filesystem::path& path, const LoaderType& loader, const ParseOptions& options,
+        const std::vector<Tileset>& previous);
+    void registerImages(const internal::ImageRegistry& registry);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -285,18 +617,22 @@ public:
     __TMXPP_CLASS_HEADER_DEF__(Tile)
 
     [[nodiscard]] int id() const;
-    [[nodiscard]] std::string className() const;
+    [[nodiscard]] const std::string& className() const;
     [[nodiscard]] IntPoint position() const;
     [[nodiscard]] int width() const;
     [[nodiscard]] int height() const;
 
-    [[nodiscard]] Image image() const;
+    [[nodiscard]] const Image& image() const;
     [[nodiscard]] const ObjectGroup& objectGroup() const;
     [[nodiscard]] const std::vector<AnimationFrame>& animation() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
-    void parseAnimation(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root, const ParseOptions& options);
+    void parseAnimation(internal::Element& root);
+    void registerImages(const internal::ImageRegistry& registry);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -317,9 +653,21 @@ public:
     [[nodiscard]] Color transparentColor() const;
     [[nodiscard]] int width() const;
     [[nodiscard]] int height() const;
+    // Index in Map::images(), stable for the lifetime of the map. -1 for images without a source and for images
+    // of tilesets not loaded as part of a map
+    [[nodiscard]] int handle() const;
+    // Contents of an embedded image as stored in the map, after base64 decoding and decompression. Copies of the
+    // image share the buffer, baked maps reference it in place. Empty for external images
+    [[nodiscard]] const std::string& format() const;
+    [[nodiscard]] std::span<const std::byte> data() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root);
+    void parseData(internal::Element& element);
+    void setHandle(int handle);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -339,7 +687,10 @@ public:
     [[nodiscard]] Point parallaxFactor() const;
 
 protected:
-    void parse(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
 private:
     struct Data;
@@ -348,11 +699,15 @@ private:
 
 class tmx::TileLayer : public internal::AbstractLayer {
     friend class Map;
+    friend class GroupLayer;
+    friend class Image;
 
 public:
     __TMXPP_CLASS_HEADER_DEF__(TileLayer)
 
     [[nodiscard]] const std::vector<std::vector<unsigned int>>& data() const;
+    // Raw GIDs with flip flags, row by row
+    [[nodiscard]] std::span<const std::uint32_t> cells() const;
     [[nodiscard]] int at(int x, int y) const;
     [[nodiscard]] bool flipHorizontal(int x, int y) const;
     [[nodiscard]] bool flipVertical(int x, int y) const;
@@ -361,24 +716,44 @@ public:
 
     [[nodiscard]] int width() const;
     [[nodiscard]] int height() const;
-    [[nodiscard]] std::string encoding() const;
-    [[nodiscard]] std::string compression() const;
+    [[nodiscard]] const std::string& encoding() const;
+    [[nodiscard]] const std::string& compression() const;
+
+    // Decodes data kept encoded by ParseOptions::lazyTileData, accessors do it implicitly on first use.
+    // Thread-safe, copies of the layer share decoded data
+    void ensureDecoded() const;
+
+    // Compact binary patch that turns base into this layer: changed attributes and runs of changed cells
+    [[nodiscard]] std::string diff(const TileLayer& base) const;
+    // Applies a patch made by diff() to a layer equal to its base. Cells are modified in place unless they are
+    // shared with copies of the layer or memory mapped from a baked map
+    void applyPatch(std::string_view patch);
 
 private:
-    void parse(tinyxml2::XMLElement* root);
-    void parseData(tinyxml2::XMLElement* root);
-    void parseCSVData(const std::string& str);
+    void parse(internal::Element& root, const ParseOptions& options, const TileLayer* previous = nullptr);
+    void parseData(internal::Element& root, bool lazy, const TileLayer* previous);
+    void decode(std::string_view str) const;
+    void parseCSVData(std::string_view str, std::uint32_t* cells) const;
     static std::string decompressData(std::string& str, const std::string& compression);
-    void parseBase64Data(const std::string& str);
+    static std::string compressData(std::string_view str, const SaveOptions& options);
+    [[nodiscard]] std::string encode(const SaveOptions& options) const;
+    void save(internal::XmlWriter& writer, const SaveOptions& options, std::string_view data) const;
+    void parseBase64Data(std::string_view str, std::uint32_t* cells) const;
+    [[nodiscard]] std::uint32_t cell(int x, int y) const;
+    void setCells(const std::uint32_t* cells, std::shared_ptr<const void> owner);
+    [[nodiscard]] std::vector<MapChanges::Rect> changedRects(const TileLayer& previous) const;
+    void serializeAttributes(internal::BinaryWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
     void checkBounds(int x, int y) const;
 
     struct Data;
     internal::DPointer<Data> d;
 };
 
-// TODO: test this
 class tmx::ImageLayer : public internal::AbstractLayer {
     friend class Map;
+    friend class GroupLayer;
 
 public:
     __TMXPP_CLASS_HEADER_DEF__(ImageLayer)
@@ -388,7 +763,11 @@ public:
     [[nodiscard]] bool repeatY() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root, const ParseOptions& options);
+    void registerImages(const internal::ImageRegistry& registry);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -396,6 +775,7 @@ private:
 
 class tmx::ObjectGroup : public internal::AbstractLayer {
     friend class Map;
+    friend class GroupLayer;
     friend class Tile;
 
 public:
@@ -407,8 +787,40 @@ public:
     [[nodiscard]] DrawOrder drawOrder() const;
     [[nodiscard]] const std::vector<Object>& objects() const;
 
+    // Compact binary patch that turns base into this group: changed attributes, objects added, modified or
+    // removed, matched by id, and the new order of objects if it changed
+    [[nodiscard]] std::string diff(const ObjectGroup& base) const;
+    // Applies a patch made by diff() to a group equal to its base
+    void applyPatch(std::string_view patch);
+
+private:
+    void parse(internal::Element& root, const ParseOptions& options,
+        const internal::TemplateContext* templates = nullptr);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
+
+    struct Data;
+    internal::DPointer<Data> d;
+};
+
+class tmx::GroupLayer : public internal::AbstractLayer {
+    friend class Map;
+
+public:
+    __TMXPP_CLASS_HEADER_DEF__(GroupLayer)
+
+    [[nodiscard]] const std::vector<Layer>& layers() const;
+
 private:
-    void parse(tinyxml2::XMLElement* root);
+    using ParseLayer = std::function<void(internal::Element& element, std::vector<Layer>& layers)>;
+
+    void parse(internal::Element& root, const ParseOptions& options, const ParseLayer& parseLayer);
+    // Layer lists of maps and groups, layerData holds encoded data of tile layers in flattened order
+    static void saveLayers(internal::XmlWriter& writer, const std::vector<Layer>& layers, const SaveOptions& options,
+        const std::vector<std::string>& layerData, std::size_t& next);
+    static void serializeLayers(internal::BinaryWriter& writer, const std::vector<Layer>& layers);
+    static void deserializeLayers(internal::BinaryReader& reader, std::vector<Layer>& layers, int depth = 0);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -423,13 +835,15 @@ public:
     __TMXPP_CLASS_HEADER_DEF__(Object)
 
     [[nodiscard]] int id() const;
-    [[nodiscard]] std::string name() const;
-    [[nodiscard]] std::string className() const;
+    [[nodiscard]] const std::string& name() const;
+    [[nodiscard]] const std::string& className() const;
     [[nodiscard]] Point position() const;
     [[nodiscard]] Point size() const;
     [[nodiscard]] double rotation() const;
     [[nodiscard]] int gid() const;
     [[nodiscard]] bool visible() const;
+    // Template the object is instantiated from as written in the map, empty if it has none
+    [[nodiscard]] const std::string& templateSource() const;
 
     [[nodiscard]] Type type() const;
     [[nodiscard]] Ellipse ellipse() const;
@@ -439,13 +853,22 @@ public:
     [[nodiscard]] const Text& text() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
-    static std::vector<Point> parsePoints(const std::string& str);
+    void parse(internal::Element& root, const ParseOptions& options,
+        const internal::TemplateContext* templates = nullptr);
+    static std::shared_ptr<const internal::ObjectTemplate> loadTemplate(
+        const internal::TemplateContext& templates, std::string_view source, const ParseOptions& options);
+    void save(internal::XmlWriter& writer) const;
+    static std::vector<Point> parsePoints(std::string_view str);
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
     void ensureType(Type type) const;
     static std::string typeName(Type type);
 
     struct Data;
     internal::DPointer<Data> d;
+
+    // Data of the instance or of its template, depending on whether the instance overrides the field
+    [[nodiscard]] const Data& fieldSource(unsigned int field) const;
 };
 
 // TODO: test this
@@ -458,8 +881,8 @@ public:
     enum class HAlign : uint8_t { LEFT, CENTER, RIGHT, JUSTIFY };
     enum class VAlign : uint8_t { TOP, CENTER, BOTTOM };
 
-    [[nodiscard]] std::string text() const; // TODO: return const reference here?
-    [[nodiscard]] std::string fontFamily() const;
+    [[nodiscard]] const std::string& text() const;
+    [[nodiscard]] const std::string& fontFamily() const;
     [[nodiscard]] int pixelSize() const;
     [[nodiscard]] bool wrap() const;
     [[nodiscard]] Color color() const;
@@ -472,7 +895,10 @@ public:
     [[nodiscard]] VAlign valign() const;
 
 private:
-    void parse(tinyxml2::XMLElement* root);
+    void parse(internal::Element& root);
+    void save(internal::XmlWriter& writer) const;
+    void serialize(internal::BinaryWriter& writer) const;
+    void deserialize(internal::BinaryReader& reader);
 
     struct Data;
     internal::DPointer<Data> d;
@@ -480,17 +906,22 @@ private:
 
 class tmx::Layer {
 public:
-    enum class Type : uint8_t { EMPTY, TILE, IMAGE, OBJECT };
+    using Type = LayerType;
 
     __TMXPP_CLASS_HEADER_DEF__(Layer)
 
     explicit Layer(TileLayer&& layer);
+    explicit Layer(ImageLayer&& layer);
     explicit Layer(ObjectGroup&& layer);
+    explicit Layer(GroupLayer&& layer);
 
     [[nodiscard]] Type type() const;
     [[nodiscard]] const TileLayer& tileLayer() const;
     [[nodiscard]] const ImageLayer& imageLayer() const;
     [[nodiscard]] const ObjectGroup& objectGroup() const;
+    [[nodiscard]] const GroupLayer& groupLayer() const;
+    // Attributes shared by all layer types: id, name, opacity, offset and so on
+    [[nodiscard]] const internal::AbstractLayer& abstractLayer() const;
 
 private:
     void ensureType(Type type) const;
@@ -500,4 +931,268 @@ private:
     internal::DPointer<Data> d;
 };
 
+struct tmx::AtlasOptions {
+    // Largest size of a page, tiles that do not fit on one page go on the next one
+    int maxWidth = 4096;
+    int maxHeight = 4096;
+    // Empty pixels on every side of a tile, keeps filtering from sampling neighbouring tiles
+    int padding = 1;
+};
+
+// Placement of the tiles of collection-of-images tilesets in a single texture or texture array, where every page
+// is an array layer. Built with a skyline packer, tallest tiles first
+struct tmx::AtlasLayout {
+    struct Slot {
+        // Index of the tileset in the list given to pack() and local id of the tile
+        int tileset = 0;
+        int id = 0;
+        int page = 0;
+        // Area of the page the tile is copied to
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        // Position of the copied area in the tile's image, see Tile::position()
+        IntPoint source;
+    };
+
+    // Size shared by all pages
+    int width = 0;
+    int height = 0;
+    int pages = 0;
+    std::vector<Slot> slots;
+    // Slot index by local tile id for every tileset, -1 for ids without an image of their own
+    std::vector<std::vector<int>> localSlots;
+    // Slot index by GID, -1 for GIDs not packed. Covers GIDs up to the largest packed one
+    std::vector<int> gidSlots;
+
+    // Slot of a GID that may carry flip flags, -1 if it is not packed
+    [[nodiscard]] int slot(std::uint32_t gid) const;
+
+    // Packs tiles that have their own image, tiles of tilesets with a single image are skipped. Tiles use their
+    // sub-rectangle when set and the whole image otherwise, images must have their size set
+    static AtlasLayout pack(std::span<const Tileset> tilesets, const AtlasOptions& options = {});
+};
+
+// Cells of a tile layer that can be seen through a camera, see TileGrid::visibleCells()
+struct tmx::VisibleCells {
+    // Cells x, x + step, ... before end in row y. Rows come in order, step is 2 on maps staggered along the x axis
+    // where a row is split into columns that are not shifted followed by shifted ones, the order Tiled draws them in
+    struct Span {
+        int y = 0;
+        int x = 0;
+        int end = 0;
+        int step = 1;
+    };
+
+    // Index in Map::flatLayers()
+    int layer = 0;
+    // Where the layer is drawn relative to the map, combined offsets of the layer and its groups plus parallax
+    Point offset;
+    std::vector<Span> spans;
+};
+
+// Conversions between tile and pixel coordinates for every orientation, following Tiled's renderers. Batches take
+// coordinates as separate x and y arrays and every orientation has its own loop without per coordinate branches,
+// so compilers vectorize them. Pixels are relative to the top left corner of the map
+class tmx::TileGrid {
+public:
+    explicit TileGrid(const Map& map);
+
+    [[nodiscard]] Map::Orientation orientation() const;
+    // Tiles sharing an edge with a tile, 6 on hexagonal maps and 4 otherwise
+    [[nodiscard]] int neighborCount() const;
+
+    // Size of the bounding box of a tile, tiles of staggered and hexagonal maps are rounded down to even sizes
+    [[nodiscard]] Point tileSize() const;
+    // Top left corner of the bounding box of a tile
+    [[nodiscard]] Point tileToPixel(IntPoint tile) const;
+    // Tile containing a pixel, may be outside of the map
+    [[nodiscard]] IntPoint pixelToTile(Point pixel) const;
+
+    // Arrays of a batch must have the same size
+    void tileToPixel(
+        std::span<const int> x, std::span<const int> y, std::span<float> pixelX, std::span<float> pixelY) const;
+    void pixelToTile(
+        std::span<const float> x, std::span<const float> y, std::span<int> tileX, std::span<int> tileY) const;
+    // Output arrays hold neighborCount() entries per tile, neighbor k of tile i goes to index k * x.size() + i.
+    // Orthogonal and isometric: left, right, up, down in tile coordinates. Staggered: top left, top right, bottom
+    // left, bottom right. Hexagonal: those four followed by the two tiles along the axis that is not staggered,
+    // left and right or top and bottom
+    void neighbors(
+        std::span<const int> x, std::span<const int> y, std::span<int> neighborX, std::span<int> neighborY) const;
+
+    // Cells of the visible tile layers of map that can be seen through a camera rectangle given in map pixels.
+    // Layer offsets, parallax, tileset tile offsets and tiles larger than the grid are taken into account, so
+    // drawing just these cells leaves no gaps. Map must be the one the grid was made for. Result is refilled,
+    // passing the same vector every frame reuses its memory
+    void visibleCells(const Map& map, Point position, Point size, std::vector<VisibleCells>& result) const;
+
+private:
+    template <Map::Orientation orientation, bool alongX>
+    void tileToPixel(const int* x, const int* y, float* pixelX, float* pixelY, std::size_t count) const;
+    template <Map::Orientation orientation, bool alongX>
+    void pixelToTile(const float* x, const float* y, int* tileX, int* tileY, std::size_t count) const;
+    template <bool alongX>
+    void neighbors(const int* x, const int* y, int* neighborX, int* neighborY, std::size_t count,
+        const IntPoint* offset) const;
+
+    Map::Orientation gridOrientation = Map::Orientation::ORTHOGONAL;
+    bool staggerX = false;
+    // 1 if even rows or columns are shifted
+    int staggerEven = 0;
+    float tileWidth = 0;
+    float tileHeight = 0;
+    float mapHeight = 0;
+    // Hexagonal and staggered layout in the terms used by Tiled, side lengths are 0 on the axis that is not
+    // staggered and on staggered maps
+    float sideLengthX = 0;
+    float sideLengthY = 0;
+    float columnWidth = 0;
+    float rowHeight = 0;
+    // How far drawn tiles may reach out of their cell's bounding box
+    float reachLeft = 0;
+    float reachRight = 0;
+    float reachUp = 0;
+    float reachDown = 0;
+    Point parallaxOrigin;
+};
+
+struct tmx::BatchOptions {
+    // Width and height of a chunk in cells
+    int chunkSize = 32;
+    // Dirty chunks are built in parallel, 0 uses std::thread::hardware_concurrency()
+    unsigned int threads = 0;
+};
+
+// Quads of a tile layer split into square chunks of cells, ready to be uploaded as vertex buffers. GIDs are resolved
+// to tilesets, texture coordinates and flips are computed once per chunk and only chunks marked dirty are built
+// again. Quads are placed like Tiled draws tiles: bottom left aligned with the cell, moved by the tileset's tile
+// offset and sized by the tile or the grid depending on Tileset::tileRenderSize(). Animations are left to the
+// renderer, quads show the first tile. The map must outlive the batches
+class tmx::TileBatches {
+public:
+    struct Vertex {
+        // Pixels relative to the layer, offsets of the layer itself are not applied
+        float x = 0;
+        float y = 0;
+        // Normalized coordinates in the tileset's image, or the tile's own image in collection tilesets
+        float u = 0;
+        float v = 0;
+    };
+
+    // Quads using one texture, the image of a tileset or of a single tile in collection tilesets
+    struct Range {
+        int tileset = 0;
+        // Local id of the tile whose image is used, -1 for the tileset's image
+        int tile = -1;
+        // Quads, each is four vertices
+        std::uint32_t first = 0;
+        std::uint32_t count = 0;
+    };
+
+    struct Chunk {
+        // Cells covered by the chunk, clipped to the layer
+        MapChanges::Rect cells;
+        // Top left, top right, bottom right and bottom left corner of every quad, grouped by range
+        std::vector<Vertex> vertices;
+        std::vector<Range> ranges;
+        // Incremented every time the chunk is built, tells which vertex buffers need uploading again
+        std::uint32_t version = 0;
+    };
+
+    TileBatches(const Map& map, const TileLayer& layer, const BatchOptions& options = {});
+    TileBatches(const TileBatches&) = delete;
+    TileBatches(TileBatches&& other) noexcept;
+    TileBatches& operator=(const TileBatches&) = delete;
+    TileBatches& operator=(TileBatches&& other) noexcept;
+    ~TileBatches();
+
+    // Row by row, columns() chunks per row
+    [[nodiscard]] const std::vector<Chunk>& chunks() const;
+    [[nodiscard]] int columns() const;
+    [[nodiscard]] int rows() const;
+
+    // Marks chunks overlapping an area in cells, such as MapChanges::LayerChange::dirtyRects
+    void markDirty(const MapChanges::Rect& cells);
+    // Needed when tilesets of the map changed
+    void markAllDirty();
+    // Builds dirty chunks from the current cells of layer and returns how many were built. A layer of another size
+    // than before rebuilds all chunks
+    int update(const TileLayer& layer);
+
+private:
+    void buildChunk(const TileLayer& layer, Chunk& chunk) const;
+
+    struct Data;
+    std::unique_ptr<Data> d;
+};
+
+// One bit per cell of a tile layer, set for solid cells. Rows start on a new word, bits past the width of the layer are
+// always clear. Grids of several layers of the same size can be combined with bitwise operators
+class tmx::CollisionGrid {
+public:
+    enum class Merge : unsigned char { ROWS, BEST };
+
+    CollisionGrid() = default;
+    CollisionGrid(int width, int height);
+
+    // One flag per GID, set where solid holds for the tile. solid is called once for every tile of the map's tilesets
+    // that has an entry in Tileset::tiles(), other tiles are never solid
+    [[nodiscard]] static std::vector<std::uint8_t> solidTiles(const Map& map, const TilePredicate& solid);
+    // Pass the flags of solidTiles() when building grids of several layers to evaluate the predicate only once
+    [[nodiscard]] static CollisionGrid fromLayer(const TileLayer& layer, std::span<const std::uint8_t> solidTiles);
+    [[nodiscard]] static CollisionGrid fromLayer(const Map& map, const TileLayer& layer, const TilePredicate& solid);
+
+    // Tiles with a property of that name. Bool properties must also be true
+    [[nodiscard]] static TilePredicate withProperty(const std::string& name);
+    // Tiles whose property of that name equals value, which is read as the type of the property the same way as in
+    // TMX files
+    [[nodiscard]] static TilePredicate withProperty(const std::string& name, const std::string& value);
+    // Tiles with collision shapes
+    [[nodiscard]] static TilePredicate withCollisionObjects();
+
+    [[nodiscard]] int width() const;
+    [[nodiscard]] int height() const;
+    [[nodiscard]] int wordsPerRow() const;
+    // Bit x % 64 of word x / 64 of a row is cell x
+    [[nodiscard]] std::span<const std::uint64_t> words() const;
+    [[nodiscard]] std::span<const std::uint64_t> row(int y) const;
+    // Cells outside of the grid are not solid
+    [[nodiscard]] bool at(int x, int y) const;
+    void set(int x, int y, bool solid);
+    [[nodiscard]] int count() const;
+
+    // Rectangles in cells that cover solid cells without overlapping, for static physics bodies. ROWS extends each
+    // run of solid cells of a row down while the next rows have a run with the same ends. BEST also merges columns
+    // first and keeps whichever gives fewer rectangles for each region of connected cells
+    [[nodiscard]] std::vector<MapChanges::Rect> rectangles(Merge merge = Merge::ROWS) const;
+    // Closed outlines of regions of solid cells in cell coordinates, one point per corner, for chain shapes. Outer
+    // outlines go clockwise with y pointing down, outlines of holes counterclockwise. Regions touching only at a
+    // corner have outlines of their own
+    [[nodiscard]] std::vector<std::vector<IntPoint>> outlines() const;
+
+    // Grids must have the same size
+    CollisionGrid& operator|=(const CollisionGrid& other);
+    CollisionGrid& operator&=(const CollisionGrid& other);
+    CollisionGrid& operator^=(const CollisionGrid& other);
+    // Clears cells solid in other, such as bridges over water
+    CollisionGrid& subtract(const CollisionGrid& other);
+    friend CollisionGrid operator|(CollisionGrid first, const CollisionGrid& second) { return first |= second; }
+    friend CollisionGrid operator&(CollisionGrid first, const CollisionGrid& second) { return first &= second; }
+    friend CollisionGrid operator^(CollisionGrid first, const CollisionGrid& second) { return first ^= second; }
+    bool operator==(const CollisionGrid& other) const = default;
+
+private:
+    template <typename Operation>
+    CollisionGrid& combine(const CollisionGrid& other, Operation operation);
+    [[nodiscard]] int nextCell(int x, int y, bool solid) const;
+    [[nodiscard]] CollisionGrid transposed() const;
+
+    int gridWidth = 0;
+    int gridHeight = 0;
+    int rowWords = 0;
+    std::vector<std::uint64_t> bits;
+};
+
 #endif // TMXPP_HPP
@@ -1,4 +1,6 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
 #include <string>
 #include <tmxpp.hpp>
 
@@ -24,30 +26,54 @@ tmx::Color tmx::internal::AbstractLayer::tintColor() const { return d->tintColor
 tmx::Point tmx::internal::AbstractLayer::offset() const { return d->offset; }
 tmx::Point tmx::internal::AbstractLayer::parallaxFactor() const { return d->parallaxFactor; }
 
-void tmx::internal::AbstractLayer::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing layer root element");
+void tmx::internal::AbstractLayer::parse(Element& root) {
+    root.query("name", d->name);
+    if(!root.query("class", d->className)) {
+        root.query("className", d->className);
     }
+    root.query("id", d->id);
+    root.query("opacity", d->opacity);
+    root.query("visible", d->visible);
+    root.query("tintcolor", d->tintColor);
+    root.query("offsetx", d->offset.x);
+    root.query("offsety", d->offset.y);
+    root.query("parallaxx", d->parallaxFactor.x);
+    root.query("parallaxy", d->parallaxFactor.y);
+}
 
-    if(root->Attribute("name") != nullptr) {
-        d->name = root->Attribute("name");
-    }
-    if(root->Attribute("className") != nullptr) {
-        d->className = root->Attribute("className");
-    }
-
-    root->QueryIntAttribute("id", &d->id);
-    root->QueryDoubleAttribute("opacity", &d->opacity);
-    root->QueryBoolAttribute("visible", &d->visible);
-
-    if(root->Attribute("tintcolor") != nullptr) {
-        d->tintColor = colorFromString(root->Attribute("tintcolor"));
-    }
+void tmx::internal::AbstractLayer::save(XmlWriter& writer) const {
+    writer.attribute("id", d->id);
+    writer.attribute("name", d->name, std::string());
+    writer.attribute("class", d->className, std::string());
+    writer.attribute("opacity", d->opacity, 1.0);
+    writer.attribute("visible", d->visible, true);
+    writer.attribute("tintcolor", d->tintColor, Color());
+    writer.attribute("offsetx", d->offset.x, 0.0);
+    writer.attribute("offsety", d->offset.y, 0.0);
+    writer.attribute("parallaxx", d->parallaxFactor.x, 1.0);
+    writer.attribute("parallaxy", d->parallaxFactor.y, 1.0);
+}
 
-    root->QueryDoubleAttribute("offsetx", &d->offset.x);
-    root->QueryDoubleAttribute("offsety", &d->offset.y);
-    root->QueryDoubleAttribute("parallaxx", &d->parallaxFactor.x);
-    root->QueryDoubleAttribute("parallaxy", &d->parallaxFactor.y);
+void tmx::internal::AbstractLayer::serialize(BinaryWriter& writer) const {
+    writer.write(d->id);
+    writer.write(d->name);
+    writer.write(d->className);
+    writer.write(d->opacity);
+    writer.write(d->visible);
+    writer.write(d->tintColor);
+    writer.write(d->offset);
+    writer.write(d->parallaxFactor);
+    Properties::serialize(writer);
+}
 
-    Properties::parse(root->FirstChildElement("properties"));
+void tmx::internal::AbstractLayer::deserialize(BinaryReader& reader) {
+    reader.read(d->id);
+    reader.read(d->name);
+    reader.read(d->className);
+    reader.read(d->opacity);
+    reader.read(d->visible);
+    reader.read(d->tintColor);
+    reader.read(d->offset);
+    reader.read(d->parallaxFactor);
+    Properties::deserialize(reader);
 }
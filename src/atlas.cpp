@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <tmxpp.hpp>
+
+namespace {
+    // Top edge of everything placed on a page as segments sorted by x. A rect goes where its own top edge ends up
+    // lowest, leftmost on ties
+    class Skyline {
+    public:
+        Skyline(int width, int height) : width(width), height(height), segments({{.x = 0, .y = 0, .width = width}}) {}
+
+        bool insert(int rectWidth, int rectHeight, tmx::IntPoint& position) {
+            std::size_t best = segments.size();
+            int bestTop = std::numeric_limits<int>::max();
+            for(std::size_t i = 0; i < segments.size() && segments[i].x + rectWidth <= width; i++) {
+                int y = 0;
+                for(std::size_t j = i; j < segments.size() && segments[j].x < segments[i].x + rectWidth; j++) {
+                    y = std::max(y, segments[j].y);
+                }
+                if(y + rectHeight <= height && y + rectHeight < bestTop) {
+                    best = i;
+                    bestTop = y + rectHeight;
+                    position = {.x = segments[i].x, .y = y};
+                }
+            }
+            if(best == segments.size()) {
+                return false;
+            }
+
+            // Segments under the rect are replaced by its top edge, one partially under it is shortened
+            int right = position.x + rectWidth;
+            std::size_t end = best;
+            while(end < segments.size() && segments[end].x + segments[end].width <= right) {
+                end++;
+            }
+            if(end < segments.size() && segments[end].x < right) {
+                segments[end].width -= right - segments[end].x;
+                segments[end].x = right;
+            }
+            segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(best),
+                segments.begin() + static_cast<std::ptrdiff_t>(end));
+            segments.insert(segments.begin() + static_cast<std::ptrdiff_t>(best),
+                {.x = position.x, .y = bestTop, .width = rectWidth});
+
+            for(std::size_t i = 0; i + 1 < segments.size();) {
+                if(segments[i].y == segments[i + 1].y) {
+                    segments[i].width += segments[i + 1].width;
+                    segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+                } else {
+                    i++;
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct Segment {
+            int x = 0;
+            int y = 0;
+            int width = 0;
+        };
+
+        int width;
+        int height;
+        std::vector<Segment> segments;
+    };
+} // namespace
+
+int tmx::AtlasLayout::slot(std::uint32_t gid) const {
+    gid &= 0x0FFFFFFFU;
+    return gid < gidSlots.size() ? gidSlots[gid] : -1;
+}
+
+tmx::AtlasLayout tmx::AtlasLayout::pack(std::span<const Tileset> tilesets, const AtlasOptions& options) {
+    AtlasLayout layout;
+    layout.localSlots.resize(tilesets.size());
+    int padding = 2 * options.padding;
+    std::int64_t area = 0;
+    int widest = 0;
+    for(std::size_t i = 0; i < tilesets.size(); i++) {
+        const Tileset& tileset = tilesets[i];
+        for(const Tile& tile : tileset.tiles()) {
+            const Image& image = tile.image();
+            if(image.type() == Image::Type::EMPTY) {
+                continue;
+            }
+            int width = tile.width() > 0 ? tile.width() : image.width();
+            int height = tile.height() > 0 ? tile.height() : image.height();
+            if(width <= 0 || height <= 0) {
+                throw Exception(
+                    "Size of the image of tile " + std::to_string(tile.id()) + " of " + tileset.name() + " is unknown");
+            }
+            if(width + padding > options.maxWidth || height + padding > options.maxHeight) {
+                throw Exception("Tile " + std::to_string(tile.id()) + " of " + tileset.name() +
+                                " is larger than an atlas page");
+            }
+
+            std::vector<int>& local = layout.localSlots[i];
+            if(static_cast<std::size_t>(tile.id()) >= local.size()) {
+                local.resize(static_cast<std::size_t>(tile.id()) + 1, -1);
+            }
+            local[tile.id()] = static_cast<int>(layout.slots.size());
+            layout.slots.push_back({.tileset = static_cast<int>(i),
+                .id = tile.id(),
+                .width = width,
+                .height = height,
+                .source = tile.position()});
+            area += static_cast<std::int64_t>(width + padding) * (height + padding);
+            widest = std::max(widest, width + padding);
+        }
+    }
+    if(layout.slots.empty()) {
+        return layout;
+    }
+
+    // Pages are as wide as the smallest power of two square that could hold every tile, limited by the maximum
+    // width. Their height is the one used by the tiles
+    int pageWidth = 1;
+    while(pageWidth < widest || static_cast<std::int64_t>(pageWidth) * pageWidth < area) {
+        pageWidth *= 2;
+    }
+    pageWidth = std::min(pageWidth, options.maxWidth);
+
+    std::vector<std::size_t> order(layout.slots.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&layout](std::size_t a, std::size_t b) {
+        const Slot& first = layout.slots[a];
+        const Slot& second = layout.slots[b];
+        return first.height != second.height ? first.height > second.height : first.width > second.width;
+    });
+
+    std::vector<Skyline> pages;
+    for(std::size_t index : order) {
+        Slot& slot = layout.slots[index];
+        IntPoint position;
+        // Smaller tiles may still fit on earlier pages
+        std::size_t page = 0;
+        while(page < pages.size() && !pages[page].insert(slot.width + padding, slot.height + padding, position)) {
+            page++;
+        }
+        if(page == pages.size()) {
+            pages.emplace_back(pageWidth, options.maxHeight);
+            pages.back().insert(slot.width + padding, slot.height + padding, position);
+        }
+        slot.page = static_cast<int>(page);
+        slot.x = position.x + options.padding;
+        slot.y = position.y + options.padding;
+        layout.width = std::max(layout.width, position.x + slot.width + padding);
+        layout.height = std::max(layout.height, position.y + slot.height + padding);
+    }
+    layout.pages = static_cast<int>(pages.size());
+
+    for(std::size_t i = 0; i < layout.slots.size(); i++) {
+        const Slot& slot = layout.slots[i];
+        auto gid = static_cast<std::size_t>(tilesets[slot.tileset].firstGID() + slot.id);
+        if(gid >= layout.gidSlots.size()) {
+            layout.gidSlots.resize(gid + 1, -1);
+        }
+        layout.gidSlots[gid] = static_cast<int>(i);
+    }
+    return layout;
+}
@@ -0,0 +1,92 @@
+#include "binary.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <tmxpp.hpp>
+
+// Baked map layout: 48-byte header, metadata section, cells section aligned to 16 bytes from the file start.
+// Header fields are little-endian: magic "TMXB", u32 version, u64 metadata offset and size, u64 cells offset
+// and size, u64 reserved
+
+namespace {
+
+constexpr std::string_view bakedMagic = "TMXB";
+// 2: image handles, 3: embedded images, 4: template sources
+constexpr std::uint32_t bakedVersion = 4;
+constexpr std::size_t headerSize = 48;
+
+std::size_t align(std::size_t value) {
+    constexpr std::size_t alignment = tmx::internal::BinaryWriter::cellsAlignment;
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+std::string tmx::Map::bake() const {
+    internal::BinaryWriter writer;
+    serialize(writer);
+    const std::string& metadata = writer.metadataSection();
+    const std::string& cells = writer.cellsSection();
+
+    std::size_t cellsOffset = align(headerSize + metadata.size());
+    internal::BinaryWriter header;
+    for(char c : bakedMagic) {
+        header.write(c);
+    }
+    header.write(bakedVersion);
+    header.write(static_cast<std::uint64_t>(headerSize));
+    header.write(static_cast<std::uint64_t>(metadata.size()));
+    header.write(static_cast<std::uint64_t>(cellsOffset));
+    header.write(static_cast<std::uint64_t>(cells.size()));
+    header.write(static_cast<std::uint64_t>(0));
+
+    std::string result;
+    result.reserve(cellsOffset + cells.size());
+    result += header.metadataSection();
+    result += metadata;
+    result.resize(cellsOffset, '\0');
+    result += cells;
+    return result;
+}
+
+void tmx::Map::bakeToFile(const std::filesystem::path& path) const {
+    std::string data = bake();
+    std::ofstream file(path, std::ios::binary);
+    if(!file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+        throw Exception("Failed to write file " + path.string());
+    }
+}
+
+void tmx::Map::loadBaked(const std::filesystem::path& path, const LoaderType& loader) {
+    loadBakedFromData(loader != nullptr ? loader(path) : Buffer::fromFile(path));
+}
+
+void tmx::Map::loadBakedFromData(const Buffer& data) {
+    std::string_view bytes = data.view();
+    if(bytes.size() < headerSize) {
+        throw Exception("Baked map is truncated");
+    }
+    if(bytes.substr(0, bakedMagic.size()) != bakedMagic) {
+        throw Exception("Not a baked map");
+    }
+
+    internal::BinaryReader header(bytes.substr(bakedMagic.size(), headerSize - bakedMagic.size()), {}, nullptr);
+    auto version = header.read<std::uint32_t>();
+    if(version != bakedVersion) {
+        throw Exception("Unsupported baked map version " + std::to_string(version));
+    }
+
+    auto metadataOffset = header.read<std::uint64_t>();
+    auto metadataSize = header.read<std::uint64_t>();
+    auto cellsOffset = header.read<std::uint64_t>();
+    auto cellsSize = header.read<std::uint64_t>();
+    if(metadataOffset > bytes.size() || metadataSize > bytes.size() - metadataOffset || cellsOffset > bytes.size() ||
+        cellsSize > bytes.size() - cellsOffset) {
+        throw Exception("Baked map is truncated");
+    }
+
+    internal::BinaryReader reader(
+        bytes.substr(metadataOffset, metadataSize), bytes.substr(cellsOffset, cellsSize), data.owner());
+    deserialize(reader);
+}
@@ -0,0 +1,241 @@
+#ifndef TMXPP_BINARY_HPP
+#define TMXPP_BINARY_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tmxpp.hpp>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Little-endian serialization used by baked maps. Scalars and strings go to the metadata stream, tile cells
+// go to a separate section where every array is aligned so it can be used in place after memory mapping
+
+class tmx::internal::BinaryWriter {
+public:
+    static constexpr std::size_t cellsAlignment = 16;
+
+    template <typename T>
+        requires std::is_integral_v<T> || std::is_enum_v<T>
+    void write(T value) {
+        auto raw = static_cast<std::uint64_t>(value);
+        for(std::size_t i = 0; i < sizeof(T); i++) {
+            metadata += static_cast<char>((raw >> (8 * i)) & 0xFFU);
+        }
+    }
+
+    void write(bool value) { metadata += static_cast<char>(value ? 1 : 0); }
+    void write(float value) { write(std::bit_cast<std::uint32_t>(value)); }
+    void write(double value) { write(std::bit_cast<std::uint64_t>(value)); }
+
+    void write(std::string_view value) {
+        write(static_cast<std::uint32_t>(value.size()));
+        metadata += value;
+    }
+
+    void write(const std::string& value) { write(std::string_view(value)); }
+
+    void write(Point value) {
+        write(value.x);
+        write(value.y);
+    }
+
+    void write(IntPoint value) {
+        write(value.x);
+        write(value.y);
+    }
+
+    void write(Color value) {
+        write(value.r);
+        write(value.g);
+        write(value.b);
+        write(value.a);
+    }
+
+    // LEB128, used by layer patches where most numbers are small
+    void writeVarint(std::uint64_t value) {
+        while(value >= 0x80) {
+            metadata += static_cast<char>((value & 0x7FU) | 0x80U);
+            value >>= 7U;
+        }
+        metadata += static_cast<char>(value);
+    }
+
+    // Appends cells to the aligned section and writes their offset to the metadata
+    void writeCells(std::span<const std::uint32_t> values) {
+        write(static_cast<std::uint64_t>(cells.size()));
+        write(static_cast<std::uint64_t>(values.size()));
+        for(std::uint32_t value : values) {
+            for(std::size_t i = 0; i < 4; i++) {
+                cells += static_cast<char>((value >> (8 * i)) & 0xFFU);
+            }
+        }
+        cells.resize((cells.size() + cellsAlignment - 1) / cellsAlignment * cellsAlignment, '\0');
+    }
+
+    // Byte arrays such as embedded images are kept in the metadata, they need no alignment
+    void writeBlob(std::span<const std::byte> bytes) {
+        write(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+    }
+
+    [[nodiscard]] const std::string& metadataSection() const { return metadata; }
+    [[nodiscard]] const std::string& cellsSection() const { return cells; }
+
+private:
+    std::string metadata;
+    std::string cells;
+};
+
+class tmx::internal::BinaryReader {
+public:
+    // Cells are referenced in place when owner is set and section is suitably aligned, copied otherwise.
+    // Source names the data in error messages
+    BinaryReader(std::string_view metadata, std::string_view cells, std::shared_ptr<const void> owner,
+        std::string_view source = "Baked map")
+        : metadata(metadata), cells(cells), owner(std::move(owner)), source(source) {}
+
+    template <typename T>
+        requires std::is_integral_v<T> || std::is_enum_v<T>
+    void read(T& value) {
+        std::string_view bytes = take(sizeof(T));
+        std::uint64_t raw = 0;
+        for(std::size_t i = 0; i < sizeof(T); i++) {
+            raw |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+        }
+        value = static_cast<T>(raw);
+    }
+
+    void read(bool& value) { value = take(1)[0] != 0; }
+
+    void read(float& value) {
+        std::uint32_t raw = 0;
+        read(raw);
+        value = std::bit_cast<float>(raw);
+    }
+
+    void read(double& value) {
+        std::uint64_t raw = 0;
+        read(raw);
+        value = std::bit_cast<double>(raw);
+    }
+
+    void read(std::string& value) {
+        std::uint32_t size = 0;
+        read(size);
+        value = take(size);
+    }
+
+    void read(Point& value) {
+        read(value.x);
+        read(value.y);
+    }
+
+    void read(IntPoint& value) {
+        read(value.x);
+        read(value.y);
+    }
+
+    void read(Color& value) {
+        read(value.r);
+        read(value.g);
+        read(value.b);
+        read(value.a);
+    }
+
+    template <typename T>
+    [[nodiscard]] T read() {
+        T value{};
+        read(value);
+        return value;
+    }
+
+    std::uint64_t readVarint() {
+        std::uint64_t value = 0;
+        for(unsigned int shift = 0; shift < 64; shift += 7) {
+            auto byte = static_cast<unsigned char>(take(1)[0]);
+            value |= static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+            if((byte & 0x80U) == 0) {
+                return value;
+            }
+        }
+        throw Exception(std::string(source) + " is corrupted");
+    }
+
+    // Reads a count of entries taking at least entrySize bytes each, so corrupted counts can't allocate more than
+    // the remaining data could hold. Count is a varint unless its type is given
+    std::size_t readCount(std::size_t entrySize) { return checkCount(readVarint(), entrySize); }
+
+    template <typename T>
+        requires std::is_integral_v<T>
+    std::size_t readCount(std::size_t entrySize) {
+        return checkCount(read<T>(), entrySize);
+    }
+
+    std::string_view readBytes(std::size_t size) { return take(size); }
+
+    // Returns cells written by BinaryWriter::writeCells and their owner
+    std::pair<const std::uint32_t*, std::shared_ptr<const void>> readCells(std::size_t expectedCount) {
+        auto offset = read<std::uint64_t>();
+        auto count = read<std::uint64_t>();
+        if(count != expectedCount || offset > cells.size() || count > (cells.size() - offset) / 4) {
+            throw Exception(std::string(source) + " is corrupted");
+        }
+
+        const char* data = cells.data() + offset;
+        bool aligned = reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint32_t) == 0;
+        if(owner != nullptr && aligned && std::endian::native == std::endian::little) {
+            return {reinterpret_cast<const std::uint32_t*>(data), owner};
+        }
+
+        auto copy = std::make_shared<std::vector<std::uint32_t>>(count);
+        for(std::size_t i = 0; i < count; i++) {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(data + (4 * i));
+            (*copy)[i] = static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8U) |
+                         (static_cast<std::uint32_t>(bytes[2]) << 16U) | (static_cast<std::uint32_t>(bytes[3]) << 24U);
+        }
+        return {copy->data(), copy};
+    }
+
+    // Returns bytes written by BinaryWriter::writeBlob with their size and owner, in place when owner is set
+    std::tuple<const std::byte*, std::size_t, std::shared_ptr<const void>> readBlob() {
+        std::uint32_t size = 0;
+        read(size);
+        std::string_view bytes = take(size);
+        if(owner != nullptr) {
+            return {reinterpret_cast<const std::byte*>(bytes.data()), bytes.size(), owner};
+        }
+        auto copy = std::make_shared<std::string>(bytes);
+        return {reinterpret_cast<const std::byte*>(copy->data()), copy->size(), copy};
+    }
+
+private:
+    std::size_t checkCount(std::uint64_t count, std::size_t entrySize) const {
+        if(count > metadata.size() / entrySize) {
+            throw Exception(std::string(source) + " is corrupted");
+        }
+        return static_cast<std::size_t>(count);
+    }
+
+    std::string_view take(std::size_t size) {
+        if(size > metadata.size()) {
+            throw Exception(std::string(source) + " is truncated");
+        }
+        std::string_view result = metadata.substr(0, size);
+        metadata.remove_prefix(size);
+        return result;
+    }
+
+    std::string_view metadata;
+    std::string_view cells;
+    std::shared_ptr<const void> owner;
+    std::string_view source;
+};
+
+#endif // TMXPP_BINARY_HPP
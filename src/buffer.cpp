@@ -0,0 +1,22 @@
+#include "mapped_file.hpp"
+#include <memory>
+#include <string>
+#include <tmxpp.hpp>
+#include <utility>
+
+tmx::Buffer::Buffer(std::string data) {
+    auto str = std::make_shared<const std::string>(std::move(data));
+    ptr = str->data();
+    length = str->size();
+    holder = std::move(str);
+}
+
+tmx::Buffer::Buffer(const char* data, std::size_t size) noexcept : ptr(data), length(size) {}
+
+tmx::Buffer::Buffer(const char* data, std::size_t size, std::shared_ptr<const void> owner) noexcept
+    : ptr(data), length(size), holder(std::move(owner)) {}
+
+tmx::Buffer tmx::Buffer::fromFile(const std::filesystem::path& path) {
+    auto file = std::make_shared<const internal::MappedFile>(path);
+    return {file->data(), file->size(), file};
+}
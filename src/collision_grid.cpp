@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include <tmxpp.hpp>
+
+namespace {
+    constexpr std::uint32_t GID_MASK = 0x0FFFFFFFU;
+
+    template <typename T>
+    bool parsedEquals(const std::string& str, T value) {
+        T parsed{};
+        auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), parsed);
+        return error == std::errc() && end == str.data() + str.size() && parsed == value;
+    }
+
+    // Eight bytes that are 0 or 1 to the bits of a byte, first byte in the lowest bit. The multiplication moves byte i
+    // to bit 56 + i without carries
+    std::uint64_t packBytes(const std::uint8_t* bytes) {
+        std::uint64_t eight = 0;
+        if constexpr(std::endian::native == std::endian::little) {
+            std::memcpy(&eight, bytes, 8);
+        } else {
+            for(unsigned int i = 0; i < 8; i++) {
+                eight |= static_cast<std::uint64_t>(bytes[i]) << (i * 8);
+            }
+        }
+        return (eight * 0x0102040810204080U) >> 56U;
+    }
+
+    // Words needed by a grid of the given size, checked before anything is allocated
+    std::size_t gridWords(int width, int height) {
+        if(width < 0 || height < 0) {
+            throw tmx::Exception("Invalid collision grid size");
+        }
+        return static_cast<std::size_t>((width + 63) / 64) * height;
+    }
+} // namespace
+
+tmx::CollisionGrid::CollisionGrid(int width, int height)
+    : gridWidth(width), gridHeight(height), rowWords((width + 63) / 64),
+      bits(gridWords(width, height)) {}
+
+std::vector<std::uint8_t> tmx::CollisionGrid::solidTiles(const Map& map, const TilePredicate& solid) {
+    std::vector<std::uint8_t> flags;
+    for(const Tileset& tileset : map.tilesets()) {
+        for(const Tile& tile : tileset.tiles()) {
+            if(!solid(tile)) {
+                continue;
+            }
+            auto gid = static_cast<std::size_t>(tileset.firstGID() + tile.id());
+            if(gid >= flags.size()) {
+                flags.resize(gid + 1);
+            }
+            flags[gid] = 1;
+        }
+    }
+    return flags;
+}
+
+tmx::CollisionGrid tmx::CollisionGrid::fromLayer(const TileLayer& layer, std::span<const std::uint8_t> solidTiles) {
+    CollisionGrid grid(layer.width(), layer.height());
+    std::span<const std::uint32_t> cells = layer.cells();
+    // GIDs without a flag are clamped to a clear one past the end, so the lookup does not branch
+    std::vector<std::uint8_t> flags(solidTiles.size() + 1);
+    for(std::size_t i = 0; i < solidTiles.size(); i++) {
+        flags[i] = solidTiles[i] != 0 ? 1 : 0;
+    }
+    auto last = static_cast<std::uint32_t>(solidTiles.size());
+    // Bytes past the width stay clear and fill the last word of a row
+    std::vector<std::uint8_t> solid(static_cast<std::size_t>(grid.rowWords) * 64);
+    for(int y = 0; y < grid.gridHeight; y++) {
+        const std::uint32_t* row = cells.data() + (static_cast<std::size_t>(y) * grid.gridWidth);
+        for(int x = 0; x < grid.gridWidth; x++) {
+            solid[x] = flags[std::min(row[x] & GID_MASK, last)];
+        }
+        std::uint64_t* out = grid.bits.data() + (static_cast<std::size_t>(y) * grid.rowWords);
+        for(int word = 0; word < grid.rowWords; word++) {
+            const std::uint8_t* bytes = solid.data() + (static_cast<std::size_t>(word) * 64);
+            std::uint64_t value = 0;
+            for(unsigned int group = 0; group < 8; group++) {
+                value |= packBytes(bytes + (group * 8)) << (group * 8);
+            }
+            out[word] = value;
+        }
+    }
+    return grid;
+}
+
+tmx::CollisionGrid tmx::CollisionGrid::fromLayer(const Map& map, const TileLayer& layer, const TilePredicate& solid) {
+    return fromLayer(layer, solidTiles(map, solid));
+}
+
+tmx::TilePredicate tmx::CollisionGrid::withProperty(const std::string& name) {
+    return [name](const Tile& tile) {
+        if(!tile.hasProperty(name)) {
+            return false;
+        }
+        const PropertyValue& value = tile.property(name);
+        return value.type() != Type::BOOL || value.boolValue();
+    };
+}
+
+tmx::TilePredicate tmx::CollisionGrid::withProperty(const std::string& name, const std::string& value) {
+    return [name, value](const Tile& tile) {
+        if(!tile.hasProperty(name)) {
+            return false;
+        }
+        const PropertyValue& property = tile.property(name);
+        switch(property.type()) {
+            case Type::STRING:
+                return property.stringValue() == value;
+            case Type::FILE:
+                return property.fileValue() == value;
+            case Type::INT:
+                return parsedEquals(value, property.intValue());
+            case Type::OBJECT:
+                return parsedEquals(value, property.objectValue());
+            case Type::FLOAT:
+                return parsedEquals(value, property.floatValue());
+            case Type::BOOL:
+                return value == (property.boolValue() ? "true" : "false");
+            case Type::COLOR: {
+                Color color = colorFromString(value);
+                Color other = property.colorValue();
+                return color.r == other.r && color.g == other.g && color.b == other.b && color.a == other.a;
+            }
+            default:
+                return false;
+        }
+    };
+}
+
+tmx::TilePredicate tmx::CollisionGrid::withCollisionObjects() {
+    return [](const Tile& tile) { return !tile.objectGroup().objects().empty(); };
+}
+
+int tmx::CollisionGrid::width() const { return gridWidth; }
+int tmx::CollisionGrid::height() const { return gridHeight; }
+int tmx::CollisionGrid::wordsPerRow() const { return rowWords; }
+std::span<const std::uint64_t> tmx::CollisionGrid::words() const { return bits; }
+
+std::span<const std::uint64_t> tmx::CollisionGrid::row(int y) const {
+    return std::span<const std::uint64_t>(bits).subspan(static_cast<std::size_t>(y) * rowWords, rowWords);
+}
+
+bool tmx::CollisionGrid::at(int x, int y) const {
+    if(x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) {
+        return false;
+    }
+    return ((bits[(static_cast<std::size_t>(y) * rowWords) + (x / 64)] >> static_cast<unsigned int>(x % 64)) & 1U) !=
+           0;
+}
+
+void tmx::CollisionGrid::set(int x, int y, bool solid) {
+    if(x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) {
+        throw Exception("Cell " + std::to_string(x) + ", " + std::to_string(y) + " is outside of the collision grid");
+    }
+    std::uint64_t& word = bits[(static_cast<std::size_t>(y) * rowWords) + (x / 64)];
+    std::uint64_t bit = std::uint64_t(1) << static_cast<unsigned int>(x % 64);
+    word = solid ? word | bit : word & ~bit;
+}
+
+int tmx::CollisionGrid::count() const {
+    int result = 0;
+    for(std::uint64_t word : bits) {
+        result += std::popcount(word);
+    }
+    return result;
+}
+
+int tmx::CollisionGrid::nextCell(int x, int y, bool solid) const {
+    // Padding bits are clear, so searching clear cells may end past the width
+    const std::uint64_t* words = bits.data() + (static_cast<std::size_t>(y) * rowWords);
+    for(int word = x / 64; word < rowWords; word++) {
+        std::uint64_t value = solid ? words[word] : ~words[word];
+        if(word == x / 64) {
+            value &= ~std::uint64_t(0) << static_cast<unsigned int>(x % 64);
+        }
+        if(value != 0) {
+            return std::min((word * 64) + std::countr_zero(value), gridWidth);
+        }
+    }
+    return gridWidth;
+}
+
+tmx::CollisionGrid tmx::CollisionGrid::transposed() const {
+    CollisionGrid result(gridHeight, gridWidth);
+    for(int y = 0; y < gridHeight; y++) {
+        for(int x = nextCell(0, y, true); x < gridWidth; x = nextCell(x + 1, y, true)) {
+            result.set(y, x, true);
+        }
+    }
+    return result;
+}
+
+std::vector<tmx::MapChanges::Rect> tmx::CollisionGrid::rectangles(Merge merge) const {
+    // Rectangles reaching the previous row, sorted by x. Runs are found a word at a time
+    std::vector<MapChanges::Rect> result;
+    std::vector<std::size_t> open;
+    std::vector<std::size_t> next;
+    for(int y = 0; y < gridHeight; y++) {
+        std::size_t candidate = 0;
+        for(int x = nextCell(0, y, true); x < gridWidth;) {
+            int end = nextCell(x, y, false);
+            while(candidate < open.size() && result[open[candidate]].x < x) {
+                candidate++;
+            }
+            if(candidate < open.size() && result[open[candidate]].x == x && result[open[candidate]].width == end - x) {
+                result[open[candidate]].height++;
+                next.push_back(open[candidate]);
+            } else {
+                next.push_back(result.size());
+                result.push_back({.x = x, .y = y, .width = end - x, .height = 1});
+            }
+            x = nextCell(end, y, true);
+        }
+        std::swap(open, next);
+        next.clear();
+    }
+    if(merge == Merge::ROWS || result.empty()) {
+        return result;
+    }
+
+    std::vector<MapChanges::Rect> columns = transposed().rectangles(Merge::ROWS);
+    for(MapChanges::Rect& rect : columns) {
+        rect = {.x = rect.y, .y = rect.x, .width = rect.height, .height = rect.width};
+    }
+
+    // Label regions of edge connected cells, every rectangle lies in a single region
+    std::vector<int> labels(static_cast<std::size_t>(gridWidth) * gridHeight, -1);
+    std::vector<IntPoint> stack;
+    int regions = 0;
+    for(int y = 0; y < gridHeight; y++) {
+        for(int x = nextCell(0, y, true); x < gridWidth; x = nextCell(x + 1, y, true)) {
+            if(labels[(static_cast<std::size_t>(y) * gridWidth) + x] != -1) {
+                continue;
+            }
+            labels[(static_cast<std::size_t>(y) * gridWidth) + x] = regions;
+            stack.push_back({x, y});
+            while(!stack.empty()) {
+                IntPoint cell = stack.back();
+                stack.pop_back();
+                for(IntPoint neighbor : {IntPoint{cell.x - 1, cell.y}, IntPoint{cell.x + 1, cell.y},
+                        IntPoint{cell.x, cell.y - 1}, IntPoint{cell.x, cell.y + 1}}) {
+                    if(at(neighbor.x, neighbor.y)) {
+                        int& label = labels[(static_cast<std::size_t>(neighbor.y) * gridWidth) + neighbor.x];
+                        if(label == -1) {
+                            label = regions;
+                            stack.push_back(neighbor);
+                        }
+                    }
+                }
+            }
+            regions++;
+        }
+    }
+
+    // Positive when merging columns first saves rectangles in a region
+    std::vector<int> saved(regions);
+    auto region = [&](const MapChanges::Rect& rect) {
+        return labels[(static_cast<std::size_t>(rect.y) * gridWidth) + rect.x];
+    };
+    for(const MapChanges::Rect& rect : result) {
+        saved[region(rect)]++;
+    }
+    for(const MapChanges::Rect& rect : columns) {
+        saved[region(rect)]--;
+    }
+    std::erase_if(result, [&](const MapChanges::Rect& rect) { return saved[region(rect)] > 0; });
+    for(const MapChanges::Rect& rect : columns) {
+        if(saved[region(rect)] > 0) {
+            result.push_back(rect);
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<tmx::IntPoint>> tmx::CollisionGrid::outlines() const {
+    // Directions right, down, left and up, so turning right adds one
+    constexpr std::array<IntPoint, 4> steps = {{{1, 0}, {0, 1}, {-1, 0}, {0, -1}}};
+
+    // Outgoing edges of every corner of the grid, each edge has solid cells on its right
+    int corners = gridWidth + 1;
+    std::vector<std::uint8_t> edges(static_cast<std::size_t>(corners) * (gridHeight + 1));
+    auto corner = [corners](int x, int y) { return (static_cast<std::size_t>(y) * corners) + x; };
+    for(int y = 0; y < gridHeight; y++) {
+        for(int x = nextCell(0, y, true); x < gridWidth; x = nextCell(x + 1, y, true)) {
+            if(!at(x, y - 1)) {
+                edges[corner(x, y)] |= 1U << 0U;
+            }
+            if(!at(x + 1, y)) {
+                edges[corner(x + 1, y)] |= 1U << 1U;
+            }
+            if(!at(x, y + 1)) {
+                edges[corner(x + 1, y + 1)] |= 1U << 2U;
+            }
+            if(!at(x - 1, y)) {
+                edges[corner(x, y + 1)] |= 1U << 3U;
+            }
+        }
+    }
+
+    std::vector<std::vector<IntPoint>> result;
+    std::vector<std::pair<IntPoint, unsigned int>> path;
+    for(int y = 0; y <= gridHeight; y++) {
+        for(int x = 0; x <= gridWidth; x++) {
+            while(edges[corner(x, y)] != 0) {
+                IntPoint start = {x, y};
+                auto first = static_cast<unsigned int>(std::countr_zero(edges[corner(x, y)]));
+                IntPoint point = start;
+                unsigned int direction = first;
+                path.clear();
+                while(true) {
+                    edges[corner(point.x, point.y)] &= ~(1U << direction);
+                    path.emplace_back(point, direction);
+                    point = {point.x + steps[direction].x, point.y + steps[direction].y};
+
+                    // Turning right first keeps regions touching at a corner apart. Back at the start, the first
+                    // edge counts as available so the outline closes rather than continuing into another one
+                    unsigned int available = edges[corner(point.x, point.y)];
+                    if(point.x == start.x && point.y == start.y) {
+                        available |= 1U << first;
+                    }
+                    for(unsigned int turn : {1U, 0U, 3U}) {
+                        if((available & (1U << ((direction + turn) % 4))) != 0) {
+                            direction = (direction + turn) % 4;
+                            break;
+                        }
+                    }
+                    if(point.x == start.x && point.y == start.y && direction == first) {
+                        break;
+                    }
+                }
+
+                // Points between two edges of the same direction are dropped
+                std::vector<IntPoint>& outline = result.emplace_back();
+                for(std::size_t i = 0; i < path.size(); i++) {
+                    if(path[i].second != path[(i + path.size() - 1) % path.size()].second) {
+                        outline.push_back(path[i].first);
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Operation>
+tmx::CollisionGrid& tmx::CollisionGrid::combine(const CollisionGrid& other, Operation operation) {
+    if(other.gridWidth != gridWidth || other.gridHeight != gridHeight) {
+        throw Exception("Collision grids of different sizes");
+    }
+    for(std::size_t i = 0; i < bits.size(); i++) {
+        bits[i] = operation(bits[i], other.bits[i]);
+    }
+    return *this;
+}
+
+tmx::CollisionGrid& tmx::CollisionGrid::operator|=(const CollisionGrid& other) {
+    return combine(other, [](std::uint64_t a, std::uint64_t b) { return a | b; });
+}
+
+tmx::CollisionGrid& tmx::CollisionGrid::operator&=(const CollisionGrid& other) {
+    return combine(other, [](std::uint64_t a, std::uint64_t b) { return a & b; });
+}
+
+tmx::CollisionGrid& tmx::CollisionGrid::operator^=(const CollisionGrid& other) {
+    return combine(other, [](std::uint64_t a, std::uint64_t b) { return a ^ b; });
+}
+
+tmx::CollisionGrid& tmx::CollisionGrid::subtract(const CollisionGrid& other) {
+    return combine(other, [](std::uint64_t a, std::uint64_t b) { return a & ~b; });
+}
@@ -0,0 +1,85 @@
+#include <tinyxml2.h>
+#include "element.hpp"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tmxpp.hpp>
+
+namespace {
+    class DomElement : public tmx::internal::Element {
+    public:
+        DomElement(tinyxml2::XMLElement* element, std::size_t size) : element(element), size(size) {}
+
+        void reset(tinyxml2::XMLElement* value) {
+            element = value;
+            cursor = nullptr;
+            started = false;
+        }
+
+        [[nodiscard]] std::string_view name() const override { return element->Name(); }
+
+        [[nodiscard]] std::optional<std::string_view> attribute(std::string_view name) const override {
+            const char* value = element->Attribute(std::string(name).c_str());
+            if(value == nullptr) {
+                return std::nullopt;
+            }
+            return std::string_view(value);
+        }
+
+        [[nodiscard]] std::string_view text() override {
+            const char* value = element->GetText();
+            return value == nullptr ? std::string_view() : std::string_view(value);
+        }
+
+        [[nodiscard]] Element* nextChild() override {
+            cursor = started ? cursor->NextSiblingElement() : element->FirstChildElement();
+            started = true;
+            if(cursor == nullptr) {
+                return nullptr;
+            }
+            if(child == nullptr) {
+                child = std::make_unique<DomElement>(cursor, size);
+            } else {
+                child->reset(cursor);
+            }
+            return child.get();
+        }
+
+        [[nodiscard]] int childCount(std::initializer_list<std::string_view> names) const override {
+            int count = 0;
+            for(tinyxml2::XMLElement* it = element->FirstChildElement(); it != nullptr; it = it->NextSiblingElement()) {
+                for(std::string_view name : names) {
+                    if(name == it->Name()) {
+                        count++;
+                        break;
+                    }
+                }
+            }
+            return count;
+        }
+
+        [[nodiscard]] std::size_t position() const override { return size; }
+
+    private:
+        tinyxml2::XMLElement* element;
+        tinyxml2::XMLElement* cursor = nullptr;
+        bool started = false;
+        std::size_t size;
+        std::unique_ptr<DomElement> child;
+    };
+}
+
+void tmx::internal::parseDomDocument(
+    const Buffer& data, std::string_view rootName, const std::function<void(Element&)>& callback) {
+    tinyxml2::XMLDocument doc;
+    tinyxml2::XMLError error = doc.Parse(data.data(), data.size());
+    if(error != 0) {
+        throw Exception("XML parse failed (error code " + std::to_string(error) + ")");
+    }
+    tinyxml2::XMLElement* root = doc.FirstChildElement(std::string(rootName).c_str());
+    if(root == nullptr) {
+        throw Exception("Missing " + std::string(rootName) + " root element");
+    }
+    DomElement element(root, data.size());
+    callback(element);
+}
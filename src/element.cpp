@@ -0,0 +1,104 @@
+#include "element.hpp"
+#include <charconv>
+#include <string>
+#include <system_error>
+#include <tmxpp.hpp>
+
+template <typename T>
+static bool parseNumber(std::string_view str, T& value) {
+    while(!str.empty() && (str.front() == ' ' || str.front() == '\t' || str.front() == '\n' || str.front() == '\r')) {
+        str.remove_prefix(1);
+    }
+    if(!str.empty() && str.front() == '+') {
+        str.remove_prefix(1);
+    }
+    T result{};
+    auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), result);
+    if(error != std::errc() || end == str.data()) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+bool tmx::internal::Element::hasAttribute(std::string_view name) const { return attribute(name).has_value(); }
+
+int tmx::internal::Element::intAttribute(std::string_view name, int defaultValue) const {
+    query(name, defaultValue);
+    return defaultValue;
+}
+
+bool tmx::internal::Element::query(std::string_view name, std::string& value) const {
+    auto attr = attribute(name);
+    if(!attr.has_value()) {
+        return false;
+    }
+    value = *attr;
+    return true;
+}
+
+bool tmx::internal::Element::query(std::string_view name, int& value) const {
+    auto attr = attribute(name);
+    return attr.has_value() && parseNumber(*attr, value);
+}
+
+bool tmx::internal::Element::query(std::string_view name, unsigned int& value) const {
+    auto attr = attribute(name);
+    return attr.has_value() && parseNumber(*attr, value);
+}
+
+bool tmx::internal::Element::query(std::string_view name, double& value) const {
+    auto attr = attribute(name);
+    return attr.has_value() && parseNumber(*attr, value);
+}
+
+bool tmx::internal::Element::query(std::string_view name, float& value) const {
+    auto attr = attribute(name);
+    return attr.has_value() && parseNumber(*attr, value);
+}
+
+bool tmx::internal::Element::query(std::string_view name, bool& value) const {
+    auto attr = attribute(name);
+    if(!attr.has_value()) {
+        return false;
+    }
+    if(*attr == "true" || *attr == "True" || *attr == "TRUE") {
+        value = true;
+        return true;
+    }
+    if(*attr == "false" || *attr == "False" || *attr == "FALSE") {
+        value = false;
+        return true;
+    }
+    int number = 0;
+    if(parseNumber(*attr, number)) {
+        value = number != 0;
+        return true;
+    }
+    return false;
+}
+
+bool tmx::internal::Element::query(std::string_view name, Color& value) const {
+    auto attr = attribute(name);
+    if(!attr.has_value()) {
+        return false;
+    }
+    value = colorFromString(std::string(*attr));
+    return true;
+}
+
+void tmx::internal::parseDocument(const Buffer& data, ParseOptions::Backend backend, std::string_view rootName,
+    const std::function<void(Element&)>& callback) {
+    std::string_view view = data.view();
+    if(view.starts_with("\xEF\xBB\xBF")) {
+        view.remove_prefix(3);
+    }
+    std::size_t first = view.find_first_not_of(" \t\r\n");
+    if(first != std::string_view::npos && view[first] == '{') {
+        parseJsonDocument(data, rootName, callback);
+    } else if(backend == ParseOptions::Backend::DOM) {
+        parseDomDocument(data, rootName, callback);
+    } else {
+        parseStreamDocument(data, rootName, callback);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef TMXPP_ELEMENT_HPP
+#define TMXPP_ELEMENT_HPP
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tmxpp.hpp>
+
+// Format independent view of a document element. Children are visited once, in document order, which lets
+// the same parsing code run on top of a DOM or a forward-only streaming reader
+class tmx::internal::Element {
+public:
+    Element() = default;
+    Element(const Element&) = delete;
+    Element(Element&&) = delete;
+    Element& operator=(const Element&) = delete;
+    Element& operator=(Element&&) = delete;
+    virtual ~Element() = default;
+
+    [[nodiscard]] virtual std::string_view name() const = 0;
+    [[nodiscard]] virtual std::optional<std::string_view> attribute(std::string_view name) const = 0;
+
+    // Text content of the element, skips over child elements. Element can not be iterated afterwards
+    [[nodiscard]] virtual std::string_view text() = 0;
+    // Returns next child element or nullptr, unvisited content of the previous child is skipped
+    [[nodiscard]] virtual Element* nextChild() = 0;
+
+    // Number of child elements with given names, or 0 if it is not known in advance
+    [[nodiscard]] virtual int childCount(std::initializer_list<std::string_view> names) const = 0;
+    // Number of input bytes consumed so far
+    [[nodiscard]] virtual std::size_t position() const = 0;
+
+    [[nodiscard]] bool hasAttribute(std::string_view name) const;
+    [[nodiscard]] int intAttribute(std::string_view name, int defaultValue = 0) const;
+
+    // Each query leaves value unchanged and returns false if attribute is missing or malformed
+    bool query(std::string_view name, std::string& value) const;
+    bool query(std::string_view name, int& value) const;
+    bool query(std::string_view name, unsigned int& value) const;
+    bool query(std::string_view name, double& value) const;
+    bool query(std::string_view name, float& value) const;
+    bool query(std::string_view name, bool& value) const;
+    bool query(std::string_view name, Color& value) const;
+};
+
+namespace tmx::internal {
+    // Parses XML or JSON document, detected by the first significant character, and calls callback with its root
+    // element, which must be named rootName. Backend only applies to XML
+    void parseDocument(const Buffer& data, ParseOptions::Backend backend, std::string_view rootName,
+        const std::function<void(Element&)>& callback);
+
+    void parseDomDocument(const Buffer& data, std::string_view rootName, const std::function<void(Element&)>& callback);
+    void parseStreamDocument(
+        const Buffer& data, std::string_view rootName, const std::function<void(Element&)>& callback);
+    void parseJsonDocument(
+        const Buffer& data, std::string_view rootName, const std::function<void(Element&)>& callback);
+}
+
+#endif // TMXPP_ELEMENT_HPP
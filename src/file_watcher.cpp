@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <tmxpp.hpp>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <array>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+struct tmx::FileWatcher::Data {
+    struct File {
+        std::filesystem::path path;
+        std::filesystem::file_time_type writeTime;
+        std::uintmax_t size = 0;
+    };
+
+    std::vector<File> files;
+
+#ifdef __linux__
+    struct Watch {
+        int descriptor = -1;
+        // Names of watched files in the directory
+        std::vector<std::string> names;
+    };
+
+    int inotify = -1;
+    std::vector<Watch> watches;
+
+    ~Data() {
+        if(inotify != -1) {
+            close(inotify);
+        }
+    }
+#endif
+
+    static void stat(File& file) {
+        std::error_code error;
+        file.writeTime = std::filesystem::last_write_time(file.path, error);
+        file.size = std::filesystem::file_size(file.path, error);
+        if(error) {
+            file.size = 0;
+        }
+    }
+
+    bool pollTimes() {
+        bool changed = false;
+        for(File& file : files) {
+            File current{.path = file.path, .writeTime = {}};
+            stat(current);
+            if(current.writeTime != file.writeTime || current.size != file.size) {
+                file = std::move(current);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+#ifdef __linux__
+    // Directories are watched rather than files, editors often save by writing a new file and renaming it over
+    // the old one, which would silently end a watch on the file itself
+    void watch() {
+        inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(inotify == -1) {
+            return;
+        }
+        for(const File& file : files) {
+            std::filesystem::path directory = file.path.parent_path();
+            if(directory.empty()) {
+                directory = ".";
+            }
+            int descriptor = inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if(descriptor == -1) {
+                close(inotify);
+                inotify = -1;
+                watches.clear();
+                return;
+            }
+            Watch* watch = nullptr;
+            for(Watch& existing : watches) {
+                if(existing.descriptor == descriptor) {
+                    watch = &existing;
+                }
+            }
+            if(watch == nullptr) {
+                watch = &watches.emplace_back(Watch{.descriptor = descriptor, .names = {}});
+            }
+            watch->names.push_back(file.path.filename().string());
+        }
+    }
+
+    bool pollEvents() {
+        bool changed = false;
+        alignas(inotify_event) std::array<char, 4096> buffer{};
+        ssize_t size = 0;
+        while((size = read(inotify, buffer.data(), buffer.size())) > 0) {
+            for(ssize_t offset = 0; offset < size;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                if(event->len == 0) {
+                    continue;
+                }
+                std::string_view name(event->name);
+                for(const Watch& watch : watches) {
+                    if(watch.descriptor != event->wd) {
+                        continue;
+                    }
+                    for(const std::string& watched : watch.names) {
+                        changed |= watched == name;
+                    }
+                }
+            }
+        }
+        return changed;
+    }
+#endif
+};
+
+tmx::FileWatcher::FileWatcher(const std::vector<std::filesystem::path>& paths) : d(std::make_unique<Data>()) {
+    for(const std::filesystem::path& path : paths) {
+        Data::File file{.path = path, .writeTime = {}};
+        Data::stat(file);
+        d->files.push_back(std::move(file));
+    }
+#ifdef __linux__
+    d->watch();
+#endif
+}
+
+tmx::FileWatcher::FileWatcher(FileWatcher&& other) noexcept = default;
+tmx::FileWatcher& tmx::FileWatcher::operator=(FileWatcher&& other) noexcept = default;
+tmx::FileWatcher::~FileWatcher() = default;
+
+bool tmx::FileWatcher::poll() {
+#ifdef __linux__
+    if(d->inotify != -1) {
+        return d->pollEvents();
+    }
+#endif
+    return d->pollTimes();
+}
@@ -0,0 +1,118 @@
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
+#include <tmxpp.hpp>
+#include <utility>
+
+struct tmx::GroupLayer::Data {
+    std::vector<Layer> layers;
+};
+
+__TMXPP_CLASS_HEADER_IMPL__(tmx, GroupLayer)
+
+namespace {
+    // Far deeper than maps made in an editor, keeps corrupted baked maps from overflowing the stack
+    constexpr int maxGroupDepth = 256;
+} // namespace
+
+const std::vector<tmx::Layer>& tmx::GroupLayer::layers() const { return d->layers; }
+
+void tmx::GroupLayer::parse(internal::Element& root, const ParseOptions& options, const ParseLayer& parseLayer) {
+    AbstractLayer::parse(root);
+    while(internal::Element* element = root.nextChild()) {
+        if(element->name() == "properties") {
+            if(!options.skipProperties) {
+                Properties::parse(*element);
+            }
+        } else {
+            parseLayer(*element, d->layers);
+        }
+    }
+}
+
+void tmx::GroupLayer::saveLayers(internal::XmlWriter& writer, const std::vector<Layer>& layers,
+    const SaveOptions& options, const std::vector<std::string>& layerData, std::size_t& next) {
+    for(const Layer& layer : layers) {
+        switch(layer.type()) {
+            case Layer::Type::TILE:
+                layer.tileLayer().save(writer, options, layerData[next]);
+                break;
+            case Layer::Type::IMAGE:
+                layer.imageLayer().save(writer);
+                break;
+            case Layer::Type::OBJECT:
+                layer.objectGroup().save(writer);
+                break;
+            case Layer::Type::GROUP: {
+                const GroupLayer& group = layer.groupLayer();
+                writer.open("group");
+                group.AbstractLayer::save(writer);
+                group.Properties::save(writer);
+                saveLayers(writer, group.d->layers, options, layerData, next);
+                writer.close();
+                break;
+            }
+            default:
+                break;
+        }
+        if(layer.type() != Layer::Type::GROUP) {
+            next++;
+        }
+    }
+}
+
+void tmx::GroupLayer::serializeLayers(internal::BinaryWriter& writer, const std::vector<Layer>& layers) {
+    writer.write(static_cast<std::uint32_t>(layers.size()));
+    for(const Layer& layer : layers) {
+        writer.write(layer.type());
+        switch(layer.type()) {
+            case Layer::Type::TILE:
+                layer.tileLayer().serialize(writer);
+                break;
+            case Layer::Type::IMAGE:
+                layer.imageLayer().serialize(writer);
+                break;
+            case Layer::Type::OBJECT:
+                layer.objectGroup().serialize(writer);
+                break;
+            case Layer::Type::GROUP: {
+                const GroupLayer& group = layer.groupLayer();
+                group.AbstractLayer::serialize(writer);
+                serializeLayers(writer, group.d->layers);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void tmx::GroupLayer::deserializeLayers(internal::BinaryReader& reader, std::vector<Layer>& layers, int depth) {
+    if(depth > maxGroupDepth) {
+        throw Exception("Baked map is corrupted");
+    }
+    auto count = reader.read<std::uint32_t>();
+    for(std::uint32_t i = 0; i < count; i++) {
+        auto type = reader.read<Layer::Type>();
+        if(type == Layer::Type::TILE) {
+            TileLayer layer;
+            layer.deserialize(reader);
+            layers.emplace_back(std::move(layer));
+        } else if(type == Layer::Type::IMAGE) {
+            ImageLayer layer;
+            layer.deserialize(reader);
+            layers.emplace_back(std::move(layer));
+        } else if(type == Layer::Type::OBJECT) {
+            ObjectGroup objectGroup;
+            objectGroup.deserialize(reader);
+            layers.emplace_back(std::move(objectGroup));
+        } else if(type == Layer::Type::GROUP) {
+            GroupLayer group;
+            group.AbstractLayer::deserialize(reader);
+            deserializeLayers(reader, group.d->layers, depth + 1);
+            layers.emplace_back(std::move(group));
+        } else {
+            throw Exception("Baked map is corrupted");
+        }
+    }
+}
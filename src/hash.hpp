@@ -0,0 +1,38 @@
+#ifndef TMXPP_HASH_HPP
+#define TMXPP_HASH_HPP
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace tmx::internal {
+    // Fast non-cryptographic 64-bit hash, processes input a word at a time. Values depend on host byte order,
+    // so they are only meant for local caches and change detection
+    inline std::uint64_t hashBytes(std::string_view data, std::uint64_t seed = 0) {
+        constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+        constexpr std::uint64_t mixer1 = 0xBF58476D1CE4E5B9ULL;
+        constexpr std::uint64_t mixer2 = 0x94D049BB133111EBULL;
+
+        std::uint64_t hash = seed ^ (data.size() * multiplier);
+        std::size_t i = 0;
+        for(; i + sizeof(std::uint64_t) <= data.size(); i += sizeof(std::uint64_t)) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data.data() + i, sizeof(word));
+            hash = std::rotl(hash ^ (word * multiplier), 31) * mixer1;
+        }
+
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, data.data() + i, data.size() - i);
+        hash ^= tail * multiplier;
+
+        hash ^= hash >> 30U;
+        hash *= mixer1;
+        hash ^= hash >> 27U;
+        hash *= mixer2;
+        hash ^= hash >> 31U;
+        return hash;
+    }
+} // namespace tmx::internal
+
+#endif // TMXPP_HASH_HPP
@@ -1,12 +1,30 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <tmxpp.hpp>
 
+#ifdef TMXPP_BASE64
+#include <base64.hpp>
+#endif
+
 struct tmx::Image::Data {
     Type type = Type::EMPTY;
     std::string source;
     Color transparentColor;
     int width = 0;
     int height = 0;
+    int handle = -1;
+    std::string format;
+    // Embedded contents, owned by a decoded buffer or by the memory of a baked map
+    const std::byte* bytes = nullptr;
+    std::size_t size = 0;
+    std::shared_ptr<const void> owner;
 };
 
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Image)
@@ -16,23 +34,98 @@ const std::string& tmx::Image::source() const { return d->source; }
 tmx::Color tmx::Image::transparentColor() const { return d->transparentColor; }
 int tmx::Image::width() const { return d->width; }
 int tmx::Image::height() const { return d->height; }
+int tmx::Image::handle() const { return d->handle; }
+const std::string& tmx::Image::format() const { return d->format; }
+std::span<const std::byte> tmx::Image::data() const { return {d->bytes, d->size}; }
 
-void tmx::Image::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing image element");
-    }
+void tmx::Image::setHandle(int handle) { d->handle = handle; }
 
-    if(root->Attribute("source") != nullptr) {
+void tmx::Image::parse(internal::Element& root) {
+    if(root.query("source", d->source)) {
         d->type = Type::EXTERNAL;
-        d->source = root->Attribute("source");
-    } else {
-        throw Exception("Embedded images are currently unsupported");
+    }
+    root.query("format", d->format);
+    root.query("trans", d->transparentColor);
+    root.query("width", d->width);
+    root.query("height", d->height);
+
+    while(internal::Element* element = root.nextChild()) {
+        if(element->name() == "data" && d->type != Type::EXTERNAL) {
+            parseData(*element);
+        }
+    }
+}
+
+static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+void tmx::Image::parseData(internal::Element& element) {
+    if(element.attribute("encoding").value_or("") != "base64") {
+        throw Exception("Embedded images must be base64 encoded");
+    }
+#ifdef TMXPP_BASE64
+    std::string_view str = element.text();
+    while(!str.empty() && isSpace(str.front())) {
+        str.remove_prefix(1);
+    }
+    while(!str.empty() && isSpace(str.back())) {
+        str.remove_suffix(1);
     }
 
-    if(root->Attribute("trans") != nullptr) {
-        d->transparentColor = colorFromString(root->Attribute("trans"));
+    auto buffer = std::make_shared<std::string>(base64::from_base64(str));
+    std::string compression(element.attribute("compression").value_or(""));
+    if(!compression.empty()) {
+        *buffer = TileLayer::decompressData(*buffer, compression);
+    }
+    d->type = Type::EMBEDDED;
+    d->bytes = reinterpret_cast<const std::byte*>(buffer->data());
+    d->size = buffer->size();
+    d->owner = std::move(buffer);
+#else
+    throw Exception("Map has an embedded image, but tmxpp was build without base64 support");
+#endif
+}
+
+void tmx::Image::save(internal::XmlWriter& writer) const {
+    if(d->type == Type::EMPTY) {
+        return;
+    }
+    writer.open("image");
+    if(d->type == Type::EXTERNAL) {
+        writer.attribute("source", d->source);
+    } else {
+        writer.attribute("format", d->format);
+    }
+    writer.attribute("trans", d->transparentColor, Color());
+    writer.attribute("width", d->width, 0);
+    writer.attribute("height", d->height, 0);
+    if(d->type == Type::EMBEDDED) {
+        // Written uncompressed, the payload is usually an already compressed image format
+        writer.open("data");
+        writer.attribute("encoding", "base64");
+        writer.rawText(internal::encodeBase64({reinterpret_cast<const char*>(d->bytes), d->size}));
+        writer.close();
     }
+    writer.close();
+}
+
+void tmx::Image::serialize(internal::BinaryWriter& writer) const {
+    writer.write(d->type);
+    writer.write(d->source);
+    writer.write(d->transparentColor);
+    writer.write(d->width);
+    writer.write(d->height);
+    writer.write(d->handle);
+    writer.write(d->format);
+    writer.writeBlob(data());
+}
 
-    root->QueryIntAttribute("width", &d->width);
-    root->QueryIntAttribute("height", &d->height);
+void tmx::Image::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->type);
+    reader.read(d->source);
+    reader.read(d->transparentColor);
+    reader.read(d->width);
+    reader.read(d->height);
+    reader.read(d->handle);
+    reader.read(d->format);
+    std::tie(d->bytes, d->size, d->owner) = reader.readBlob();
 }
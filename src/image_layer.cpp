@@ -1,5 +1,7 @@
 #include <tmxpp.hpp>
-#include "tinyxml2.h"
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
 
 struct tmx::ImageLayer::Data {
     Image image;
@@ -13,13 +15,48 @@ const tmx::Image& tmx::ImageLayer::image() const { return d->image; }
 bool tmx::ImageLayer::repeatX() const { return d->repeatX; }
 bool tmx::ImageLayer::repeatY() const { return d->repeatY; }
 
-void tmx::ImageLayer::parse(tinyxml2::XMLElement* root) {
+void tmx::ImageLayer::parse(internal::Element& root, const ParseOptions& options) {
     AbstractLayer::parse(root);
 
-    root->QueryBoolAttribute("repeatx", &d->repeatX);
-    root->QueryBoolAttribute("repeatY", &d->repeatY);
+    root.query("repeatx", d->repeatX);
+    if(!root.query("repeaty", d->repeatY)) {
+        root.query("repeatY", d->repeatY);
+    }
 
-    if(root->FirstChildElement("image") != nullptr) {
-        d->image.parse(root->FirstChildElement("image"));
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "image") {
+            d->image.parse(*element);
+        } else if(name == "properties" && !options.skipProperties) {
+            Properties::parse(*element);
+        }
     }
 }
+
+void tmx::ImageLayer::registerImages(const internal::ImageRegistry& registry) {
+    d->image.setHandle(registry(d->image));
+}
+
+void tmx::ImageLayer::save(internal::XmlWriter& writer) const {
+    writer.open("imagelayer");
+    AbstractLayer::save(writer);
+    writer.attribute("repeatx", d->repeatX, false);
+    writer.attribute("repeaty", d->repeatY, false);
+    Properties::save(writer);
+    d->image.save(writer);
+    writer.close();
+}
+
+void tmx::ImageLayer::serialize(internal::BinaryWriter& writer) const {
+    AbstractLayer::serialize(writer);
+    d->image.serialize(writer);
+    writer.write(d->repeatX);
+    writer.write(d->repeatY);
+}
+
+void tmx::ImageLayer::deserialize(internal::BinaryReader& reader) {
+    AbstractLayer::deserialize(reader);
+    d->image.deserialize(reader);
+    reader.read(d->repeatX);
+    reader.read(d->repeatY);
+}
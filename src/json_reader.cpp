@@ -0,0 +1,799 @@
+#include "element.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+// Reader for Tiled JSON maps (.tmj) and tilesets (.tsj). The document is tokenized into a flat array of values
+// with strings referenced in place, only strings with escape sequences are decoded into separate storage.
+// Arrays of numbers (tile layer data) are not split into values, their text is handed to the CSV decoder as is.
+// Elements expose the JSON structure in the shape of the equivalent TMX document, so the same parsing code
+// fills the object model for both formats
+
+namespace {
+    constexpr std::uint32_t NONE = UINT32_MAX;
+    constexpr int MAX_DEPTH = 256;
+
+    enum class ValueType : unsigned char { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT, NUMBER_ARRAY };
+
+    struct Value {
+        ValueType type = ValueType::NUL;
+        std::string_view key;  // member name if value is inside an object
+        std::string_view text; // scalar text, decoded for strings, raw contents for arrays of numbers
+        std::uint32_t firstChild = NONE;
+        std::uint32_t next = NONE;
+        std::uint32_t end = 0; // input offset after the value
+    };
+
+    class Document {
+    public:
+        Document(const char* begin, const char* end) : begin(begin), pos(begin), end(end) {
+            // Tile data is stored as single values, so the count is proportional to the rest of the document
+            values.reserve(std::min<std::size_t>(static_cast<std::size_t>(end - begin) / 64, 1U << 16U));
+        }
+
+        std::uint32_t parse() {
+            if(end - pos >= 3 && std::memcmp(pos, "\xEF\xBB\xBF", 3) == 0) {
+                pos += 3;
+            }
+            skipSpaces();
+            if(pos == end) {
+                fail("empty document");
+            }
+            std::uint32_t root = parseValue({}, 0);
+            skipSpaces();
+            if(pos != end) {
+                fail("unexpected data after root value");
+            }
+            return root;
+        }
+
+        [[nodiscard]] const Value& operator[](std::uint32_t index) const { return values[index]; }
+
+        [[nodiscard]] std::uint32_t member(std::uint32_t object, std::string_view key) const {
+            if(object == NONE || values[object].type != ValueType::OBJECT) {
+                return NONE;
+            }
+            for(std::uint32_t child = values[object].firstChild; child != NONE; child = values[child].next) {
+                if(values[child].key == key) {
+                    return child;
+                }
+            }
+            return NONE;
+        }
+
+        // Scalar member as text, booleans are "true" or "false"
+        [[nodiscard]] std::optional<std::string_view> scalar(std::uint32_t object, std::string_view key) const {
+            std::uint32_t value = member(object, key);
+            if(value == NONE) {
+                return std::nullopt;
+            }
+            ValueType type = values[value].type;
+            if(type == ValueType::STRING || type == ValueType::NUMBER || type == ValueType::BOOL) {
+                return values[value].text;
+            }
+            return std::nullopt;
+        }
+
+        std::string_view store(std::string str) { return strings.emplace_back(std::move(str)); }
+
+    private:
+        [[noreturn]] void fail(const std::string& error) const {
+            int line = 1 + static_cast<int>(std::count(begin, std::min(pos, end), '\n'));
+            throw tmx::Exception("JSON parse failed (" + error + " at line " + std::to_string(line) + ")");
+        }
+
+        static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+        static constexpr std::array<bool, 256> numberArrayChars = []() {
+            std::array<bool, 256> table{};
+            for(char c : std::string_view("0123456789-+.eE, \n\t\r")) {
+                table[static_cast<unsigned char>(c)] = true;
+            }
+            return table;
+        }();
+        static bool isNumberChar(char c) {
+            return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+        }
+
+        void skipSpaces() {
+            while(pos < end && isSpace(*pos)) {
+                ++pos;
+            }
+        }
+
+        void expect(char c) {
+            skipSpaces();
+            if(pos == end || *pos != c) {
+                fail(std::string("expected '") + c + "'");
+            }
+            ++pos;
+        }
+
+        std::uint32_t add(ValueType type, std::string_view key) {
+            values.push_back({.type = type, .key = key, .text = {}});
+            return static_cast<std::uint32_t>(values.size() - 1);
+        }
+
+        std::uint32_t parseValue(std::string_view key, int depth) {
+            if(depth > MAX_DEPTH) {
+                fail("nesting is too deep");
+            }
+            skipSpaces();
+            if(pos == end) {
+                fail("unexpected end of document");
+            }
+
+            std::uint32_t index = 0;
+            char c = *pos;
+            if(c == '{') {
+                index = add(ValueType::OBJECT, key);
+                ++pos;
+                parseChildren(index, '}', depth, true);
+            } else if(c == '[') {
+                ++pos;
+                if(parseNumberArray(key)) {
+                    index = static_cast<std::uint32_t>(values.size() - 1);
+                } else {
+                    index = add(ValueType::ARRAY, key);
+                    parseChildren(index, ']', depth, false);
+                }
+            } else if(c == '"') {
+                ++pos;
+                std::string_view text = parseString();
+                index = add(ValueType::STRING, key);
+                values[index].text = text;
+            } else if(c == 't' || c == 'f' || c == 'n') {
+                std::string_view literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+                if(static_cast<std::size_t>(end - pos) < literal.size() ||
+                    std::memcmp(pos, literal.data(), literal.size()) != 0) {
+                    fail("invalid literal");
+                }
+                index = add(c == 'n' ? ValueType::NUL : ValueType::BOOL, key);
+                values[index].text = literal;
+                pos += literal.size();
+            } else if(c == '-' || (c >= '0' && c <= '9')) {
+                const char* start = pos;
+                while(pos < end && isNumberChar(*pos)) {
+                    ++pos;
+                }
+                index = add(ValueType::NUMBER, key);
+                values[index].text = {start, static_cast<std::size_t>(pos - start)};
+            } else {
+                fail("unexpected character");
+            }
+            values[index].end = static_cast<std::uint32_t>(std::min<std::size_t>(pos - begin, UINT32_MAX));
+            return index;
+        }
+
+        void parseChildren(std::uint32_t parent, char close, int depth, bool isObject) {
+            skipSpaces();
+            if(pos < end && *pos == close) {
+                ++pos;
+                return;
+            }
+            std::uint32_t last = NONE;
+            while(true) {
+                std::string_view key;
+                if(isObject) {
+                    expect('"');
+                    key = parseString();
+                    expect(':');
+                }
+                std::uint32_t child = parseValue(key, depth + 1);
+                if(last == NONE) {
+                    values[parent].firstChild = child;
+                } else {
+                    values[last].next = child;
+                }
+                last = child;
+
+                skipSpaces();
+                if(pos == end) {
+                    fail("unexpected end of document");
+                }
+                if(*pos == ',') {
+                    ++pos;
+                } else if(*pos == close) {
+                    ++pos;
+                    return;
+                } else {
+                    fail(std::string("expected ',' or '") + close + "'");
+                }
+            }
+        }
+
+        // Keeps array of plain numbers as a single value, returns false and leaves position unchanged otherwise
+        bool parseNumberArray(std::string_view key) {
+            const char* start = pos;
+            const char* it = pos;
+            while(it < end && isSpace(*it)) {
+                ++it;
+            }
+            if(it == end || (*it != '-' && (*it < '0' || *it > '9'))) {
+                return false;
+            }
+            // Tile data makes up most of a map, find the closing bracket first and validate the contents with
+            // a single pass over a lookup table instead of classifying every character separately
+            const char* close = static_cast<const char*>(std::memchr(it, ']', end - it));
+            if(close == nullptr) {
+                return false;
+            }
+            for(; it != close; ++it) {
+                if(!numberArrayChars[static_cast<unsigned char>(*it)]) {
+                    return false;
+                }
+            }
+            std::uint32_t index = add(ValueType::NUMBER_ARRAY, key);
+            values[index].text = {start, static_cast<std::size_t>(it - start)};
+            pos = it + 1;
+            return true;
+        }
+
+        std::string_view parseString() {
+            const char* start = pos;
+            while(pos < end && *pos != '"' && *pos != '\\') {
+                ++pos;
+            }
+            if(pos == end) {
+                fail("unterminated string");
+            }
+            if(*pos == '"') {
+                return {start, static_cast<std::size_t>(pos++ - start)};
+            }
+
+            std::string decoded(start, pos);
+            while(true) {
+                if(pos == end) {
+                    fail("unterminated string");
+                }
+                char c = *pos++;
+                if(c == '"') {
+                    break;
+                }
+                if(c != '\\') {
+                    decoded += c;
+                    continue;
+                }
+                if(pos == end) {
+                    fail("unterminated string");
+                }
+                char escape = *pos++;
+                switch(escape) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        decoded += escape;
+                        break;
+                    case 'b':
+                        decoded += '\b';
+                        break;
+                    case 'f':
+                        decoded += '\f';
+                        break;
+                    case 'n':
+                        decoded += '\n';
+                        break;
+                    case 'r':
+                        decoded += '\r';
+                        break;
+                    case 't':
+                        decoded += '\t';
+                        break;
+                    case 'u':
+                        appendUtf8(decoded, parseCodePoint());
+                        break;
+                    default:
+                        fail("invalid escape sequence");
+                }
+            }
+            return store(std::move(decoded));
+        }
+
+        unsigned int parseHex4() {
+            if(end - pos < 4) {
+                fail("invalid unicode escape");
+            }
+            unsigned int value = 0;
+            for(int i = 0; i < 4; i++) {
+                char c = *pos++;
+                value <<= 4U;
+                if(c >= '0' && c <= '9') {
+                    value |= c - '0';
+                } else if(c >= 'a' && c <= 'f') {
+                    value |= c - 'a' + 10;
+                } else if(c >= 'A' && c <= 'F') {
+                    value |= c - 'A' + 10;
+                } else {
+                    fail("invalid unicode escape");
+                }
+            }
+            return value;
+        }
+
+        unsigned int parseCodePoint() {
+            unsigned int code = parseHex4();
+            if(code >= 0xD800 && code <= 0xDBFF && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+                pos += 2;
+                unsigned int low = parseHex4();
+                if(low < 0xDC00 || low > 0xDFFF) {
+                    fail("invalid surrogate pair");
+                }
+                code = 0x10000 + ((code - 0xD800) << 10U) + (low - 0xDC00);
+            }
+            return code;
+        }
+
+        static void appendUtf8(std::string& str, unsigned int code) {
+            if(code < 0x80) {
+                str += static_cast<char>(code);
+            } else if(code < 0x800) {
+                str += static_cast<char>(0xC0 | (code >> 6U));
+                str += static_cast<char>(0x80 | (code & 0x3FU));
+            } else if(code < 0x10000) {
+                str += static_cast<char>(0xE0 | (code >> 12U));
+                str += static_cast<char>(0x80 | ((code >> 6U) & 0x3FU));
+                str += static_cast<char>(0x80 | (code & 0x3FU));
+            } else {
+                str += static_cast<char>(0xF0 | (code >> 18U));
+                str += static_cast<char>(0x80 | ((code >> 12U) & 0x3FU));
+                str += static_cast<char>(0x80 | ((code >> 6U) & 0x3FU));
+                str += static_cast<char>(0x80 | (code & 0x3FU));
+            }
+        }
+
+        const char* begin;
+        const char* pos;
+        const char* end;
+        std::vector<Value> values;
+        std::deque<std::string> strings;
+    };
+
+    // TMX element an element is presented as. Some of them are synthesized from members of the parent object
+    // (e.g. image from "image", "imagewidth" and "imageheight") and refer to the parent value
+    enum class Kind : unsigned char {
+        MAP,
+        TILESET,
+        TEMPLATE,
+        TILE,
+        TILE_LAYER,
+        DATA,
+        OBJECT_GROUP,
+        OBJECT,
+        IMAGE_LAYER,
+        GROUP,
+        IMAGE,
+        TILE_OFFSET,
+        GRID,
+        ANIMATION,
+        FRAME,
+        PROPERTIES,
+        PROPERTY,
+        CLASS_MEMBER,
+        ELLIPSE,
+        POINT,
+        POLYGON,
+        POLYLINE,
+        TEXT,
+    };
+
+    std::string_view kindName(Kind kind) {
+        switch(kind) {
+            case Kind::MAP:
+                return "map";
+            case Kind::TILESET:
+                return "tileset";
+            case Kind::TEMPLATE:
+                return "template";
+            case Kind::TILE:
+                return "tile";
+            case Kind::TILE_LAYER:
+                return "layer";
+            case Kind::DATA:
+                return "data";
+            case Kind::OBJECT_GROUP:
+                return "objectgroup";
+            case Kind::OBJECT:
+                return "object";
+            case Kind::IMAGE_LAYER:
+                return "imagelayer";
+            case Kind::GROUP:
+                return "group";
+            case Kind::IMAGE:
+                return "image";
+            case Kind::TILE_OFFSET:
+                return "tileoffset";
+            case Kind::GRID:
+                return "grid";
+            case Kind::ANIMATION:
+                return "animation";
+            case Kind::FRAME:
+                return "frame";
+            case Kind::PROPERTIES:
+                return "properties";
+            case Kind::PROPERTY:
+            case Kind::CLASS_MEMBER:
+                return "property";
+            case Kind::ELLIPSE:
+                return "ellipse";
+            case Kind::POINT:
+                return "point";
+            case Kind::POLYGON:
+                return "polygon";
+            case Kind::POLYLINE:
+                return "polyline";
+            case Kind::TEXT:
+                return "text";
+        }
+        return {};
+    }
+
+    class JsonElement : public tmx::internal::Element {
+    public:
+        JsonElement(Document& document, Kind kind, std::uint32_t value)
+            : document(&document), kind(kind), value(value) {}
+
+        void reset(Kind newKind, std::uint32_t newValue) {
+            kind = newKind;
+            value = newValue;
+            children.clear();
+            childrenBuilt = false;
+            nextIndex = 0;
+        }
+
+        [[nodiscard]] std::string_view name() const override { return kindName(kind); }
+
+        [[nodiscard]] std::optional<std::string_view> attribute(std::string_view name) const override {
+            const Document& doc = *document;
+            switch(kind) {
+                case Kind::MAP:
+                    return doc.scalar(value, name == "mapClass" ? "class" : name);
+                case Kind::TILE_LAYER:
+                case Kind::OBJECT_GROUP:
+                case Kind::IMAGE_LAYER:
+                case Kind::GROUP:
+                    if(name == "className") {
+                        return doc.scalar(value, "class");
+                    }
+                    if(name == "drawOrder") {
+                        return doc.scalar(value, "draworder");
+                    }
+                    if(name == "repeatY") {
+                        return doc.scalar(value, "repeaty");
+                    }
+                    return doc.scalar(value, name);
+                case Kind::OBJECT:
+                    if(name == "className") {
+                        auto className = doc.scalar(value, "class");
+                        return className.has_value() ? className : doc.scalar(value, "type");
+                    }
+                    return doc.scalar(value, name);
+                case Kind::TILE:
+                    if(name == "type") {
+                        auto type = doc.scalar(value, "type");
+                        return type.has_value() ? type : doc.scalar(value, "class");
+                    }
+                    return doc.scalar(value, name);
+                case Kind::DATA:
+                    if(name == "encoding") {
+                        auto encoding = doc.scalar(value, "encoding");
+                        return encoding.has_value() ? encoding : "csv";
+                    }
+                    if(name == "compression") {
+                        auto compression = doc.scalar(value, "compression");
+                        return compression.has_value() && !compression->empty() ? compression : std::nullopt;
+                    }
+                    return std::nullopt;
+                case Kind::IMAGE:
+                    if(name == "source") {
+                        return doc.scalar(value, "image");
+                    }
+                    if(name == "width") {
+                        return doc.scalar(value, "imagewidth");
+                    }
+                    if(name == "height") {
+                        return doc.scalar(value, "imageheight");
+                    }
+                    if(name == "trans") {
+                        return doc.scalar(value, "transparentcolor");
+                    }
+                    return std::nullopt;
+                case Kind::CLASS_MEMBER:
+                    return memberAttribute(name);
+                case Kind::POLYGON:
+                case Kind::POLYLINE:
+                    if(name == "points") {
+                        return points();
+                    }
+                    return std::nullopt;
+                case Kind::ELLIPSE:
+                case Kind::POINT:
+                case Kind::ANIMATION:
+                case Kind::PROPERTIES:
+                    return std::nullopt;
+                default:
+                    return doc.scalar(value, name);
+            }
+        }
+
+        [[nodiscard]] std::string_view text() override {
+            childrenBuilt = true;
+            children.clear();
+            if(kind == Kind::TEXT) {
+                return document->scalar(value, "text").value_or("");
+            }
+            if(kind != Kind::DATA) {
+                return {};
+            }
+
+            std::uint32_t data = document->member(value, "data");
+            if(data == NONE) {
+                return {};
+            }
+            const Value& dataValue = (*document)[data];
+            if(dataValue.type == ValueType::NUMBER_ARRAY || dataValue.type == ValueType::STRING) {
+                return dataValue.text;
+            }
+            if(dataValue.type != ValueType::ARRAY) {
+                return {};
+            }
+            std::string csv;
+            for(std::uint32_t child = dataValue.firstChild; child != NONE; child = (*document)[child].next) {
+                if(!csv.empty()) {
+                    csv += ',';
+                }
+                csv += (*document)[child].text;
+            }
+            return document->store(std::move(csv));
+        }
+
+        [[nodiscard]] Element* nextChild() override {
+            buildChildren();
+            if(nextIndex >= children.size()) {
+                return nullptr;
+            }
+            const Child& next = children[nextIndex++];
+            if(child == nullptr) {
+                child = std::make_unique<JsonElement>(*document, next.kind, next.value);
+            } else {
+                child->reset(next.kind, next.value);
+            }
+            return child.get();
+        }
+
+        [[nodiscard]] int childCount(std::initializer_list<std::string_view> names) const override {
+            buildChildren();
+            int count = 0;
+            for(const Child& c : children) {
+                if(std::find(names.begin(), names.end(), kindName(c.kind)) != names.end()) {
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        [[nodiscard]] std::size_t position() const override {
+            if(nextIndex == 0 || children.empty()) {
+                return 0;
+            }
+            return (*document)[children[nextIndex - 1].value].end;
+        }
+
+    private:
+        struct Child {
+            Kind kind;
+            std::uint32_t value;
+        };
+
+        void addChild(Kind childKind, std::uint32_t childValue) const {
+            if(childValue != NONE) {
+                children.push_back({childKind, childValue});
+            }
+        }
+
+        void addArray(std::string_view key, Kind childKind) const {
+            std::uint32_t array = document->member(value, key);
+            if(array == NONE || (*document)[array].type != ValueType::ARRAY) {
+                return;
+            }
+            for(std::uint32_t item = (*document)[array].firstChild; item != NONE; item = (*document)[item].next) {
+                if((*document)[item].type == ValueType::OBJECT) {
+                    children.push_back({childKind, item});
+                }
+            }
+        }
+
+        void addLayers() const {
+            std::uint32_t array = document->member(value, "layers");
+            if(array == NONE) {
+                return;
+            }
+            for(std::uint32_t item = (*document)[array].firstChild; item != NONE; item = (*document)[item].next) {
+                std::string_view type = document->scalar(item, "type").value_or("");
+                if(type == "tilelayer") {
+                    children.push_back({Kind::TILE_LAYER, item});
+                } else if(type == "objectgroup") {
+                    children.push_back({Kind::OBJECT_GROUP, item});
+                } else if(type == "imagelayer") {
+                    children.push_back({Kind::IMAGE_LAYER, item});
+                } else if(type == "group") {
+                    children.push_back({Kind::GROUP, item});
+                }
+            }
+        }
+
+        void addProperties() const {
+            std::uint32_t properties = document->member(value, "properties");
+            if(properties != NONE && (*document)[properties].type == ValueType::ARRAY) {
+                children.push_back({Kind::PROPERTIES, properties});
+            }
+        }
+
+        void addImage() const {
+            if(!document->scalar(value, "image").value_or("").empty()) {
+                children.push_back({Kind::IMAGE, value});
+            }
+        }
+
+        // Children are listed in the order they appear in TMX
+        void buildChildren() const {
+            if(childrenBuilt) {
+                return;
+            }
+            childrenBuilt = true;
+            const Document& doc = *document;
+            switch(kind) {
+                case Kind::MAP:
+                    addProperties();
+                    addArray("tilesets", Kind::TILESET);
+                    addLayers();
+                    break;
+                case Kind::TEMPLATE:
+                    addChild(Kind::TILESET, doc.member(value, "tileset"));
+                    addChild(Kind::OBJECT, doc.member(value, "object"));
+                    break;
+                case Kind::TILESET:
+                    addChild(Kind::TILE_OFFSET, doc.member(value, "tileoffset"));
+                    addChild(Kind::GRID, doc.member(value, "grid"));
+                    addProperties();
+                    addImage();
+                    addArray("tiles", Kind::TILE);
+                    break;
+                case Kind::TILE:
+                    addProperties();
+                    addImage();
+                    addChild(Kind::OBJECT_GROUP, doc.member(value, "objectgroup"));
+                    addChild(Kind::ANIMATION, doc.member(value, "animation"));
+                    break;
+                case Kind::TILE_LAYER:
+                    addProperties();
+                    if(doc.member(value, "data") != NONE) {
+                        children.push_back({Kind::DATA, value});
+                    }
+                    break;
+                case Kind::OBJECT_GROUP:
+                    addProperties();
+                    addArray("objects", Kind::OBJECT);
+                    break;
+                case Kind::IMAGE_LAYER:
+                    addProperties();
+                    addImage();
+                    break;
+                case Kind::GROUP:
+                    addProperties();
+                    addLayers();
+                    break;
+                case Kind::OBJECT:
+                    addProperties();
+                    if(doc.scalar(value, "ellipse") == "true") {
+                        children.push_back({Kind::ELLIPSE, value});
+                    }
+                    if(doc.scalar(value, "point") == "true") {
+                        children.push_back({Kind::POINT, value});
+                    }
+                    addChild(Kind::POLYGON, doc.member(value, "polygon"));
+                    addChild(Kind::POLYLINE, doc.member(value, "polyline"));
+                    addChild(Kind::TEXT, doc.member(value, "text"));
+                    break;
+                case Kind::ANIMATION:
+                    for(std::uint32_t item = doc[value].firstChild; item != NONE; item = doc[item].next) {
+                        children.push_back({Kind::FRAME, item});
+                    }
+                    break;
+                case Kind::PROPERTIES:
+                    // Array of typed properties, or members of a class property value
+                    for(std::uint32_t item = doc[value].firstChild; item != NONE; item = doc[item].next) {
+                        if(doc[value].type == ValueType::OBJECT) {
+                            children.push_back({Kind::CLASS_MEMBER, item});
+                        } else if(doc[item].type == ValueType::OBJECT) {
+                            children.push_back({Kind::PROPERTY, item});
+                        }
+                    }
+                    break;
+                case Kind::PROPERTY: {
+                    std::uint32_t classValue = doc.member(value, "value");
+                    if(classValue != NONE && doc[classValue].type == ValueType::OBJECT) {
+                        children.push_back({Kind::PROPERTIES, classValue});
+                    }
+                    break;
+                }
+                case Kind::CLASS_MEMBER:
+                    if(doc[value].type == ValueType::OBJECT) {
+                        children.push_back({Kind::PROPERTIES, value});
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Class members carry no type, it is inferred from the value
+        [[nodiscard]] std::optional<std::string_view> memberAttribute(std::string_view name) const {
+            const Value& member = (*document)[value];
+            if(name == "name") {
+                return member.key;
+            }
+            if(name == "type") {
+                switch(member.type) {
+                    case ValueType::BOOL:
+                        return "bool";
+                    case ValueType::NUMBER:
+                        return member.text.find_first_of(".eE") == std::string_view::npos ? "int" : "float";
+                    case ValueType::OBJECT:
+                        return "class";
+                    default:
+                        return "string";
+                }
+            }
+            if(name == "value" && member.type != ValueType::OBJECT && member.type != ValueType::ARRAY &&
+                member.type != ValueType::NUL) {
+                return member.text;
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] std::string_view points() const {
+            const Document& doc = *document;
+            std::string result;
+            for(std::uint32_t point = doc[value].firstChild; point != NONE; point = doc[point].next) {
+                if(!result.empty()) {
+                    result += ' ';
+                }
+                result += doc.scalar(point, "x").value_or("0");
+                result += ',';
+                result += doc.scalar(point, "y").value_or("0");
+            }
+            return document->store(std::move(result));
+        }
+
+        Document* document;
+        Kind kind;
+        std::uint32_t value;
+        mutable std::vector<Child> children;
+        mutable bool childrenBuilt = false;
+        std::size_t nextIndex = 0;
+        std::unique_ptr<JsonElement> child;
+    };
+} // namespace
+
+void tmx::internal::parseJsonDocument(
+    const Buffer& data, std::string_view rootName, const std::function<void(Element&)>& callback) {
+    Document document(data.data(), data.data() + data.size());
+    std::uint32_t root = document.parse();
+    if(document[root].type != ValueType::OBJECT) {
+        throw Exception("Missing " + std::string(rootName) + " root element");
+    }
+    std::optional<std::string_view> type = document.scalar(root, "type");
+    if(type.has_value() && *type != rootName) {
+        throw Exception("Missing " + std::string(rootName) + " root element");
+    }
+
+    Kind kind = rootName == "map" ? Kind::MAP : (rootName == "template" ? Kind::TEMPLATE : Kind::TILESET);
+    JsonElement element(document, kind, root);
+    callback(element);
+}
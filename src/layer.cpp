@@ -4,20 +4,19 @@
 
 struct tmx::Layer::Data {
     Type type = Type::EMPTY;
-    std::variant<TileLayer, ImageLayer, ObjectGroup> layer;
+    std::variant<TileLayer, ImageLayer, ObjectGroup, GroupLayer> layer;
 };
 
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Layer)
 
-tmx::Layer::Layer(TileLayer&& layer) : Layer() {
-    d->type = Type::TILE;
-    d->layer = std::move(layer);
-}
+// Data is built around the moved layer, default constructing it first would allocate an empty tile layer
+tmx::Layer::Layer(TileLayer&& layer) : d(Data{.type = Type::TILE, .layer = std::move(layer)}) {}
 
-tmx::Layer::Layer(ObjectGroup&& layer) : Layer() {
-    d->type = Type::OBJECT;
-    d->layer = std::move(layer);
-}
+tmx::Layer::Layer(ImageLayer&& layer) : d(Data{.type = Type::IMAGE, .layer = std::move(layer)}) {}
+
+tmx::Layer::Layer(ObjectGroup&& layer) : d(Data{.type = Type::OBJECT, .layer = std::move(layer)}) {}
+
+tmx::Layer::Layer(GroupLayer&& layer) : d(Data{.type = Type::GROUP, .layer = std::move(layer)}) {}
 
 tmx::Layer::Type tmx::Layer::type() const { return d->type; }
 
@@ -36,6 +35,18 @@ const tmx::ObjectGroup& tmx::Layer::objectGroup() const {
     return std::get<ObjectGroup>(d->layer);
 }
 
+const tmx::GroupLayer& tmx::Layer::groupLayer() const {
+    ensureType(Type::GROUP);
+    return std::get<GroupLayer>(d->layer);
+}
+
+const tmx::internal::AbstractLayer& tmx::Layer::abstractLayer() const {
+    if(d->type == Type::EMPTY) {
+        throw Exception("Attempt to extract layer while storing nothing");
+    }
+    return std::visit([](const auto& layer) -> const internal::AbstractLayer& { return layer; }, d->layer);
+}
+
 void tmx::Layer::ensureType(Type type) const {
     if(d->type != type) {
         throw Exception("Attempt to extract " + typeName(type) + " while storing " + typeName(d->type));
@@ -52,6 +63,8 @@ std::string tmx::Layer::typeName(Type type) {
             return "image layer";
         case Type::OBJECT:
             return "object group";
+        case Type::GROUP:
+            return "group layer";
         default:
             return "unknown";
     }
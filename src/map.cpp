@@ -1,6 +1,17 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "object_template.hpp"
+#include "parse_cache.hpp"
+#include "profiling.hpp"
+#include "xml_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <future>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <tmxpp.hpp>
+#include <unordered_map>
 #include <vector>
 
 struct tmx::Map::Data {
@@ -23,16 +34,42 @@ struct tmx::Map::Data {
 
     std::vector<Tileset> tilesets;
     std::vector<Layer> layers;
+    std::vector<FlatLayer> flatLayers;
+    std::vector<std::filesystem::path> images;
+    // Handles by normalized path
+    std::unordered_map<std::string, int> imageHandles;
 
     std::filesystem::path path;
     LoaderType loader = nullptr;
+    ParseOptions options;
+    std::size_t inputSize = 0;
+    // Normalized paths of object templates used by the map
+    std::vector<std::filesystem::path> templateFiles;
+    // Set while parsing
+    const internal::TemplateContext* templates = nullptr;
+    // Version of the map being reloaded, unchanged layers and tilesets are taken from it
+    const Map* previous = nullptr;
 };
 
-__TMXPP_CLASS_HEADER_IMPL__(tmx, Map)
+tmx::Map::Map() = default;
+tmx::Map::Map(Map&&) noexcept = default;
+tmx::Map& tmx::Map::operator=(Map&&) noexcept = default;
+tmx::Map::~Map() = default;
 
-std::string tmx::Map::version() const { return d->version; }
-std::string tmx::Map::tiledVersion() const { return d->tiledVersion; }
-std::string tmx::Map::className() const { return d->className; }
+tmx::Map::Map(const Map& other) : Properties(other), d(other.d) { flatten(); }
+
+tmx::Map& tmx::Map::operator=(const Map& other) {
+    if(&other != this) {
+        Properties::operator=(other);
+        d = other.d;
+        flatten();
+    }
+    return *this;
+}
+
+const std::string& tmx::Map::version() const { return d->version; }
+const std::string& tmx::Map::tiledVersion() const { return d->tiledVersion; }
+const std::string& tmx::Map::className() const { return d->className; }
 tmx::Map::Orientation tmx::Map::orientation() const { return d->orientation; }
 tmx::Map::RenderOrder tmx::Map::renderOrder() const { return d->renderOrder; }
 int tmx::Map::compressionLevel() const { return d->compressionLevel; }
@@ -49,49 +86,108 @@ bool tmx::Map::infinite() const { return d->infinite; }
 
 const std::vector<tmx::Tileset>& tmx::Map::tilesets() const { return d->tilesets; }
 const std::vector<tmx::Layer>& tmx::Map::layers() const { return d->layers; }
+const std::vector<tmx::FlatLayer>& tmx::Map::flatLayers() const { return d->flatLayers; }
+const std::vector<std::filesystem::path>& tmx::Map::images() const { return d->images; }
 
-void tmx::Map::parseFromData(const std::string& data) {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLError error = doc.Parse(data.c_str());
-    if(error != 0) {
-        throw Exception("XML parse failed (error code " + std::to_string(error) + ")");
-    }
-    parse(doc.FirstChildElement("map"));
+void tmx::Map::parseFromData(const std::string& data, const ParseOptions& options) {
+    parseFromData(Buffer(data.data(), data.size()), options);
 }
 
-void tmx::Map::parseFromFile(const std::filesystem::path& path, const LoaderType& loader) {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLError error = tinyxml2::XML_SUCCESS;
-    if(loader == nullptr) {
-        error = doc.LoadFile(path.string().c_str());
-    } else {
-        error = doc.Parse(loader(path).c_str());
-    }
-    if(error != 0) {
-        throw Exception("XML parse failed (error code " + std::to_string(error) + ")");
+void tmx::Map::parseFromData(const Buffer& data, const ParseOptions& options) {
+    TMXPP_PROFILE_ROOT(options, MAP, d->path.filename().string());
+    TMXPP_PROFILE_BYTES(data.size(), 0);
+    d->options = options;
+    d->inputSize = data.size();
+    checkCancelled();
+    internal::parseDocument(data, options.backend, "map", [this](internal::Element& root) {
+        reportProgress(ParseProgress::Stage::XML_PARSED, 0, 1, root.position());
+        parse(root);
+    });
+    reportProgress(ParseProgress::Stage::FINISHED, 0, 1, d->inputSize);
+}
+
+void tmx::Map::parseFromFile(const std::filesystem::path& path, const LoaderType& loader, const ParseOptions& options) {
+    // Filter predicates can't be part of the cache key, so filtered maps are never cached
+    if(!options.cacheDirectory.empty() && options.layerFilter == nullptr && options.objectFilter == nullptr) {
+        parseFromCache(path, loader, options);
+        return;
     }
+
+    Buffer data = loader != nullptr ? loader(path) : Buffer::fromFile(path);
     d->path = path;
     d->loader = loader;
-    parse(doc.FirstChildElement("map"));
+    parseFromData(data, options);
 }
 
-void tmx::Map::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing map root element");
+void tmx::Map::parseFromCache(
+    const std::filesystem::path& path, const LoaderType& loader, const ParseOptions& options) {
+    internal::ParseCache cache(options, path, loader);
+    if(std::optional<Buffer> baked = cache.lookup()) {
+        d->options = options;
+        checkCancelled();
+        try {
+            loadBakedFromData(*baked);
+            d->path = path;
+            d->loader = loader;
+            d->options = options;
+            d->inputSize = baked->size();
+            reportProgress(ParseProgress::Stage::FINISHED, 0, 1, d->inputSize);
+            return;
+        } catch(const CancelledException&) {
+            throw;
+        } catch(const Exception&) {
+            // Entry written by an incompatible version, parse again and replace it
+            *this = Map();
+        }
     }
 
-    if(root->Attribute("version") != nullptr) {
-        d->version = root->Attribute("version");
+    ParseOptions uncached = options;
+    uncached.cacheDirectory.clear();
+    // Templates are loaded through the tracking loader, so that they become dependencies of the entry
+    uncached.templateCache = nullptr;
+    parseFromFile(path, cache.trackingLoader(), uncached);
+    d->loader = loader;
+    d->options = options;
+    cache.store(bake());
+}
+
+std::future<tmx::Map> tmx::Map::parseFromFileAsync(
+    std::filesystem::path path, LoaderType loader, ParseOptions options) {
+    return std::async(std::launch::async,
+        [path = std::move(path), loader = std::move(loader), options = std::move(options)]() {
+            Map map;
+            map.parseFromFile(path, loader, options);
+            return map;
+        });
+}
+
+void tmx::Map::checkCancelled() const {
+    if(d->options.stopToken.stop_requested()) {
+        throw CancelledException();
     }
-    if(root->Attribute("tiledversion") != nullptr) {
-        d->tiledVersion = root->Attribute("tiledversion");
+}
+
+void tmx::Map::reportProgress(ParseProgress::Stage stage, int index, int count, std::size_t position) const {
+    if(d->options.progress != nullptr) {
+        d->options.progress({.stage = stage,
+            .index = index,
+            .count = count,
+            .bytesParsed = position,
+            .bytesTotal = d->inputSize});
     }
-    if(root->Attribute("mapClass") != nullptr) {
-        d->className = root->Attribute("mapClass");
+    checkCancelled();
+}
+
+void tmx::Map::parse(internal::Element& root) {
+    root.query("version", d->version);
+    root.query("tiledversion", d->tiledVersion);
+    // Older versions of tmxpp documented "mapClass" instead of the "class" attribute written by Tiled
+    if(!root.query("class", d->className)) {
+        root.query("mapClass", d->className);
     }
 
-    if(root->Attribute("orientation") != nullptr) {
-        std::string value = root->Attribute("orientation");
+    std::string value;
+    if(root.query("orientation", value)) {
         if(value == "orthogonal") {
             d->orientation = Orientation::ORTHOGONAL;
         } else if(value == "isometric") {
@@ -105,8 +201,7 @@ void tmx::Map::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    if(root->Attribute("renderorder") != nullptr) {
-        std::string value = root->Attribute("renderorder");
+    if(root.query("renderorder", value)) {
         if(value == "right-down") {
             d->renderOrder = RenderOrder::RIGHT_DOWN;
         } else if(value == "right-up") {
@@ -120,15 +215,14 @@ void tmx::Map::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    root->QueryIntAttribute("compressionlevel", &d->compressionLevel);
-    root->QueryIntAttribute("width", &d->width);
-    root->QueryIntAttribute("height", &d->height);
-    root->QueryIntAttribute("tilewidth", &d->tileWidth);
-    root->QueryIntAttribute("tileheight", &d->tileHeight);
-    root->QueryIntAttribute("hexsidelength", &d->hexSideLength);
+    root.query("compressionlevel", d->compressionLevel);
+    root.query("width", d->width);
+    root.query("height", d->height);
+    root.query("tilewidth", d->tileWidth);
+    root.query("tileheight", d->tileHeight);
+    root.query("hexsidelength", d->hexSideLength);
 
-    if(root->Attribute("staggeraxis") != nullptr) {
-        std::string value = root->Attribute("staggeraxis");
+    if(root.query("staggeraxis", value)) {
         if(value == "x") {
             d->staggerAxis = StaggerAxis::X_AXIS;
         } else if(value == "y") {
@@ -138,8 +232,7 @@ void tmx::Map::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    if(root->Attribute("staggerindex") != nullptr) {
-        std::string value = root->Attribute("staggerindex");
+    if(root.query("staggerindex", value)) {
         if(value == "even") {
             d->staggerIndex = StaggerIndex::EVEN;
         } else if(value == "odd") {
@@ -149,44 +242,424 @@ void tmx::Map::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    root->QueryDoubleAttribute("parallaxoriginx", &d->parallaxOrigin.x);
-    root->QueryDoubleAttribute("parallaxoriginy", &d->parallaxOrigin.y);
+    root.query("parallaxoriginx", d->parallaxOrigin.x);
+    root.query("parallaxoriginy", d->parallaxOrigin.y);
+    root.query("backgroundcolor", d->backgroundColor);
+
+    // Gids of tile objects in templates are resolved against tilesets parsed so far, Tiled writes them before layers
+    TemplateCache cache;
+    internal::TemplateContext templates{.directory = d->path.parent_path(),
+        .loader = d->loader,
+        .cache = d->options.templateCache != nullptr ? d->options.templateCache.get() : &cache,
+        .tilesets = &d->tilesets,
+        .files = &d->templateFiles};
+    d->templates = &templates;
+
+    int tilesetCount = root.childCount({"tileset"});
+    int layerCount = root.childCount({"layer", "imagelayer", "objectgroup", "group"});
+    int tilesetIndex = 0;
+    int layerIndex = 0;
+    // Counts are only known with DOM and JSON readers, the streaming reader reports 0
+    d->tilesets.reserve(static_cast<std::size_t>(tilesetCount));
+    d->layers.reserve(static_cast<std::size_t>(layerCount));
+
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "properties") {
+            if(!d->options.skipProperties) {
+                Properties::parse(*element);
+            }
+        } else if(name == "tileset") {
+            if(!d->options.skipTilesets) {
+                parseTileset(*element);
+            }
+            reportProgress(ParseProgress::Stage::TILESET_LOADED, tilesetIndex++, tilesetCount, root.position());
+        } else if(name == "layer" || name == "imagelayer" || name == "objectgroup" || name == "group") {
+            // Progress is reported for top level layers, a group counts as one
+            parseLayer(*element, d->layers);
+            reportProgress(ParseProgress::Stage::LAYER_PARSED, layerIndex++, layerCount, root.position());
+        }
+    }
+    d->templates = nullptr;
+    flatten();
+}
+
+void tmx::Map::parseLayer(internal::Element& element, std::vector<Layer>& layers) {
+    std::string_view name = element.name();
+    if(name == "layer") {
+        if(acceptLayer(element, LayerType::TILE)) {
+            TMXPP_PROFILE_SCOPE(LAYER, element.attribute("name").value_or(""));
+            TileLayer layer;
+            layer.parse(element, d->options, previousTileLayer(element.intAttribute("id")));
+            layers.emplace_back(std::move(layer));
+        }
+    } else if(name == "imagelayer") {
+        if(acceptLayer(element, LayerType::IMAGE)) {
+            ImageLayer layer;
+            layer.parse(element, d->options);
+            std::filesystem::path directory = d->path.parent_path();
+            layer.registerImages([this, &directory](const Image& image) { return registerImage(image, directory); });
+            layers.emplace_back(std::move(layer));
+        }
+    } else if(name == "objectgroup") {
+        if(acceptLayer(element, LayerType::OBJECT)) {
+            TMXPP_PROFILE_SCOPE(OBJECTS, element.attribute("name").value_or(""));
+            ObjectGroup objectGroup;
+            objectGroup.parse(element, d->options, d->templates);
+            layers.emplace_back(std::move(objectGroup));
+        }
+    } else if(name == "group") {
+        if(acceptLayer(element, LayerType::GROUP)) {
+            GroupLayer group;
+            group.parse(element, d->options,
+                [this](internal::Element& child, std::vector<Layer>& children) { parseLayer(child, children); });
+            layers.emplace_back(std::move(group));
+        }
+    }
+}
+
+void tmx::Map::flatten() {
+    d->flatLayers.clear();
+    auto visit = [this](auto& self, const std::vector<Layer>& layers, const FlatLayer& parent) -> void {
+        for(const Layer& layer : layers) {
+            const internal::AbstractLayer& attributes = layer.abstractLayer();
+            FlatLayer flat = parent;
+            flat.layer = &layer;
+            flat.offset.x += attributes.offset().x;
+            flat.offset.y += attributes.offset().y;
+            flat.opacity *= attributes.opacity();
+            flat.visible = flat.visible && attributes.visible();
+            flat.parallaxFactor.x *= attributes.parallaxFactor().x;
+            flat.parallaxFactor.y *= attributes.parallaxFactor().y;
+            // Color() is what layers without tintcolor attribute have
+            Color tint = attributes.tintColor();
+            if(tint.r != 0 || tint.g != 0 || tint.b != 0 || tint.a != 0) {
+                auto multiply = [](unsigned char a, unsigned char b) {
+                    return static_cast<unsigned char>((static_cast<unsigned int>(a) * b + 127) / 255);
+                };
+                flat.tintColor = {.r = multiply(flat.tintColor.r, tint.r),
+                    .g = multiply(flat.tintColor.g, tint.g),
+                    .b = multiply(flat.tintColor.b, tint.b),
+                    .a = multiply(flat.tintColor.a, tint.a)};
+            }
+
+            if(layer.type() == LayerType::GROUP) {
+                flat.group = &layer.groupLayer();
+                flat.depth++;
+                self(self, layer.groupLayer().layers(), flat);
+            } else {
+                d->flatLayers.push_back(flat);
+            }
+        }
+    };
+    visit(visit, d->layers, FlatLayer());
+}
+
+bool tmx::Map::acceptLayer(const internal::Element& element, LayerType type) const {
+    if(d->options.layerFilter == nullptr) {
+        return true;
+    }
+    return d->options.layerFilter({.type = type,
+        .id = element.intAttribute("id"),
+        .name = element.attribute("name").value_or(""),
+        .className = element.attribute("class").value_or(element.attribute("className").value_or(""))});
+}
+
+void tmx::Map::parseTileset(internal::Element& element) {
+    TMXPP_PROFILE_SCOPE(TILESET, element.attribute("source").value_or(element.attribute("name").value_or("")));
+    Tileset tileset;
+    tileset.parse(element, d->options);
+    if(!tileset.source().empty()) {
+        tileset.loadSource(d->path.parent_path() / tileset.source(), d->loader, d->options,
+            d->previous != nullptr ? d->previous->d->tilesets : std::vector<Tileset>());
+    }
+    // Image paths of external tilesets are relative to the tileset file
+    std::filesystem::path directory = tileset.source().empty() ? d->path.parent_path()
+                                                               : (d->path.parent_path() / tileset.source()).parent_path();
+    tileset.registerImages([this, &directory](const Image& image) { return registerImage(image, directory); });
+    d->tilesets.push_back(std::move(tileset));
+}
+
+int tmx::Map::registerImage(const Image& image, const std::filesystem::path& directory) {
+    if(image.source().empty()) {
+        return -1;
+    }
+    std::filesystem::path path = (directory / image.source()).lexically_normal();
+    auto [it, inserted] = d->imageHandles.try_emplace(path.generic_string(), static_cast<int>(d->images.size()));
+    if(inserted) {
+        d->images.push_back(std::move(path));
+    }
+    return it->second;
+}
+
+void tmx::Map::save(
+    internal::XmlWriter& writer, const SaveOptions& options, const std::vector<std::string>& layerData) const {
+    constexpr std::array<std::string_view, 4> orientationNames = {"orthogonal", "isometric", "staggered", "hexagonal"};
+    constexpr std::array<std::string_view, 4> renderOrderNames = {"right-down", "right-up", "left-down", "left-up"};
+
+    writer.open("map");
+    writer.attribute("version", d->version.empty() ? "1.10" : d->version);
+    writer.attribute("tiledversion", d->tiledVersion, std::string());
+    writer.attribute("class", d->className, std::string());
+    writer.attribute("orientation", orientationNames.at(static_cast<std::size_t>(d->orientation)));
+    writer.attribute("renderorder", renderOrderNames.at(static_cast<std::size_t>(d->renderOrder)));
+    writer.attribute("compressionlevel", d->compressionLevel, -1);
+    writer.attribute("width", d->width);
+    writer.attribute("height", d->height);
+    writer.attribute("tilewidth", d->tileWidth);
+    writer.attribute("tileheight", d->tileHeight);
+    if(d->orientation == Orientation::HEXAGONAL) {
+        writer.attribute("hexsidelength", d->hexSideLength);
+    }
+    if(d->orientation == Orientation::STAGGERED || d->orientation == Orientation::HEXAGONAL) {
+        writer.attribute("staggeraxis", d->staggerAxis == StaggerAxis::X_AXIS ? "x" : "y");
+        writer.attribute("staggerindex", d->staggerIndex == StaggerIndex::EVEN ? "even" : "odd");
+    }
+    writer.attribute("parallaxoriginx", d->parallaxOrigin.x, 0.0);
+    writer.attribute("parallaxoriginy", d->parallaxOrigin.y, 0.0);
+    writer.attribute("backgroundcolor", d->backgroundColor, Color());
+    writer.attribute("infinite", d->infinite);
+    Properties::save(writer);
+
+    for(const Tileset& tileset : d->tilesets) {
+        tileset.save(writer);
+    }
+    std::size_t next = 0;
+    GroupLayer::saveLayers(writer, d->layers, options, layerData, next);
+    writer.close();
+}
+
+const tmx::TileLayer* tmx::Map::previousTileLayer(int id) const {
+    if(d->previous == nullptr || id == 0) {
+        return nullptr;
+    }
+    for(const FlatLayer& flat : d->previous->d->flatLayers) {
+        if(flat.layer->type() == LayerType::TILE && flat.layer->tileLayer().id() == id) {
+            return &flat.layer->tileLayer();
+        }
+    }
+    return nullptr;
+}
+
+void tmx::Map::serialize(internal::BinaryWriter& writer) const {
+    serializeAttributes(writer);
 
-    if(root->Attribute("backgroundcolor") != nullptr) {
-        d->backgroundColor = colorFromString(root->Attribute("backgroundcolor"));
+    writer.write(static_cast<std::uint32_t>(d->images.size()));
+    for(const std::filesystem::path& image : d->images) {
+        writer.write(image.generic_string());
     }
 
-    parseTilesets(root);
-    parseLayers(root);
-    Properties::parse(root->FirstChildElement("properties"));
+    // Kept so that sourceFiles() of a cached map still lists templates
+    writer.write(static_cast<std::uint32_t>(d->templateFiles.size()));
+    for(const std::filesystem::path& file : d->templateFiles) {
+        writer.write(file.generic_string());
+    }
+
+    writer.write(static_cast<std::uint32_t>(d->tilesets.size()));
+    for(const Tileset& tileset : d->tilesets) {
+        tileset.serialize(writer);
+    }
+
+    GroupLayer::serializeLayers(writer, d->layers);
 }
 
-void tmx::Map::parseTilesets(tinyxml2::XMLElement* root) {
-    tinyxml2::XMLElement* element = root->FirstChildElement("tileset");
-    while(element != nullptr) {
-        Tileset tileset;
-        tileset.parse(element);
+void tmx::Map::serializeAttributes(internal::BinaryWriter& writer) const {
+    writer.write(d->version);
+    writer.write(d->tiledVersion);
+    writer.write(d->className);
+    writer.write(d->orientation);
+    writer.write(d->renderOrder);
+    writer.write(d->compressionLevel);
+    writer.write(d->width);
+    writer.write(d->height);
+    writer.write(d->tileWidth);
+    writer.write(d->tileHeight);
+    writer.write(d->hexSideLength);
+    writer.write(d->staggerAxis);
+    writer.write(d->staggerIndex);
+    writer.write(d->parallaxOrigin);
+    writer.write(d->backgroundColor);
+    writer.write(d->infinite);
+    Properties::serialize(writer);
+}
+
+void tmx::Map::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->version);
+    reader.read(d->tiledVersion);
+    reader.read(d->className);
+    reader.read(d->orientation);
+    reader.read(d->renderOrder);
+    reader.read(d->compressionLevel);
+    reader.read(d->width);
+    reader.read(d->height);
+    reader.read(d->tileWidth);
+    reader.read(d->tileHeight);
+    reader.read(d->hexSideLength);
+    reader.read(d->staggerAxis);
+    reader.read(d->staggerIndex);
+    reader.read(d->parallaxOrigin);
+    reader.read(d->backgroundColor);
+    reader.read(d->infinite);
+    Properties::deserialize(reader);
+
+    auto imageCount = reader.read<std::uint32_t>();
+    for(std::uint32_t i = 0; i < imageCount; i++) {
+        auto image = reader.read<std::string>();
+        d->imageHandles.emplace(image, static_cast<int>(i));
+        d->images.emplace_back(std::move(image));
+    }
+
+    auto templateCount = reader.read<std::uint32_t>();
+    for(std::uint32_t i = 0; i < templateCount; i++) {
+        d->templateFiles.emplace_back(reader.read<std::string>());
+    }
+
+    auto tilesetCount = reader.read<std::uint32_t>();
+    for(std::uint32_t i = 0; i < tilesetCount; i++) {
+        d->tilesets.emplace_back().deserialize(reader);
+    }
+
+    GroupLayer::deserializeLayers(reader, d->layers);
+    flatten();
+}
+
+tmx::MapChanges tmx::Map::reload() {
+    if(d->path.empty()) {
+        throw Exception("Map was not loaded from a file");
+    }
+
+    // Reloaded map is parsed next to the current one so unchanged tile data and tilesets can be taken from it.
+    // Cache is bypassed, its entry would make the whole map look new. Stats and callbacks belonged to the first
+    // parse and may not be alive anymore
+    ParseOptions options = d->options;
+    options.cacheDirectory.clear();
+    options.progress = nullptr;
+    options.stats = nullptr;
+    options.scopeBegin = nullptr;
+    options.scopeEnd = nullptr;
+    Map updated;
+    updated.d->previous = this;
+    updated.parseFromFile(d->path, d->loader, options);
+    updated.d->previous = nullptr;
+    updated.d->options = d->options;
+
+    MapChanges changes = updated.changesSince(*this);
+    *this = std::move(updated);
+    return changes;
+}
+
+std::vector<std::filesystem::path> tmx::Map::sourceFiles() const {
+    std::vector<std::filesystem::path> files;
+    if(d->path.empty()) {
+        return files;
+    }
+    files.push_back(d->path);
+    for(const Tileset& tileset : d->tilesets) {
         if(!tileset.source().empty()) {
-            tileset.parseFromFile(d->path.parent_path() / tileset.source(), d->loader);
+            files.push_back(d->path.parent_path() / tileset.source());
         }
-        d->tilesets.push_back(tileset);
-        element = element->NextSiblingElement("tileset");
     }
+    files.insert(files.end(), d->templateFiles.begin(), d->templateFiles.end());
+    return files;
 }
 
-void tmx::Map::parseLayers(tinyxml2::XMLElement* root) {
-    tinyxml2::XMLElement* element = root->FirstChildElement();
-    while(element != nullptr) {
-        std::string name = element->Name();
-        if(name == "layer") {
-            TileLayer layer;
-            layer.parse(element);
-            d->layers.emplace_back(std::move(layer));
-        } else if(name == "objectgroup") {
-            ObjectGroup objectGroup;
-            objectGroup.parse(element);
-            d->layers.emplace_back(std::move(objectGroup));
+tmx::MapChanges tmx::Map::changesSince(const Map& previous) const {
+    auto serialized = [](const auto& object) {
+        internal::BinaryWriter writer;
+        object.serialize(writer);
+        return writer.metadataSection();
+    };
+    auto serializedAttributes = [](const TileLayer& layer) {
+        internal::BinaryWriter writer;
+        layer.serializeAttributes(writer);
+        return writer.metadataSection();
+    };
+
+    MapChanges changes;
+    internal::BinaryWriter attributes;
+    internal::BinaryWriter previousAttributes;
+    serializeAttributes(attributes);
+    previous.serializeAttributes(previousAttributes);
+    changes.mapChanged = attributes.metadataSection() != previousAttributes.metadataSection();
+
+    for(std::size_t i = 0; i < d->tilesets.size(); i++) {
+        if(d->tilesets.size() != previous.d->tilesets.size() ||
+            serialized(d->tilesets[i]) != serialized(previous.d->tilesets[i])) {
+            changes.tilesets.push_back(static_cast<int>(i));
+        }
+    }
+
+    // Layers are matched by id, maps written by old Tiled versions have no ids and are matched by index. Groups
+    // are flattened, so layers moved between groups are still matched and changes of groups show up in the combined
+    // attributes of layers inside them
+    const std::vector<FlatLayer>& before = previous.d->flatLayers;
+    std::vector<bool> matched(before.size(), false);
+    int lastMatch = -1;
+    for(std::size_t i = 0; i < d->flatLayers.size(); i++) {
+        const FlatLayer& flat = d->flatLayers[i];
+        const Layer& layer = *flat.layer;
+        int id = layer.abstractLayer().id();
+        auto match = std::find_if(before.begin(), before.end(), [&](const FlatLayer& old) {
+            if(old.layer->type() != layer.type()) {
+                return false;
+            }
+            if(id == 0) {
+                return &old - before.data() == static_cast<std::ptrdiff_t>(i);
+            }
+            return old.layer->abstractLayer().id() == id;
+        });
+
+        MapChanges::LayerChange change{
+            .index = static_cast<int>(i), .id = id, .type = layer.type(), .dirtyRects = {}};
+        if(match == before.end() || matched[match - before.begin()]) {
+            change.kind = MapChanges::LayerChange::Kind::ADDED;
+            change.attributesChanged = true;
+            if(layer.type() == LayerType::TILE) {
+                const TileLayer& tileLayer = layer.tileLayer();
+                change.dirtyRects.push_back({.x = 0, .y = 0, .width = tileLayer.width(), .height = tileLayer.height()});
+            }
+            changes.layers.push_back(std::move(change));
+            continue;
+        }
+
+        auto oldIndex = static_cast<int>(match - before.begin());
+        matched[oldIndex] = true;
+        if(oldIndex < lastMatch) {
+            changes.orderChanged = true;
+        }
+        lastMatch = std::max(lastMatch, oldIndex);
+
+        const Layer& old = *match->layer;
+        if(layer.type() == LayerType::TILE) {
+            change.attributesChanged = serializedAttributes(layer.tileLayer()) != serializedAttributes(old.tileLayer());
+            change.dirtyRects = layer.tileLayer().changedRects(old.tileLayer());
+        } else if(layer.type() == LayerType::IMAGE) {
+            change.attributesChanged = serialized(layer.imageLayer()) != serialized(old.imageLayer());
+        } else if(layer.type() == LayerType::OBJECT) {
+            change.attributesChanged = serialized(layer.objectGroup()) != serialized(old.objectGroup());
+        }
+        const FlatLayer& oldFlat = *match;
+        change.attributesChanged = change.attributesChanged || flat.offset.x != oldFlat.offset.x ||
+                                   flat.offset.y != oldFlat.offset.y || flat.opacity != oldFlat.opacity ||
+                                   flat.visible != oldFlat.visible || flat.tintColor.r != oldFlat.tintColor.r ||
+                                   flat.tintColor.g != oldFlat.tintColor.g || flat.tintColor.b != oldFlat.tintColor.b ||
+                                   flat.tintColor.a != oldFlat.tintColor.a ||
+                                   flat.parallaxFactor.x != oldFlat.parallaxFactor.x ||
+                                   flat.parallaxFactor.y != oldFlat.parallaxFactor.y;
+        if(change.attributesChanged || !change.dirtyRects.empty()) {
+            changes.layers.push_back(std::move(change));
+        }
+    }
+
+    for(std::size_t i = 0; i < before.size(); i++) {
+        if(!matched[i]) {
+            const Layer& layer = *before[i].layer;
+            changes.layers.push_back({.kind = MapChanges::LayerChange::Kind::REMOVED,
+                .index = static_cast<int>(i),
+                .id = layer.abstractLayer().id(),
+                .type = layer.type(),
+                .dirtyRects = {}});
         }
-        element = element->NextSiblingElement();
     }
+    return changes;
 }
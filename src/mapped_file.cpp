@@ -0,0 +1,95 @@
+#include "mapped_file.hpp"
+#include <tmxpp.hpp>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+tmx::internal::MappedFile::MappedFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        throw Exception("Failed to open file " + path.string());
+    }
+
+    LARGE_INTEGER fileSize;
+    if(GetFileSizeEx(file, &fileSize) == 0) {
+        CloseHandle(file);
+        throw Exception("Failed to get size of file " + path.string());
+    }
+    if(fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(mapping == nullptr) {
+        throw Exception("Failed to map file " + path.string());
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(view == nullptr) {
+        CloseHandle(mapping);
+        throw Exception("Failed to map file " + path.string());
+    }
+
+    ptr = static_cast<const char*>(view);
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+    mapped = true;
+}
+
+tmx::internal::MappedFile::~MappedFile() {
+    if(mapped) {
+        UnmapViewOfFile(ptr);
+        CloseHandle(mapping);
+    }
+}
+
+#else
+
+tmx::internal::MappedFile::MappedFile(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        throw Exception("Failed to open file " + path.string());
+    }
+
+    struct stat info {};
+    if(fstat(fd, &info) != 0) {
+        close(fd);
+        throw Exception("Failed to get size of file " + path.string());
+    }
+    if(info.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) {
+        throw Exception("Failed to map file " + path.string());
+    }
+    madvise(view, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+
+    ptr = static_cast<const char*>(view);
+    length = static_cast<std::size_t>(info.st_size);
+    mapped = true;
+}
+
+tmx::internal::MappedFile::~MappedFile() {
+    if(mapped) {
+        munmap(const_cast<char*>(ptr), length); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+}
+
+#endif
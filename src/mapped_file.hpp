@@ -0,0 +1,33 @@
+#ifndef TMXPP_MAPPED_FILE_HPP
+#define TMXPP_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+
+namespace tmx::internal {
+    class MappedFile;
+}
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+class tmx::internal::MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] const char* data() const noexcept { return ptr; }
+    [[nodiscard]] std::size_t size() const noexcept { return length; }
+
+private:
+    const char* ptr = "";
+    std::size_t length = 0;
+    bool mapped = false;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+#endif // TMXPP_MAPPED_FILE_HPP
@@ -1,5 +1,12 @@
-#include <tinyxml2.h>
-#include <sstream>
+#include "binary.hpp"
+#include "element.hpp"
+#include "object_template.hpp"
+#include "xml_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <memory>
+#include <optional>
 #include <string>
 #include <tmxpp.hpp>
 #include <variant>
@@ -17,49 +24,74 @@ struct tmx::Object::Data {
 
     Type type = Type::EMPTY;
     std::variant<Ellipse, Point, std::vector<Point>, Text> shape;
+
+    // Instances share their template. Size, rotation, gid and visibility are copied from it, name, class, shape
+    // and properties are read from it unless overridden
+    std::shared_ptr<const internal::ObjectTemplate> objectTemplate;
+    std::string templateSource;
+    unsigned int overrides = 0;
 };
 
+namespace {
+    // Fields of an instance that override its template
+    constexpr unsigned int overrideName = 1U << 0U;
+    constexpr unsigned int overrideClass = 1U << 1U;
+    constexpr unsigned int overrideSize = 1U << 2U;
+    constexpr unsigned int overrideRotation = 1U << 3U;
+    constexpr unsigned int overrideGID = 1U << 4U;
+    constexpr unsigned int overrideVisible = 1U << 5U;
+    constexpr unsigned int overrideShape = 1U << 6U;
+} // namespace
+
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Object)
 
 int tmx::Object::id() const { return d->id; }
-std::string tmx::Object::name() const { return d->name; }
-std::string tmx::Object::className() const { return d->className; }
+const std::string& tmx::Object::name() const { return fieldSource(overrideName).name; }
+const std::string& tmx::Object::className() const { return fieldSource(overrideClass).className; }
 tmx::Point tmx::Object::position() const { return d->position; }
 tmx::Point tmx::Object::size() const { return d->size; }
 double tmx::Object::rotation() const { return d->rotation; }
 int tmx::Object::gid() const { return d->gid; }
 bool tmx::Object::visible() const { return d->visible; }
+const std::string& tmx::Object::templateSource() const { return d->templateSource; }
 
-tmx::Object::Type tmx::Object::type() const { return d->type; }
+tmx::Object::Type tmx::Object::type() const { return fieldSource(overrideShape).type; }
 
 tmx::Ellipse tmx::Object::ellipse() const {
     ensureType(Type::ELLIPSE);
-    return std::get<Ellipse>(d->shape);
+    return std::get<Ellipse>(fieldSource(overrideShape).shape);
 }
 
 tmx::Point tmx::Object::point() const {
     ensureType(Type::POINT);
-    return std::get<Point>(d->shape);
+    return std::get<Point>(fieldSource(overrideShape).shape);
 }
 
 const tmx::Polygon& tmx::Object::polygon() const {
     ensureType(Type::POLYGON);
-    return std::get<Polygon>(d->shape);
+    return std::get<Polygon>(fieldSource(overrideShape).shape);
 }
 
 const tmx::Polyline& tmx::Object::polyline() const {
     ensureType(Type::POLYLINE);
-    return std::get<Polyline>(d->shape);
+    return std::get<Polyline>(fieldSource(overrideShape).shape);
 }
 
 const tmx::Text& tmx::Object::text() const {
     ensureType(Type::TEXT);
-    return std::get<Text>(d->shape);
+    return std::get<Text>(fieldSource(overrideShape).shape);
+}
+
+const tmx::Object::Data& tmx::Object::fieldSource(unsigned int field) const {
+    if(d->objectTemplate == nullptr || (d->overrides & field) != 0) {
+        return *d;
+    }
+    return *d->objectTemplate->object.d;
 }
 
 void tmx::Object::ensureType(Type type) const {
-    if(d->type != type) {
-        throw Exception("Attempt to extract " + typeName(type) + " while storing " + typeName(d->type));
+    if(this->type() != type) {
+        throw Exception("Attempt to extract " + typeName(type) + " while storing " + typeName(this->type()));
     }
 }
 
@@ -82,72 +114,291 @@ std::string tmx::Object::typeName(Type type) {
     }
 }
 
-void tmx::Object::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing object root element");
-    }
-
-    if(root->Attribute("name") != nullptr) {
-        d->name = root->Attribute("name");
-    }
-    if(root->Attribute("className") != nullptr) {
-        d->className = root->Attribute("className");
-    }
-
-    root->QueryIntAttribute("id", &d->id);
-    root->QueryDoubleAttribute("x", &d->position.x);
-    root->QueryDoubleAttribute("y", &d->position.y);
-    root->QueryDoubleAttribute("width", &d->size.x);
-    root->QueryDoubleAttribute("height", &d->size.y);
-    root->QueryDoubleAttribute("rotation", &d->rotation);
-    root->QueryIntAttribute("gid", &d->gid);
-    root->QueryBoolAttribute("visible", &d->visible);
-    // TODO: object templates
-
-    if(root->FirstChildElement("ellipse") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("ellipse");
-        Ellipse ellipse;
-        element->QueryDoubleAttribute("x", &ellipse.center.x);
-        element->QueryDoubleAttribute("y", &ellipse.center.y);
-        element->QueryDoubleAttribute("width", &ellipse.size.x);
-        element->QueryDoubleAttribute("height", &ellipse.size.y);
-        d->shape = ellipse;
-        d->type = Type::ELLIPSE;
-    } else if(root->FirstChildElement("point") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("point");
-        Point point;
-        element->QueryDoubleAttribute("x", &point.x);
-        element->QueryDoubleAttribute("y", &point.y);
-        d->shape = point;
-        d->type = Type::POINT;
-    } else if(root->FirstChildElement("polygon") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("polygon");
-        d->shape = parsePoints(element->Attribute("points"));
-        d->type = Type::POLYGON;
-    } else if(root->FirstChildElement("polyline") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("polyline");
-        d->shape = parsePoints(element->Attribute("points"));
-        d->type = Type::POLYLINE;
-    } else if(root->FirstChildElement("text") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("text");
-        d->shape = tmx::Text();
-        std::get<Text>(d->shape).parse(element);
-        d->type = Type::TEXT;
-    }
-
-    Properties::parse(root->FirstChildElement("properties"));
+void tmx::Object::parse(
+    internal::Element& root, const ParseOptions& options, const internal::TemplateContext* templates) {
+    // Templates are resolved in maps only, objects of tile collision shapes keep the attribute as it is
+    std::optional<std::string_view> source = root.attribute("template");
+    if(source.has_value() && templates != nullptr) {
+        d->templateSource = *source;
+        d->objectTemplate = loadTemplate(*templates, *source, options);
+        const internal::ObjectTemplate& objectTemplate = *d->objectTemplate;
+        const Data& base = *objectTemplate.object.d;
+        d->size = base.size;
+        d->rotation = base.rotation;
+        d->visible = base.visible;
+        d->gid = base.gid;
+
+        // Gid of a tile object refers to the template's tileset, which the map includes under its own firstgid
+        if(base.gid != 0 && !objectTemplate.tileset.empty() && !options.skipTilesets) {
+            auto tileset = std::find_if(templates->tilesets->begin(), templates->tilesets->end(),
+                [&templates, &objectTemplate](const Tileset& tileset) {
+                    return !tileset.source().empty() &&
+                           (templates->directory / tileset.source()).lexically_normal() == objectTemplate.tileset;
+                });
+            if(tileset == templates->tilesets->end()) {
+                throw Exception("Tileset " + objectTemplate.tileset.string() + " of template " + d->templateSource +
+                                " is not used by the map");
+            }
+            d->gid = tileset->firstGID() + (base.gid - objectTemplate.firstGID);
+        }
+    }
+
+    if(root.query("name", d->name)) {
+        d->overrides |= overrideName;
+    }
+    // Tiled before 1.9 stored object class as "type"
+    if(root.query("class", d->className) || root.query("type", d->className) ||
+        root.query("className", d->className)) {
+        d->overrides |= overrideClass;
+    }
+    root.query("id", d->id);
+    root.query("x", d->position.x);
+    root.query("y", d->position.y);
+    bool width = root.query("width", d->size.x);
+    bool height = root.query("height", d->size.y);
+    if(width || height) {
+        d->overrides |= overrideSize;
+    }
+    if(root.query("rotation", d->rotation)) {
+        d->overrides |= overrideRotation;
+    }
+    if(root.query("gid", d->gid)) {
+        d->overrides |= overrideGID;
+    }
+    if(root.query("visible", d->visible)) {
+        d->overrides |= overrideVisible;
+    }
+
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "ellipse" || name == "point" || name == "polygon" || name == "polyline" || name == "text") {
+            d->overrides |= overrideShape;
+        }
+        if(name == "ellipse") {
+            Ellipse ellipse;
+            element->query("x", ellipse.center.x);
+            element->query("y", ellipse.center.y);
+            element->query("width", ellipse.size.x);
+            element->query("height", ellipse.size.y);
+            d->shape = ellipse;
+            d->type = Type::ELLIPSE;
+        } else if(name == "point") {
+            Point point;
+            element->query("x", point.x);
+            element->query("y", point.y);
+            d->shape = point;
+            d->type = Type::POINT;
+        } else if(name == "polygon") {
+            d->shape = parsePoints(element->attribute("points").value_or(""));
+            d->type = Type::POLYGON;
+        } else if(name == "polyline") {
+            d->shape = parsePoints(element->attribute("points").value_or(""));
+            d->type = Type::POLYLINE;
+        } else if(name == "text") {
+            // Skipped text objects are dropped by the object group, so shape is left empty
+            if(!options.skipText) {
+                d->shape = tmx::Text();
+                std::get<Text>(d->shape).parse(*element);
+            }
+            d->type = Type::TEXT;
+        } else if(name == "properties" && !options.skipProperties) {
+            Properties::parse(*element);
+        }
+    }
+
+    if(d->objectTemplate != nullptr && !options.skipProperties) {
+        inheritProperties(std::shared_ptr<const Properties>(d->objectTemplate, &d->objectTemplate->object));
+    }
 }
 
-std::vector<tmx::Point> tmx::Object::parsePoints(const std::string& str) {
+std::vector<tmx::Point> tmx::Object::parsePoints(std::string_view str) {
+    // Points are "x,y" pairs separated by spaces, parsing stops at the first malformed one
     std::vector<Point> res;
-    std::stringstream ss;
-    ss << str;
+    res.reserve(static_cast<std::size_t>(std::count(str.begin(), str.end(), ',')));
 
-    Point point;
-    char temp = '\0';
-    while(ss >> point.x >> temp >> point.y) {
-        res.push_back({point.x, point.y});
+    const char* pos = str.data();
+    const char* end = str.data() + str.size();
+    auto skipSpaces = [&pos, end]() {
+        while(pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\t' || *pos == '\r')) {
+            ++pos;
+        }
+    };
+    while(true) {
+        Point point;
+        skipSpaces();
+        auto [afterX, errorX] = std::from_chars(pos, end, point.x);
+        pos = afterX;
+        skipSpaces();
+        if(errorX != std::errc() || pos == end || *pos != ',') {
+            break;
+        }
+        ++pos;
+        skipSpaces();
+        auto [afterY, errorY] = std::from_chars(pos, end, point.y);
+        if(errorY != std::errc()) {
+            break;
+        }
+        pos = afterY;
+        res.push_back(point);
     }
-
     return res;
 }
+
+void tmx::Object::save(internal::XmlWriter& writer) const {
+    // Instances only write what they override, the rest is read from the template again
+    bool instance = d->objectTemplate != nullptr;
+    auto overrides = [this, instance](unsigned int field) { return !instance || (d->overrides & field) != 0; };
+    writer.open("object");
+    writer.attribute("id", d->id);
+    writer.attribute("template", d->templateSource, std::string());
+    if(overrides(overrideName)) {
+        writer.attribute("name", d->name, std::string());
+    }
+    if(overrides(overrideClass)) {
+        writer.attribute("class", d->className, std::string());
+    }
+    if(overrides(overrideGID)) {
+        writer.attribute("gid", d->gid, 0);
+    }
+    writer.attribute("x", d->position.x);
+    writer.attribute("y", d->position.y);
+    if(overrides(overrideSize)) {
+        writer.attribute("width", d->size.x, 0.0);
+        writer.attribute("height", d->size.y, 0.0);
+    }
+    if(overrides(overrideRotation)) {
+        writer.attribute("rotation", d->rotation, 0.0);
+    }
+    if(overrides(overrideVisible)) {
+        writer.attribute("visible", d->visible, true);
+    }
+    Properties::save(writer);
+
+    // Shape elements only carry coordinates when they were present in the source document
+    switch(overrides(overrideShape) ? d->type : Type::EMPTY) {
+        case Type::ELLIPSE: {
+            const auto& ellipse = std::get<Ellipse>(d->shape);
+            writer.open("ellipse");
+            writer.attribute("x", ellipse.center.x, 0.0);
+            writer.attribute("y", ellipse.center.y, 0.0);
+            writer.attribute("width", ellipse.size.x, 0.0);
+            writer.attribute("height", ellipse.size.y, 0.0);
+            writer.close();
+            break;
+        }
+        case Type::POINT: {
+            const auto& point = std::get<Point>(d->shape);
+            writer.open("point");
+            writer.attribute("x", point.x, 0.0);
+            writer.attribute("y", point.y, 0.0);
+            writer.close();
+            break;
+        }
+        case Type::POLYGON:
+        case Type::POLYLINE: {
+            std::string points;
+            std::array<char, 32> buffer{};
+            for(Point point : std::get<std::vector<Point>>(d->shape)) {
+                if(!points.empty()) {
+                    points += ' ';
+                }
+                points.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), point.x).ptr);
+                points += ',';
+                points.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), point.y).ptr);
+            }
+            writer.open(d->type == Type::POLYGON ? "polygon" : "polyline");
+            writer.attribute("points", points);
+            writer.close();
+            break;
+        }
+        case Type::TEXT:
+            // Text skipped while parsing has nothing to write
+            if(std::holds_alternative<Text>(d->shape)) {
+                std::get<Text>(d->shape).save(writer);
+            }
+            break;
+        default:
+            break;
+    }
+    writer.close();
+}
+
+// Instances are written with their template applied, only its source is kept
+void tmx::Object::serialize(internal::BinaryWriter& writer) const {
+    const Data& shape = fieldSource(overrideShape);
+    writer.write(d->id);
+    writer.write(d->templateSource);
+    writer.write(name());
+    writer.write(className());
+    writer.write(d->position);
+    writer.write(d->size);
+    writer.write(d->rotation);
+    writer.write(d->gid);
+    writer.write(d->visible);
+    writer.write(shape.type);
+    switch(shape.type) {
+        case Type::ELLIPSE:
+            writer.write(std::get<Ellipse>(shape.shape).center);
+            writer.write(std::get<Ellipse>(shape.shape).size);
+            break;
+        case Type::POINT:
+            writer.write(std::get<Point>(shape.shape));
+            break;
+        case Type::POLYGON:
+        case Type::POLYLINE:
+            writer.write(static_cast<std::uint32_t>(std::get<std::vector<Point>>(shape.shape).size()));
+            for(Point point : std::get<std::vector<Point>>(shape.shape)) {
+                writer.write(point);
+            }
+            break;
+        case Type::TEXT:
+            std::get<Text>(shape.shape).serialize(writer);
+            break;
+        default:
+            break;
+    }
+    Properties::serialize(writer);
+}
+
+void tmx::Object::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->id);
+    reader.read(d->templateSource);
+    reader.read(d->name);
+    reader.read(d->className);
+    reader.read(d->position);
+    reader.read(d->size);
+    reader.read(d->rotation);
+    reader.read(d->gid);
+    reader.read(d->visible);
+    reader.read(d->type);
+    switch(d->type) {
+        case Type::EMPTY:
+            break;
+        case Type::ELLIPSE: {
+            Ellipse ellipse;
+            reader.read(ellipse.center);
+            reader.read(ellipse.size);
+            d->shape = ellipse;
+            break;
+        }
+        case Type::POINT:
+            d->shape = reader.read<Point>();
+            break;
+        case Type::POLYGON:
+        case Type::POLYLINE: {
+            std::vector<Point> points(reader.readCount<std::uint32_t>(sizeof(Point)));
+            for(Point& point : points) {
+                reader.read(point);
+            }
+            d->shape = std::move(points);
+            break;
+        }
+        case Type::TEXT:
+            d->shape = Text();
+            std::get<Text>(d->shape).deserialize(reader);
+            break;
+        default:
+            throw Exception("Baked map is corrupted");
+    }
+    Properties::deserialize(reader);
+}
@@ -1,5 +1,14 @@
 #include <tmxpp.hpp>
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 struct tmx::ObjectGroup::Data {
@@ -14,15 +23,13 @@ tmx::Color tmx::ObjectGroup::color() const {return d->color;}
 tmx::ObjectGroup::DrawOrder tmx::ObjectGroup::drawOrder() const {return d->drawOrder;}
 const std::vector<tmx::Object>& tmx::ObjectGroup::objects() const { return d->objects; }
 
-void tmx::ObjectGroup::parse(tinyxml2::XMLElement* root) {
+void tmx::ObjectGroup::parse(
+    internal::Element& root, const ParseOptions& options, const internal::TemplateContext* templates) {
     AbstractLayer::parse(root);
+    root.query("color", d->color);
 
-    if(root->Attribute("color") != nullptr) {
-        d->color = colorFromString(root->Attribute("color"));
-    }
-
-    if(root->Attribute("drawOrder") != nullptr) {
-        std::string value = root->Attribute("drawOrder");
+    std::string value;
+    if(root.query("draworder", value) || root.query("drawOrder", value)) {
         if(value == "topdown") {
             d->drawOrder = DrawOrder::TOPDOWN;
         } else if(value == "index") {
@@ -32,11 +39,259 @@ void tmx::ObjectGroup::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    tinyxml2::XMLElement* element = root->FirstChildElement("object");
-    while(element != nullptr) {
-        Object object;
-        object.parse(element);
-        d->objects.push_back(object);
-        element = element->NextSiblingElement("object");
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "object") {
+            if(options.objectFilter != nullptr &&
+                !options.objectFilter({.id = element->intAttribute("id"),
+                    .name = element->attribute("name").value_or(""),
+                    .className = element->attribute("class").value_or(
+                        element->attribute("type").value_or(element->attribute("className").value_or("")))})) {
+                continue;
+            }
+            Object object;
+            object.parse(*element, options, templates);
+            if(options.skipText && object.type() == Object::Type::TEXT) {
+                continue;
+            }
+            d->objects.push_back(std::move(object));
+        } else if(name == "properties" && !options.skipProperties) {
+            Properties::parse(*element);
+        }
+    }
+}
+
+void tmx::ObjectGroup::save(internal::XmlWriter& writer) const {
+    writer.open("objectgroup");
+    AbstractLayer::save(writer);
+    writer.attribute("color", d->color, Color());
+    if(d->drawOrder == DrawOrder::INDEX) {
+        writer.attribute("draworder", "index");
+    }
+    Properties::save(writer);
+    for(const Object& object : d->objects) {
+        object.save(writer);
+    }
+    writer.close();
+}
+
+void tmx::ObjectGroup::serialize(internal::BinaryWriter& writer) const {
+    AbstractLayer::serialize(writer);
+    writer.write(d->color);
+    writer.write(d->drawOrder);
+    writer.write(static_cast<std::uint32_t>(d->objects.size()));
+    for(const Object& object : d->objects) {
+        object.serialize(writer);
+    }
+}
+
+void tmx::ObjectGroup::deserialize(internal::BinaryReader& reader) {
+    AbstractLayer::deserialize(reader);
+    reader.read(d->color);
+    reader.read(d->drawOrder);
+    // Every object starts with its id
+    d->objects.resize(reader.readCount<std::uint32_t>(sizeof(int)));
+    for(Object& object : d->objects) {
+        object.deserialize(reader);
+    }
+}
+
+namespace {
+    constexpr std::uint8_t objectGroupPatch = 'O';
+    constexpr std::uint8_t patchVersion = 1;
+
+    // Objects written by Tiled before 1.0 have no ids and can only be patched as a whole
+    bool hasUniqueIds(const std::vector<tmx::Object>& objects) {
+        std::unordered_set<int> ids;
+        return std::all_of(objects.begin(), objects.end(),
+            [&ids](const tmx::Object& object) { return object.id() != 0 && ids.insert(object.id()).second; });
+    }
+} // namespace
+
+std::string tmx::ObjectGroup::diff(const ObjectGroup& base) const {
+    auto serializedAttributes = [](const ObjectGroup& group) {
+        internal::BinaryWriter writer;
+        group.AbstractLayer::serialize(writer);
+        writer.write(group.d->color);
+        writer.write(group.d->drawOrder);
+        return writer.metadataSection();
+    };
+    auto serialized = [](const Object& object) {
+        internal::BinaryWriter writer;
+        object.serialize(writer);
+        return writer.metadataSection();
+    };
+
+    internal::BinaryWriter writer;
+    writer.write(objectGroupPatch);
+    writer.write(patchVersion);
+    writer.writeVarint(base.d->objects.size());
+
+    std::string attributes = serializedAttributes(*this);
+    bool attributesChanged = attributes != serializedAttributes(base);
+    writer.write(attributesChanged);
+    if(attributesChanged) {
+        writer.write(std::string_view(attributes));
+    }
+
+    bool byId = hasUniqueIds(d->objects) && hasUniqueIds(base.d->objects);
+    writer.write(!byId);
+    if(!byId) {
+        writer.writeVarint(d->objects.size());
+        for(const Object& object : d->objects) {
+            object.serialize(writer);
+        }
+        return writer.metadataSection();
+    }
+
+    std::unordered_map<int, const Object*> before;
+    for(const Object& object : base.d->objects) {
+        before.emplace(object.id(), &object);
+    }
+    std::unordered_set<int> after;
+    std::vector<const Object*> changed;
+    for(const Object& object : d->objects) {
+        after.insert(object.id());
+        auto it = before.find(object.id());
+        if(it == before.end() || serialized(*it->second) != serialized(object)) {
+            changed.push_back(&object);
+        }
+    }
+
+    // Order the base ends up in after removals and appending of new objects, the new order is only sent if it
+    // differs from that
+    std::vector<int> removed;
+    std::vector<int> order;
+    for(const Object& object : base.d->objects) {
+        if(after.contains(object.id())) {
+            order.push_back(object.id());
+        } else {
+            removed.push_back(object.id());
+        }
+    }
+    for(const Object* object : changed) {
+        if(!before.contains(object->id())) {
+            order.push_back(object->id());
+        }
+    }
+    bool orderChanged = !std::equal(order.begin(), order.end(), d->objects.begin(), d->objects.end(),
+        [](int id, const Object& object) { return id == object.id(); });
+
+    writer.writeVarint(removed.size());
+    for(int id : removed) {
+        writer.write(id);
+    }
+    writer.writeVarint(changed.size());
+    for(const Object* object : changed) {
+        object->serialize(writer);
+    }
+    writer.write(orderChanged);
+    if(orderChanged) {
+        for(const Object& object : d->objects) {
+            writer.write(object.id());
+        }
+    }
+    return writer.metadataSection();
+}
+
+void tmx::ObjectGroup::applyPatch(std::string_view patch) {
+    internal::BinaryReader reader(patch, {}, nullptr, "Object group patch");
+    if(reader.read<std::uint8_t>() != objectGroupPatch || reader.read<std::uint8_t>() != patchVersion) {
+        throw Exception("Not an object group patch");
+    }
+    if(reader.readVarint() != d->objects.size()) {
+        throw Exception("Patch was made for a different version of object group " + name());
+    }
+
+    // Patch is read completely before anything is modified, so an invalid one leaves the group as it was
+    std::optional<ObjectGroup> attributes;
+    if(reader.read<bool>()) {
+        auto bytes = reader.read<std::string>();
+        internal::BinaryReader attributeReader(bytes, {}, nullptr, "Object group patch");
+        attributes.emplace();
+        attributes->AbstractLayer::deserialize(attributeReader);
+        attributeReader.read(attributes->d->color);
+        attributeReader.read(attributes->d->drawOrder);
+    }
+
+    if(reader.read<bool>()) {
+        std::vector<Object> objects;
+        for(std::uint64_t count = reader.readVarint(); count > 0; count--) {
+            objects.emplace_back().deserialize(reader);
+        }
+        if(attributes) {
+            static_cast<AbstractLayer&>(*this) = *attributes;
+            d->color = attributes->d->color;
+            d->drawOrder = attributes->d->drawOrder;
+        }
+        d->objects = std::move(objects);
+        return;
+    }
+
+    std::unordered_map<int, std::size_t> indices;
+    for(std::size_t i = 0; i < d->objects.size(); i++) {
+        indices.emplace(d->objects[i].id(), i);
+    }
+    if(indices.size() != d->objects.size()) {
+        throw Exception("Patch was made for a different version of object group " + name());
+    }
+
+    std::unordered_set<int> removed;
+    for(std::uint64_t count = reader.readVarint(); count > 0; count--) {
+        auto id = reader.read<int>();
+        if(!indices.contains(id) || !removed.insert(id).second) {
+            throw Exception("Patch was made for a different version of object group " + name());
+        }
+    }
+    std::unordered_set<int> result;
+    for(const Object& object : d->objects) {
+        if(!removed.contains(object.id())) {
+            result.insert(object.id());
+        }
+    }
+    std::vector<Object> changed;
+    for(std::uint64_t count = reader.readVarint(); count > 0; count--) {
+        Object& object = changed.emplace_back();
+        object.deserialize(reader);
+        if(!indices.contains(object.id()) && !result.insert(object.id()).second) {
+            throw Exception("Object group patch is corrupted");
+        }
+    }
+    std::vector<int> order;
+    if(reader.read<bool>()) {
+        order.resize(result.size());
+        std::unordered_set<int> seen;
+        for(int& id : order) {
+            reader.read(id);
+            if(!result.contains(id) || !seen.insert(id).second) {
+                throw Exception("Object group patch is corrupted");
+            }
+        }
+    }
+
+    if(attributes) {
+        static_cast<AbstractLayer&>(*this) = *attributes;
+        d->color = attributes->d->color;
+        d->drawOrder = attributes->d->drawOrder;
+    }
+    for(Object& object : changed) {
+        auto it = indices.find(object.id());
+        if(it != indices.end()) {
+            d->objects[it->second] = std::move(object);
+        } else {
+            d->objects.push_back(std::move(object));
+        }
+    }
+    if(!removed.empty()) {
+        std::erase_if(d->objects, [&removed](const Object& object) { return removed.contains(object.id()); });
+    }
+    if(!order.empty()) {
+        std::unordered_map<int, std::size_t> position;
+        for(std::size_t i = 0; i < order.size(); i++) {
+            position.emplace(order[i], i);
+        }
+        std::sort(d->objects.begin(), d->objects.end(), [&position](const Object& a, const Object& b) {
+            return position.at(a.id()) < position.at(b.id());
+        });
     }
 }
@@ -0,0 +1,78 @@
+#include "object_template.hpp"
+#include "element.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tmxpp.hpp>
+#include <unordered_map>
+#include <utility>
+
+struct tmx::TemplateCache::Data {
+    mutable std::mutex mutex;
+    // Keyed by normalized path
+    std::unordered_map<std::string, std::shared_ptr<const internal::ObjectTemplate>> templates;
+};
+
+tmx::TemplateCache::TemplateCache() : d(std::make_unique<Data>()) {}
+tmx::TemplateCache::TemplateCache(TemplateCache&& other) noexcept = default;
+tmx::TemplateCache& tmx::TemplateCache::operator=(TemplateCache&& other) noexcept = default;
+tmx::TemplateCache::~TemplateCache() = default;
+
+void tmx::TemplateCache::clear() {
+    std::lock_guard lock(d->mutex);
+    d->templates.clear();
+}
+
+std::size_t tmx::TemplateCache::size() const {
+    std::lock_guard lock(d->mutex);
+    return d->templates.size();
+}
+
+std::shared_ptr<const tmx::internal::ObjectTemplate> tmx::Object::loadTemplate(
+    const internal::TemplateContext& templates, std::string_view source, const ParseOptions& options) {
+    std::filesystem::path path = (templates.directory / std::filesystem::path(source)).lexically_normal();
+    if(templates.files != nullptr && std::find(templates.files->begin(), templates.files->end(), path) ==
+                                          templates.files->end()) {
+        templates.files->push_back(path);
+    }
+
+    if(templates.cache->d == nullptr) {
+        throw Exception("Template cache was moved from");
+    }
+    TemplateCache::Data& cache = *templates.cache->d;
+    std::string key = path.generic_string();
+    {
+        std::lock_guard lock(cache.mutex);
+        auto it = cache.templates.find(key);
+        if(it != cache.templates.end()) {
+            return it->second;
+        }
+    }
+
+    // Parsed outside of the lock, if two maps load the same template at once the first one to finish is kept.
+    // Templates are shared by maps parsed with different options, so only the backend is taken from them
+    Buffer data = templates.loader != nullptr ? templates.loader(path) : Buffer::fromFile(path);
+    ParseOptions templateOptions;
+    templateOptions.backend = options.backend;
+    auto parsed = std::make_shared<internal::ObjectTemplate>();
+    internal::parseDocument(data, options.backend, "template", [&parsed, &path, &templateOptions](
+                                                                   internal::Element& root) {
+        while(internal::Element* element = root.nextChild()) {
+            std::string_view name = element->name();
+            if(name == "tileset") {
+                element->query("firstgid", parsed->firstGID);
+                if(std::optional<std::string_view> tileset = element->attribute("source")) {
+                    parsed->tileset = (path.parent_path() / std::filesystem::path(*tileset)).lexically_normal();
+                }
+            } else if(name == "object") {
+                parsed->object.parse(*element, templateOptions);
+            }
+        }
+    });
+
+    std::lock_guard lock(cache.mutex);
+    return cache.templates.emplace(std::move(key), std::move(parsed)).first->second;
+}
@@ -0,0 +1,29 @@
+#ifndef TMXPP_OBJECT_TEMPLATE_HPP
+#define TMXPP_OBJECT_TEMPLATE_HPP
+
+#include <filesystem>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+// Parsed template file. Object is kept as written in the template, its gid refers to the template's tileset
+struct tmx::internal::ObjectTemplate {
+    Object object;
+    // Normalized path of the external tileset of a tile object, relative paths are relative to the working directory
+    std::filesystem::path tileset;
+    int firstGID = 0;
+};
+
+// What objects of a map need to resolve their templates
+struct tmx::internal::TemplateContext {
+    // Directory of the map, template paths are relative to it
+    std::filesystem::path directory;
+    LoaderType loader;
+    TemplateCache* cache = nullptr;
+    // Tilesets of the map, to translate gids of tile objects
+    const std::vector<Tileset>* tilesets = nullptr;
+    // Normalized paths of templates used by the map
+    std::vector<std::filesystem::path>* files = nullptr;
+};
+
+#endif // TMXPP_OBJECT_TEMPLATE_HPP
@@ -0,0 +1,167 @@
+#include "parse_cache.hpp"
+#include "binary.hpp"
+#include "hash.hpp"
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+// Entry layout: magic "TMXC", u32 version, u64 offset of the baked map, dependency list, baked map aligned
+// to 16 bytes so its tile data can be used in place
+
+namespace {
+
+constexpr std::string_view entryMagic = "TMXC";
+// 2: group and image layers, entries written before them lack those layers. 3: embedded images. 4: template sources
+constexpr std::uint32_t entryVersion = 4;
+constexpr std::size_t headerSize = 16;
+
+std::string hex(std::uint64_t value) {
+    char buffer[16];
+    auto result = std::to_chars(std::begin(buffer), std::end(buffer), value, 16);
+    return {std::begin(buffer), result.ptr};
+}
+
+std::int64_t modifiedTime(const std::filesystem::path& path) {
+    return std::filesystem::last_write_time(path).time_since_epoch().count();
+}
+
+} // namespace
+
+tmx::internal::ParseCache::ParseCache(
+    const ParseOptions& options, const std::filesystem::path& path, LoaderType loader)
+    : directory(options.cacheDirectory),
+      loader(std::move(loader)),
+      dependencies(std::make_shared<std::vector<Dependency>>()) {
+    std::uint64_t flags = (options.skipProperties ? 1U : 0U) | (options.skipText ? 2U : 0U) |
+                          (options.skipTileMetadata ? 4U : 0U) | (options.skipTilesets ? 8U : 0U);
+    std::uint64_t key = hashBytes(std::filesystem::absolute(path).lexically_normal().string(), flags);
+    entryPath = directory / (hex(key) + ".tmxc");
+}
+
+std::optional<tmx::Buffer> tmx::internal::ParseCache::lookup() const {
+    std::error_code error;
+    if(!std::filesystem::exists(entryPath, error)) {
+        return std::nullopt;
+    }
+
+    try {
+        Buffer entry = Buffer::fromFile(entryPath);
+        BinaryReader reader(entry.view(), {}, nullptr);
+        for(char c : entryMagic) {
+            if(reader.read<char>() != c) {
+                return std::nullopt;
+            }
+        }
+        if(reader.read<std::uint32_t>() != entryVersion) {
+            return std::nullopt;
+        }
+
+        auto bakedOffset = reader.read<std::uint64_t>();
+        if(bakedOffset > entry.size()) {
+            return std::nullopt;
+        }
+
+        auto count = reader.read<std::uint32_t>();
+        for(std::uint32_t i = 0; i < count; i++) {
+            Dependency dependency;
+            reader.read(dependency.path);
+            reader.read(dependency.size);
+            reader.read(dependency.modified);
+            reader.read(dependency.hash);
+            if(!isUpToDate(dependency)) {
+                return std::nullopt;
+            }
+        }
+        return Buffer(entry.data() + bakedOffset, entry.size() - bakedOffset, entry.owner());
+    } catch(const std::exception&) {
+        // Unreadable entry or dependency, map is parsed from scratch
+        return std::nullopt;
+    }
+}
+
+tmx::LoaderType tmx::internal::ParseCache::trackingLoader() {
+    return [loader = loader, dependencies = dependencies](const std::filesystem::path& path) {
+        Dependency dependency{.path = path.string()};
+        if(loader == nullptr) {
+            // Taken before reading so that concurrent modification invalidates the entry
+            dependency.modified = modifiedTime(path);
+        }
+        Buffer data = loader != nullptr ? loader(path) : Buffer::fromFile(path);
+        dependency.size = data.size();
+        dependency.hash = hashBytes(data.view());
+        dependencies->push_back(std::move(dependency));
+        return data;
+    };
+}
+
+void tmx::internal::ParseCache::store(std::string_view baked) const {
+    BinaryWriter manifest;
+    manifest.write(static_cast<std::uint32_t>(dependencies->size()));
+    for(const Dependency& dependency : *dependencies) {
+        manifest.write(dependency.path);
+        manifest.write(dependency.size);
+        manifest.write(dependency.modified);
+        manifest.write(dependency.hash);
+    }
+
+    std::size_t bakedOffset = headerSize + manifest.metadataSection().size();
+    bakedOffset = (bakedOffset + BinaryWriter::cellsAlignment - 1) / BinaryWriter::cellsAlignment *
+                  BinaryWriter::cellsAlignment;
+    BinaryWriter header;
+    for(char c : entryMagic) {
+        header.write(c);
+    }
+    header.write(entryVersion);
+    header.write(static_cast<std::uint64_t>(bakedOffset));
+
+    std::string entry;
+    entry.reserve(bakedOffset + baked.size());
+    entry += header.metadataSection();
+    entry += manifest.metadataSection();
+    entry.resize(bakedOffset, '\0');
+    entry += baked;
+
+    // Written to a unique temporary file and renamed, so readers never see a partial entry
+    std::filesystem::path temporaryPath = entryPath;
+    temporaryPath += "." + hex(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "." +
+                     hex(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        if(!file.write(entry.data(), static_cast<std::streamsize>(entry.size()))) {
+            file.close();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, entryPath, error);
+    if(error) {
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+bool tmx::internal::ParseCache::isUpToDate(const Dependency& dependency) const {
+    std::filesystem::path path = dependency.path;
+    if(loader != nullptr) {
+        Buffer data = loader(path);
+        return data.size() == dependency.size && hashBytes(data.view()) == dependency.hash;
+    }
+
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    if(error || size != dependency.size) {
+        return false;
+    }
+    // Same size and modification time is taken as unchanged without reading the file
+    if(modifiedTime(path) == dependency.modified) {
+        return true;
+    }
+    return hashBytes(Buffer::fromFile(path).view()) == dependency.hash;
+}
@@ -0,0 +1,47 @@
+#ifndef TMXPP_PARSE_CACHE_HPP
+#define TMXPP_PARSE_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tmxpp.hpp>
+#include <vector>
+
+namespace tmx::internal {
+    class ParseCache;
+}
+
+// On-disk cache of baked maps keyed by map path. Each entry lists every file read while parsing the map
+// and is only used while all of them are unchanged
+class tmx::internal::ParseCache {
+public:
+    // Entries are separate for each combination of options that changes the parsed map
+    ParseCache(const ParseOptions& options, const std::filesystem::path& path, LoaderType loader);
+
+    // Baked map stored in an up to date entry
+    [[nodiscard]] std::optional<Buffer> lookup() const;
+    // Reads files through the original loader and records them as dependencies of the entry
+    [[nodiscard]] LoaderType trackingLoader();
+    // Writes the entry atomically, failures are ignored as the map is already parsed
+    void store(std::string_view baked) const;
+
+private:
+    struct Dependency {
+        std::string path;
+        std::uint64_t size = 0;
+        std::int64_t modified = 0;
+        std::uint64_t hash = 0;
+    };
+
+    [[nodiscard]] bool isUpToDate(const Dependency& dependency) const;
+
+    std::filesystem::path directory;
+    std::filesystem::path entryPath;
+    LoaderType loader;
+    std::shared_ptr<std::vector<Dependency>> dependencies;
+};
+
+#endif // TMXPP_PARSE_CACHE_HPP
@@ -0,0 +1,108 @@
+#include "profiling.hpp"
+#include <chrono>
+#include <tmxpp.hpp>
+
+namespace {
+    thread_local std::uint64_t allocationCount = 0;
+
+    std::uint64_t now() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+} // namespace
+
+tmx::ParseStats::Scope tmx::ParseStats::total(Phase phase) const {
+    Scope total{.phase = phase, .name = {}};
+    for(const Scope& scope : scopes) {
+        if(scope.phase == phase) {
+            total.nanoseconds += scope.nanoseconds;
+            total.selfNanoseconds += scope.selfNanoseconds;
+            total.bytesIn += scope.bytesIn;
+            total.bytesOut += scope.bytesOut;
+            total.allocations += scope.allocations;
+        }
+    }
+    return total;
+}
+
+void tmx::ParseStats::recordAllocation() noexcept {
+#ifdef TMXPP_PROFILING
+    allocationCount++;
+#endif
+}
+
+struct tmx::internal::ProfileSession {
+    const ParseOptions* options = nullptr;
+    ProfileScope* current = nullptr;
+    int depth = 0;
+};
+
+namespace {
+    // Set while a root scope is alive on the thread
+    thread_local tmx::internal::ProfileSession threadSession;
+    thread_local tmx::internal::ProfileSession* activeSession = nullptr;
+} // namespace
+
+tmx::internal::ProfileScope::ProfileScope(const ParseOptions* options, ParseStats::Phase phase, std::string_view name)
+    : phase(phase) {
+    if(activeSession == nullptr) {
+        if(options == nullptr ||
+            (options->stats == nullptr && options->scopeBegin == nullptr && options->scopeEnd == nullptr)) {
+            return;
+        }
+        threadSession = {.options = options};
+        activeSession = &threadSession;
+        ownsSession = true;
+    }
+    session = activeSession;
+    parent = session->current;
+    session->current = this;
+
+    const ParseOptions& sessionOptions = *session->options;
+    if(sessionOptions.stats != nullptr) {
+        // Scope is reserved now so scopes are listed in the order they began, times are filled in once finished
+        index = static_cast<std::int64_t>(sessionOptions.stats->scopes.size());
+        sessionOptions.stats->scopes.push_back({.phase = phase, .name = std::string(name), .depth = session->depth});
+    }
+    session->depth++;
+    if(sessionOptions.scopeBegin != nullptr) {
+        sessionOptions.scopeBegin(phase, name);
+    }
+    startAllocations = allocationCount;
+    start = now();
+}
+
+tmx::internal::ProfileScope::~ProfileScope() {
+    if(session == nullptr) {
+        return;
+    }
+    std::uint64_t elapsed = now() - start;
+    std::uint64_t allocations = allocationCount - startAllocations;
+    const ParseOptions& options = *session->options;
+    if(options.scopeEnd != nullptr) {
+        options.scopeEnd(phase);
+    }
+    if(options.stats != nullptr) {
+        ParseStats::Scope& scope = options.stats->scopes[static_cast<std::size_t>(index)];
+        scope.nanoseconds = elapsed;
+        scope.selfNanoseconds = elapsed - childNanoseconds;
+        scope.allocations = allocations;
+    }
+    if(parent != nullptr) {
+        parent->childNanoseconds += elapsed;
+    }
+    session->depth--;
+    session->current = parent;
+    if(ownsSession) {
+        activeSession = nullptr;
+    }
+}
+
+void tmx::internal::ProfileScope::setBytes(std::uint64_t in, std::uint64_t out) {
+    if(session != nullptr && session->options->stats != nullptr) {
+        ParseStats::Scope& scope = session->options->stats->scopes[static_cast<std::size_t>(index)];
+        scope.bytesIn = in;
+        scope.bytesOut = out;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef TMXPP_PROFILING_HPP
+#define TMXPP_PROFILING_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <tmxpp.hpp>
+
+namespace tmx::internal {
+    struct ProfileSession;
+
+    // Measures the enclosing block as a ParseStats scope. A scope given options starts profiling on the calling
+    // thread if there is a stats object or callbacks to report to, other scopes are recorded only while it lasts
+    class ProfileScope {
+    public:
+        ProfileScope(const ParseOptions* options, ParseStats::Phase phase, std::string_view name);
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+        ~ProfileScope();
+
+        void setBytes(std::uint64_t in, std::uint64_t out);
+
+    private:
+        ProfileSession* session = nullptr;
+        bool ownsSession = false;
+        ParseStats::Phase phase;
+        std::int64_t index = -1;
+        std::uint64_t start = 0;
+        std::uint64_t startAllocations = 0;
+        std::uint64_t childNanoseconds = 0;
+        ProfileScope* parent = nullptr;
+    };
+} // namespace tmx::internal
+
+// Instrumentation compiles to nothing without TMXPP_PROFILING, arguments are not evaluated then
+#ifdef TMXPP_PROFILING
+#define TMXPP_PROFILE_ROOT(options, phase, name) \
+    tmx::internal::ProfileScope tmxppProfileScope(&(options), tmx::ParseStats::Phase::phase, name)
+#define TMXPP_PROFILE_SCOPE(phase, name) \
+    tmx::internal::ProfileScope tmxppProfileScope(nullptr, tmx::ParseStats::Phase::phase, name)
+#define TMXPP_PROFILE_BYTES(in, out) tmxppProfileScope.setBytes(in, out)
+#else
+#define TMXPP_PROFILE_ROOT(options, phase, name) static_cast<void>(0)
+#define TMXPP_PROFILE_SCOPE(phase, name) static_cast<void>(0)
+#define TMXPP_PROFILE_BYTES(in, out) static_cast<void>(0)
+#endif
+
+#endif
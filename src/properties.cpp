@@ -1,7 +1,12 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
 #include <map>
+#include <memory>
 #include <tmxpp.hpp>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
 struct tmx::PropertyValue::Data {
@@ -22,70 +27,223 @@ int tmx::PropertyValue::objectValue() const { return std::get<int>(d->value); }
 const tmx::Properties& tmx::PropertyValue::classValue() const { return std::get<Properties>(d->value); }
 
 struct tmx::Properties::Data {
+    // Own properties, only the overridden ones when there is a base
     std::map<std::string, PropertyValue> properties;
+    std::shared_ptr<const Properties> base;
+    // Base with own properties applied, only built when both have any, otherwise one of them is used as is
+    std::map<std::string, PropertyValue> merged;
 };
 
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Properties)
 
-bool tmx::Properties::hasProperty(const std::string& name) const { return d->properties.contains(name); }
+bool tmx::Properties::hasProperty(const std::string& name) const {
+    return d->properties.contains(name) || (d->base != nullptr && d->base->hasProperty(name));
+}
 
 const tmx::PropertyValue& tmx::Properties::property(const std::string& name) const {
-    if(!hasProperty(name)) {
-        static PropertyValue emptyValue = PropertyValue();
-        return emptyValue;
+    auto it = d->properties.find(name);
+    if(it != d->properties.end()) {
+        return it->second;
+    }
+    if(d->base != nullptr) {
+        return d->base->property(name);
     }
-    return d->properties.at(name);
+    static PropertyValue emptyValue = PropertyValue();
+    return emptyValue;
 }
 
-const std::map<std::string, tmx::PropertyValue>& tmx::Properties::properties() const { return d->properties; }
+const std::map<std::string, tmx::PropertyValue>& tmx::Properties::properties() const {
+    if(d->base == nullptr || d->base->properties().empty()) {
+        return d->properties;
+    }
+    return d->properties.empty() ? d->base->properties() : d->merged;
+}
 
-void tmx::Properties::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        return;
+void tmx::Properties::inheritProperties(std::shared_ptr<const Properties> base) {
+    d->base = std::move(base);
+    d->merged.clear();
+    if(!d->properties.empty() && !d->base->properties().empty()) {
+        d->merged = d->base->properties();
+        for(const auto& [name, value] : d->properties) {
+            d->merged.insert_or_assign(name, value);
+        }
     }
-    tinyxml2::XMLElement* property = root->FirstChildElement("property");
-    while(property != nullptr) {
-        parseProperty(property);
-        property = property->NextSiblingElement("property");
+}
+
+void tmx::Properties::parse(internal::Element& root) {
+    while(internal::Element* property = root.nextChild()) {
+        if(property->name() == "property") {
+            parseProperty(*property);
+        }
     }
 }
 
-void tmx::Properties::parseProperty(tinyxml2::XMLElement* property) {
-    if(property->Attribute("name") == nullptr) {
+void tmx::Properties::parseProperty(internal::Element& property) {
+    std::string name;
+    if(!property.query("name", name)) {
         throw Exception("Missing property name");
     }
-    if(property->Attribute("value") == nullptr) {
-        throw Exception("Missing property value");
-    }
 
-    std::string name = property->Attribute("name");
     std::string type = "string";
-    if(property->Attribute("type") != nullptr) {
-        type = property->Attribute("type");
-    }
+    property.query("type", type);
     PropertyValue::Data data;
 
-    if(type == "string") {
-        data = {.type = Type::STRING, .value = property->Attribute("value")};
-    } else if(type == "int") {
-        data = {.type = Type::INT, .value = property->IntAttribute("value")};
-    } else if(type == "float") {
-        data = {.type = Type::FLOAT, .value = property->FloatAttribute("value")};
-    } else if(type == "bool") {
-        data = {.type = Type::BOOL, .value = property->BoolAttribute("value")};
-    } else if(type == "color") {
-        // TODO
-    } else if(type == "file") {
-        data = {.type = Type::FILE, .value = std::string(property->Attribute("value"))};
-    } else if(type == "object") {
-        data = {.type = Type::OBJECT, .value = property->IntAttribute("value")};
-    } else if(type == "class") {
+    if(type == "class") {
         Properties properties;
-        properties.parse(property->FirstChildElement("properties"));
-        data = {.type = Type::CLASS, .value = properties};
+        while(internal::Element* element = property.nextChild()) {
+            if(element->name() == "properties") {
+                properties.parse(*element);
+            }
+        }
+        data = {.type = Type::CLASS, .value = std::move(properties)};
+    } else if(type == "string" && !property.hasAttribute("value")) {
+        // Multiline strings are stored as element text
+        data = {.type = Type::STRING, .value = std::string(property.text())};
+    } else {
+        if(!property.hasAttribute("value")) {
+            throw Exception("Missing property value");
+        }
+        if(type == "string") {
+            data = {.type = Type::STRING, .value = std::string(*property.attribute("value"))};
+        } else if(type == "int") {
+            data = {.type = Type::INT, .value = property.intAttribute("value")};
+        } else if(type == "float") {
+            float value = 0;
+            property.query("value", value);
+            data = {.type = Type::FLOAT, .value = value};
+        } else if(type == "bool") {
+            bool value = false;
+            property.query("value", value);
+            data = {.type = Type::BOOL, .value = value};
+        } else if(type == "color") {
+            // Empty value means the color is unset
+            std::string_view value = *property.attribute("value");
+            data = {.type = Type::COLOR, .value = value.empty() ? Color() : colorFromString(std::string(value))};
+        } else if(type == "file") {
+            data = {.type = Type::FILE, .value = std::string(*property.attribute("value"))};
+        } else if(type == "object") {
+            data = {.type = Type::OBJECT, .value = property.intAttribute("value")};
+        }
     }
 
-    PropertyValue value;
-    value.d = internal::DPointer(data);
-    d->properties[name] = value;
+    *d->properties[std::move(name)].d = std::move(data);
+}
+
+void tmx::PropertyValue::serialize(internal::BinaryWriter& writer) const {
+    writer.write(d->type);
+    writer.write(static_cast<std::uint8_t>(d->value.index()));
+    std::visit(
+        [&writer](const auto& value) {
+            if constexpr(std::is_same_v<std::decay_t<decltype(value)>, Properties>) {
+                value.serialize(writer);
+            } else {
+                writer.write(value);
+            }
+        },
+        d->value);
+}
+
+void tmx::PropertyValue::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->type);
+    switch(reader.read<std::uint8_t>()) {
+        case 0:
+            d->value = reader.read<std::string>();
+            break;
+        case 1:
+            d->value = reader.read<int>();
+            break;
+        case 2:
+            d->value = reader.read<float>();
+            break;
+        case 3:
+            d->value = reader.read<bool>();
+            break;
+        case 4:
+            d->value = reader.read<Color>();
+            break;
+        case 5: {
+            Properties properties;
+            properties.deserialize(reader);
+            d->value = std::move(properties);
+            break;
+        }
+        default:
+            throw Exception("Baked map is corrupted");
+    }
+}
+
+// Inherited properties are written as own ones, baked maps don't refer to templates
+void tmx::Properties::serialize(internal::BinaryWriter& writer) const {
+    const std::map<std::string, PropertyValue>& all = properties();
+    writer.write(static_cast<std::uint32_t>(all.size()));
+    for(const auto& [name, value] : all) {
+        writer.write(name);
+        value.serialize(writer);
+    }
+}
+
+void tmx::Properties::deserialize(internal::BinaryReader& reader) {
+    auto count = reader.read<std::uint32_t>();
+    for(std::uint32_t i = 0; i < count; i++) {
+        auto name = reader.read<std::string>();
+        d->properties[name].deserialize(reader);
+    }
+}
+
+// Only own properties are written, inherited ones are part of the template
+void tmx::Properties::save(internal::XmlWriter& writer) const {
+    if(d->properties.empty()) {
+        return;
+    }
+    writer.open("properties");
+    for(const auto& [name, value] : d->properties) {
+        const PropertyValue::Data& data = *value.d;
+        if(data.type == Type::EMPTY) {
+            continue;
+        }
+        writer.open("property");
+        writer.attribute("name", name);
+        switch(data.type) {
+            case Type::STRING:
+                // Multiline strings are stored as element text
+                if(value.stringValue().find('\n') != std::string::npos) {
+                    writer.text(value.stringValue());
+                } else {
+                    writer.attribute("value", value.stringValue());
+                }
+                break;
+            case Type::INT:
+                writer.attribute("type", "int");
+                writer.attribute("value", value.intValue());
+                break;
+            case Type::FLOAT:
+                writer.attribute("type", "float");
+                writer.attribute("value", value.floatValue());
+                break;
+            case Type::BOOL:
+                writer.attribute("type", "bool");
+                writer.attribute("value", value.boolValue() ? "true" : "false");
+                break;
+            case Type::COLOR:
+                writer.attribute("type", "color");
+                writer.attribute("value", value.colorValue());
+                break;
+            case Type::FILE:
+                writer.attribute("type", "file");
+                writer.attribute("value", value.fileValue());
+                break;
+            case Type::OBJECT:
+                writer.attribute("type", "object");
+                writer.attribute("value", value.objectValue());
+                break;
+            case Type::CLASS:
+                writer.attribute("type", "class");
+                value.classValue().save(writer);
+                break;
+            default:
+                break;
+        }
+        writer.close();
+    }
+    writer.close();
 }
@@ -1,5 +1,9 @@
 #include <tmxpp.hpp>
-#include "tinyxml2.h"
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
+#include <array>
+#include <string_view>
 
 struct tmx::Text::Data {
     std::string text;
@@ -18,8 +22,8 @@ struct tmx::Text::Data {
 
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Text)
 
-std::string tmx::Text::text() const { return d->text; }
-std::string tmx::Text::fontFamily() const { return d->fontFamily; }
+const std::string& tmx::Text::text() const { return d->text; }
+const std::string& tmx::Text::fontFamily() const { return d->fontFamily; }
 int tmx::Text::pixelSize() const { return d->pixelSize; }
 bool tmx::Text::wrap() const { return d->wrap; }
 tmx::Color tmx::Text::color() const { return d->color; }
@@ -31,56 +35,93 @@ bool tmx::Text::kerning() const { return d->kerning; }
 tmx::Text::HAlign tmx::Text::halign() const { return d->halign; }
 tmx::Text::VAlign tmx::Text::valign() const { return d->valign; }
 
-void tmx::Text::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing text element");
-    }
-
-    if(root->Value() != nullptr) {
-        d->text = root->Value();
-    }
-    if(root->Attribute("fontfamily") != nullptr) {
-        d->fontFamily = root->Attribute("fontFamily");
-    }
-
-    root->QueryIntAttribute("pixelsize", &d->pixelSize);
-    root->QueryBoolAttribute("wrap", &d->wrap);
-
-    if(root->Attribute("color") != nullptr) {
-        d->color = colorFromString(root->Attribute("color"));
-    }
-
-    root->QueryBoolAttribute("bold", &d->bold);
-    root->QueryBoolAttribute("italic", &d->italic);
-    root->QueryBoolAttribute("underline", &d->underline);
-    root->QueryBoolAttribute("strikeout", &d->strikeout);
-    root->QueryBoolAttribute("kerning", &d->kerning);
+void tmx::Text::parse(internal::Element& root) {
+    root.query("fontfamily", d->fontFamily);
+    root.query("pixelsize", d->pixelSize);
+    root.query("wrap", d->wrap);
+    root.query("color", d->color);
+    root.query("bold", d->bold);
+    root.query("italic", d->italic);
+    root.query("underline", d->underline);
+    root.query("strikeout", d->strikeout);
+    root.query("kerning", d->kerning);
 
-    if(root->Attribute("halign") != nullptr) {
-        std::string halign = root->Attribute("halign");
-        if(halign == "left") {
+    std::string value;
+    if(root.query("halign", value)) {
+        if(value == "left") {
             d->halign = HAlign::LEFT;
-        } else if(halign == "center") {
+        } else if(value == "center") {
             d->halign = HAlign::CENTER;
-        } else if(halign == "right") {
+        } else if(value == "right") {
             d->halign = HAlign::RIGHT;
-        } else if(halign == "justify") {
+        } else if(value == "justify") {
             d->halign = HAlign::JUSTIFY;
         } else {
-            throw Exception("Unknown text halign " + halign);
+            throw Exception("Unknown text halign " + value);
         }
     }
 
-    if(root->Attribute("valign") != nullptr) {
-        std::string valign = root->Attribute("valign");
-        if(valign == "top") {
+    if(root.query("valign", value)) {
+        if(value == "top") {
             d->valign = VAlign::TOP;
-        } else if(valign == "center") {
+        } else if(value == "center") {
             d->valign = VAlign::CENTER;
-        } else if(valign == "bottom") {
+        } else if(value == "bottom") {
             d->valign = VAlign::BOTTOM;
         } else {
-            throw Exception("Unknown text valign " + valign);
+            throw Exception("Unknown text valign " + value);
         }
     }
+
+    d->text = root.text();
+}
+
+void tmx::Text::save(internal::XmlWriter& writer) const {
+    writer.open("text");
+    writer.attribute("fontfamily", d->fontFamily, std::string("sans-serif"));
+    writer.attribute("pixelsize", d->pixelSize, 16);
+    writer.attribute("wrap", d->wrap, false);
+    writer.attribute("color", d->color, Color());
+    writer.attribute("bold", d->bold, false);
+    writer.attribute("italic", d->italic, false);
+    writer.attribute("underline", d->underline, false);
+    writer.attribute("strikeout", d->strikeout, false);
+    writer.attribute("kerning", d->kerning, true);
+
+    constexpr std::array<std::string_view, 4> halignNames = {"left", "center", "right", "justify"};
+    constexpr std::array<std::string_view, 3> valignNames = {"top", "center", "bottom"};
+    writer.attribute("halign", halignNames.at(static_cast<std::size_t>(d->halign)), halignNames[0]);
+    writer.attribute("valign", valignNames.at(static_cast<std::size_t>(d->valign)), valignNames[0]);
+    writer.text(d->text);
+    writer.close();
+}
+
+void tmx::Text::serialize(internal::BinaryWriter& writer) const {
+    writer.write(d->text);
+    writer.write(d->fontFamily);
+    writer.write(d->pixelSize);
+    writer.write(d->wrap);
+    writer.write(d->color);
+    writer.write(d->bold);
+    writer.write(d->italic);
+    writer.write(d->underline);
+    writer.write(d->strikeout);
+    writer.write(d->kerning);
+    writer.write(d->halign);
+    writer.write(d->valign);
+}
+
+void tmx::Text::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->text);
+    reader.read(d->fontFamily);
+    reader.read(d->pixelSize);
+    reader.read(d->wrap);
+    reader.read(d->color);
+    reader.read(d->bold);
+    reader.read(d->italic);
+    reader.read(d->underline);
+    reader.read(d->strikeout);
+    reader.read(d->kerning);
+    reader.read(d->halign);
+    reader.read(d->valign);
 }
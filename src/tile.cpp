@@ -1,12 +1,14 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "xml_writer.hpp"
 #include <tmxpp.hpp>
 
 struct tmx::Tile::Data {
     int id = 0;
     std::string className;
     IntPoint position;
-    int width;
-    int height;
+    int width = 0;
+    int height = 0;
 
     Image image;
     ObjectGroup objectGroup;
@@ -16,49 +18,109 @@ struct tmx::Tile::Data {
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Tile)
 
 int tmx::Tile::id() const { return d->id; }
-std::string tmx::Tile::className() const { return d->className; }
+const std::string& tmx::Tile::className() const { return d->className; }
 tmx::IntPoint tmx::Tile::position() const { return d->position; }
 int tmx::Tile::width() const { return d->width; }
 int tmx::Tile::height() const { return d->height; }
 
-tmx::Image tmx::Tile::image() const { return d->image; }
+const tmx::Image& tmx::Tile::image() const { return d->image; }
 const tmx::ObjectGroup& tmx::Tile::objectGroup() const { return d->objectGroup; }
 const std::vector<tmx::Tile::AnimationFrame>& tmx::Tile::animation() const { return d->animation; }
 
-void tmx::Tile::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing tile element");
+void tmx::Tile::parse(internal::Element& root, const ParseOptions& options) {
+    // Tiled before 1.9 stored tile class as "type"
+    if(!root.query("class", d->className)) {
+        root.query("type", d->className);
     }
+    root.query("id", d->id);
+    root.query("x", d->position.x);
+    root.query("y", d->position.y);
+    root.query("width", d->width);
+    root.query("height", d->height);
 
-    if(root->Attribute("type") != nullptr) {
-        d->className = root->Attribute("type");
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "image") {
+            d->image.parse(*element);
+        } else if(name == "objectgroup") {
+            d->objectGroup.parse(*element, options);
+        } else if(name == "animation") {
+            parseAnimation(*element);
+        } else if(name == "properties" && !options.skipProperties) {
+            Properties::parse(*element);
+        }
     }
+}
 
-    root->QueryIntAttribute("id", &d->id);
-    root->QueryIntAttribute("x", &d->position.x);
-    root->QueryIntAttribute("y", &d->position.y);
-    root->QueryIntAttribute("width", &d->width);
-    root->QueryIntAttribute("height", &d->height);
+void tmx::Tile::registerImages(const internal::ImageRegistry& registry) {
+    d->image.setHandle(registry(d->image));
+}
 
-    if(root->FirstChildElement("image") != nullptr) {
-        d->image.parse(root->FirstChildElement("image"));
+void tmx::Tile::parseAnimation(internal::Element& root) {
+    while(internal::Element* element = root.nextChild()) {
+        if(element->name() == "frame") {
+            AnimationFrame frame;
+            element->query("tileid", frame.id);
+            element->query("duration", frame.duration);
+            d->animation.push_back(frame);
+        }
     }
-    if(root->FirstChildElement("objectgroup") != nullptr) {
-        d->objectGroup.parse(root->FirstChildElement("objectgroup"));
+}
+
+void tmx::Tile::save(internal::XmlWriter& writer) const {
+    writer.open("tile");
+    writer.attribute("id", d->id);
+    writer.attribute("class", d->className, std::string());
+    writer.attribute("x", d->position.x, 0);
+    writer.attribute("y", d->position.y, 0);
+    writer.attribute("width", d->width, 0);
+    writer.attribute("height", d->height, 0);
+    Properties::save(writer);
+    d->image.save(writer);
+    if(!d->objectGroup.objects().empty()) {
+        d->objectGroup.save(writer);
     }
-    if(root->FirstChildElement("animation") != nullptr) {
-        parseAnimation(root->FirstChildElement("animation"));
+    if(!d->animation.empty()) {
+        writer.open("animation");
+        for(const AnimationFrame& frame : d->animation) {
+            writer.open("frame");
+            writer.attribute("tileid", frame.id);
+            writer.attribute("duration", frame.duration);
+            writer.close();
+        }
+        writer.close();
+    }
+    writer.close();
+}
+
+void tmx::Tile::serialize(internal::BinaryWriter& writer) const {
+    writer.write(d->id);
+    writer.write(d->className);
+    writer.write(d->position);
+    writer.write(d->width);
+    writer.write(d->height);
+    d->image.serialize(writer);
+    d->objectGroup.serialize(writer);
+    writer.write(static_cast<std::uint32_t>(d->animation.size()));
+    for(const AnimationFrame& frame : d->animation) {
+        writer.write(frame.id);
+        writer.write(frame.duration);
     }
-    Properties::parse(root->FirstChildElement("properties"));
+    Properties::serialize(writer);
 }
 
-void tmx::Tile::parseAnimation(tinyxml2::XMLElement* root) {
-    tinyxml2::XMLElement* element = root->FirstChildElement("frame");
-    while(element != nullptr) {
-        AnimationFrame frame;
-        element->QueryIntAttribute("tileid", &frame.id);
-        element->QueryIntAttribute("duration", &frame.duration);
-        d->animation.push_back(frame);
-        element = element->NextSiblingElement("frame");
+void tmx::Tile::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->id);
+    reader.read(d->className);
+    reader.read(d->position);
+    reader.read(d->width);
+    reader.read(d->height);
+    d->image.deserialize(reader);
+    d->objectGroup.deserialize(reader);
+    d->animation.resize(reader.readCount<std::uint32_t>(2 * sizeof(int)));
+    for(AnimationFrame& frame : d->animation) {
+        reader.read(frame.id);
+        reader.read(frame.duration);
     }
+    Properties::deserialize(reader);
 }
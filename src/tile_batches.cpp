@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <tmxpp.hpp>
+
+namespace {
+    constexpr std::uint32_t FLIP_H = 0x80000000;
+    constexpr std::uint32_t FLIP_V = 0x40000000;
+    constexpr std::uint32_t FLIP_D = 0x20000000;
+    constexpr std::uint32_t ROTATE_HEX120 = 0x10000000;
+    constexpr std::uint32_t GID_MASK = ~(FLIP_H | FLIP_V | FLIP_D | ROTATE_HEX120);
+
+    // Everything needed to place the quad of a GID, resolved once for all GIDs of the map
+    struct TileQuad {
+        // Index into Data::textures, -1 for GIDs without a tile
+        int texture = -1;
+        float u0 = 0;
+        float v0 = 0;
+        float u1 = 0;
+        float v1 = 0;
+        // Relative to the bottom left corner of the cell's bounding box, y grows downwards
+        float left = 0;
+        float bottom = 0;
+        float width = 0;
+        float height = 0;
+    };
+
+    struct Texture {
+        int tileset = 0;
+        int tile = -1;
+    };
+} // namespace
+
+struct tmx::TileBatches::Data {
+    Data(const Map& map, const BatchOptions& options) : map(&map), options(options), grid(map) {}
+
+    void addTileset(int index, const Tileset& tileset);
+    void resize(const TileLayer& layer);
+
+    const Map* map;
+    BatchOptions options;
+    TileGrid grid;
+    std::vector<TileQuad> quads;
+    std::vector<Texture> textures;
+
+    int layerWidth = 0;
+    int layerHeight = 0;
+    int columns = 0;
+    int rows = 0;
+    std::vector<Chunk> chunks;
+    std::vector<char> dirty;
+};
+
+void tmx::TileBatches::Data::addTileset(int index, const Tileset& tileset) {
+    Point cell = grid.tileSize();
+    IntPoint offset = tileset.tileOffset();
+    auto place = [&](float width, float height, TileQuad& quad) {
+        quad.width = width;
+        quad.height = height;
+        if(tileset.tileRenderSize() == Tileset::TileRenderSize::GRID) {
+            auto scaleX = static_cast<float>(cell.x) / width;
+            auto scaleY = static_cast<float>(cell.y) / height;
+            if(tileset.fillMode() == Tileset::FillMode::PRESERVE_ASPECT_FIT) {
+                scaleX = scaleY = std::min(scaleX, scaleY);
+            }
+            // Tiles that keep their aspect ratio are centered in the cell
+            quad.width = width * scaleX;
+            quad.height = height * scaleY;
+            quad.left = (static_cast<float>(cell.x) - quad.width) / 2;
+            quad.bottom = -(static_cast<float>(cell.y) - quad.height) / 2;
+        }
+        quad.left += static_cast<float>(offset.x);
+        quad.bottom += static_cast<float>(offset.y);
+    };
+    auto store = [this](int gid, const TileQuad& quad) {
+        if(static_cast<std::size_t>(gid) >= quads.size()) {
+            quads.resize(static_cast<std::size_t>(gid) + 1);
+        }
+        quads[gid] = quad;
+    };
+
+    const Image& image = tileset.image();
+    if(image.type() != Image::Type::EMPTY) {
+        if(image.width() <= 0 || image.height() <= 0 || tileset.columns() <= 0) {
+            throw Exception("Size of the image of tileset " + tileset.name() + " is unknown");
+        }
+        auto imageWidth = static_cast<float>(image.width());
+        auto imageHeight = static_cast<float>(image.height());
+        auto width = static_cast<float>(tileset.tileWidth());
+        auto height = static_cast<float>(tileset.tileHeight());
+        auto texture = static_cast<int>(textures.size());
+        textures.push_back({.tileset = index});
+        for(int id = 0; id < tileset.tileCount(); id++) {
+            auto x = static_cast<float>(tileset.margin() + ((id % tileset.columns()) * (tileset.tileWidth() +
+                                                                                          tileset.spacing())));
+            auto y = static_cast<float>(tileset.margin() + ((id / tileset.columns()) * (tileset.tileHeight() +
+                                                                                          tileset.spacing())));
+            TileQuad quad{.texture = texture,
+                .u0 = x / imageWidth,
+                .v0 = y / imageHeight,
+                .u1 = (x + width) / imageWidth,
+                .v1 = (y + height) / imageHeight};
+            place(width, height, quad);
+            store(tileset.firstGID() + id, quad);
+        }
+        return;
+    }
+
+    for(const Tile& tile : tileset.tiles()) {
+        const Image& tileImage = tile.image();
+        if(tileImage.type() == Image::Type::EMPTY) {
+            continue;
+        }
+        if(tileImage.width() <= 0 || tileImage.height() <= 0) {
+            throw Exception(
+                "Size of the image of tile " + std::to_string(tile.id()) + " of " + tileset.name() + " is unknown");
+        }
+        auto imageWidth = static_cast<float>(tileImage.width());
+        auto imageHeight = static_cast<float>(tileImage.height());
+        auto width = static_cast<float>(tile.width() > 0 ? tile.width() : tileImage.width());
+        auto height = static_cast<float>(tile.height() > 0 ? tile.height() : tileImage.height());
+        auto x = static_cast<float>(tile.position().x);
+        auto y = static_cast<float>(tile.position().y);
+        TileQuad quad{.texture = static_cast<int>(textures.size()),
+            .u0 = x / imageWidth,
+            .v0 = y / imageHeight,
+            .u1 = (x + width) / imageWidth,
+            .v1 = (y + height) / imageHeight};
+        textures.push_back({.tileset = index, .tile = tile.id()});
+        place(width, height, quad);
+        store(tileset.firstGID() + tile.id(), quad);
+    }
+}
+
+void tmx::TileBatches::Data::resize(const TileLayer& layer) {
+    layerWidth = layer.width();
+    layerHeight = layer.height();
+    int size = options.chunkSize;
+    columns = (layerWidth + size - 1) / size;
+    rows = (layerHeight + size - 1) / size;
+    chunks.assign(static_cast<std::size_t>(columns) * rows, Chunk());
+    dirty.assign(chunks.size(), 1);
+    for(int y = 0; y < rows; y++) {
+        for(int x = 0; x < columns; x++) {
+            chunks[(y * columns) + x].cells = {.x = x * size,
+                .y = y * size,
+                .width = std::min(size, layerWidth - (x * size)),
+                .height = std::min(size, layerHeight - (y * size))};
+        }
+    }
+}
+
+tmx::TileBatches::TileBatches(const Map& map, const TileLayer& layer, const BatchOptions& options)
+    : d(std::make_unique<Data>(map, options)) {
+    if(options.chunkSize <= 0) {
+        throw Exception("Chunk size must be positive");
+    }
+    for(std::size_t i = 0; i < map.tilesets().size(); i++) {
+        d->addTileset(static_cast<int>(i), map.tilesets()[i]);
+    }
+    d->resize(layer);
+    update(layer);
+}
+
+tmx::TileBatches::TileBatches(TileBatches&& other) noexcept = default;
+tmx::TileBatches& tmx::TileBatches::operator=(TileBatches&& other) noexcept = default;
+tmx::TileBatches::~TileBatches() = default;
+
+const std::vector<tmx::TileBatches::Chunk>& tmx::TileBatches::chunks() const { return d->chunks; }
+int tmx::TileBatches::columns() const { return d->columns; }
+int tmx::TileBatches::rows() const { return d->rows; }
+
+void tmx::TileBatches::markDirty(const MapChanges::Rect& cells) {
+    int left = std::max(cells.x, 0);
+    int top = std::max(cells.y, 0);
+    int right = std::min(cells.x + cells.width, d->layerWidth);
+    int bottom = std::min(cells.y + cells.height, d->layerHeight);
+    int size = d->options.chunkSize;
+    for(int y = top / size; top < bottom && y <= (bottom - 1) / size; y++) {
+        for(int x = left / size; left < right && x <= (right - 1) / size; x++) {
+            d->dirty[(y * d->columns) + x] = 1;
+        }
+    }
+}
+
+void tmx::TileBatches::markAllDirty() {
+    d->quads.clear();
+    d->textures.clear();
+    for(std::size_t i = 0; i < d->map->tilesets().size(); i++) {
+        d->addTileset(static_cast<int>(i), d->map->tilesets()[i]);
+    }
+    std::fill(d->dirty.begin(), d->dirty.end(), 1);
+}
+
+int tmx::TileBatches::update(const TileLayer& layer) {
+    if(layer.width() != d->layerWidth || layer.height() != d->layerHeight) {
+        d->resize(layer);
+    }
+    std::vector<std::size_t> dirty;
+    for(std::size_t i = 0; i < d->dirty.size(); i++) {
+        if(d->dirty[i] != 0) {
+            dirty.push_back(i);
+        }
+    }
+
+    // Same pool of workers as Map::saveToData(), chunks are independent of each other
+    std::atomic<std::size_t> next = 0;
+    auto worker = [this, &layer, &dirty, &next]() {
+        for(std::size_t i = next++; i < dirty.size(); i = next++) {
+            buildChunk(layer, d->chunks[dirty[i]]);
+        }
+    };
+    unsigned int threads = d->options.threads != 0 ? d->options.threads : std::thread::hardware_concurrency();
+    threads = std::max(std::min(threads, static_cast<unsigned int>(dirty.size())), 1U);
+    std::vector<std::future<void>> workers;
+    for(unsigned int i = 1; i < threads; i++) {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for(std::future<void>& future : workers) {
+        future.get();
+    }
+
+    std::fill(d->dirty.begin(), d->dirty.end(), 0);
+    return static_cast<int>(dirty.size());
+}
+
+void tmx::TileBatches::buildChunk(const TileLayer& layer, Chunk& chunk) const {
+    const std::vector<TileQuad>& quads = d->quads;
+    std::span<const std::uint32_t> cells = layer.cells();
+    const MapChanges::Rect& area = chunk.cells;
+
+    // Texture in the upper half and index of the cell in the lower one, sorting groups quads by texture and keeps
+    // them in row order within a texture
+    std::vector<std::uint64_t> keys;
+    keys.reserve(static_cast<std::size_t>(area.width) * area.height);
+    for(int y = area.y; y < area.y + area.height; y++) {
+        for(int x = area.x; x < area.x + area.width; x++) {
+            std::size_t index = (static_cast<std::size_t>(y) * d->layerWidth) + x;
+            std::uint32_t gid = cells[index] & GID_MASK;
+            if(gid < quads.size() && quads[gid].texture >= 0) {
+                keys.push_back((static_cast<std::uint64_t>(quads[gid].texture) << 32U) | index);
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> cellX(keys.size());
+    std::vector<int> cellY(keys.size());
+    for(std::size_t i = 0; i < keys.size(); i++) {
+        auto index = static_cast<std::uint32_t>(keys[i]);
+        cellX[i] = static_cast<int>(index % d->layerWidth);
+        cellY[i] = static_cast<int>(index / d->layerWidth);
+    }
+    std::vector<float> cornerX(keys.size());
+    std::vector<float> cornerY(keys.size());
+    d->grid.tileToPixel(cellX, cellY, cornerX, cornerY);
+    auto cellHeight = static_cast<float>(d->grid.tileSize().y);
+
+    chunk.vertices.resize(keys.size() * 4);
+    chunk.ranges.clear();
+    for(std::size_t i = 0; i < keys.size(); i++) {
+        auto texture = static_cast<int>(keys[i] >> 32U);
+        if(chunk.ranges.empty() || (keys[i - 1] >> 32U) != (keys[i] >> 32U)) {
+            const Texture& source = d->textures[texture];
+            chunk.ranges.push_back(
+                {.tileset = source.tileset, .tile = source.tile, .first = static_cast<std::uint32_t>(i)});
+        }
+        chunk.ranges.back().count++;
+
+        std::uint32_t raw = cells[static_cast<std::uint32_t>(keys[i])];
+        const TileQuad& quad = quads[raw & GID_MASK];
+        // Diagonal flips transpose the image, so its size too
+        bool diagonal = (raw & FLIP_D) != 0;
+        float width = diagonal ? quad.height : quad.width;
+        float height = diagonal ? quad.width : quad.height;
+        float left = cornerX[i] + quad.left;
+        float bottom = cornerY[i] + cellHeight + quad.bottom;
+
+        // Corners in the order top left, top right, bottom right, bottom left. Flips are applied like Tiled does,
+        // diagonal first, then horizontal and vertical
+        std::pair<float, float> uv[4] = {{quad.u0, quad.v0}, {quad.u1, quad.v0}, {quad.u1, quad.v1}, {quad.u0, quad.v1}};
+        if(diagonal) {
+            std::swap(uv[1], uv[3]);
+        }
+        if((raw & FLIP_H) != 0) {
+            std::swap(uv[0], uv[1]);
+            std::swap(uv[3], uv[2]);
+        }
+        if((raw & FLIP_V) != 0) {
+            std::swap(uv[0], uv[3]);
+            std::swap(uv[1], uv[2]);
+        }
+
+        Vertex* vertex = &chunk.vertices[i * 4];
+        vertex[0] = {.x = left, .y = bottom - height, .u = uv[0].first, .v = uv[0].second};
+        vertex[1] = {.x = left + width, .y = bottom - height, .u = uv[1].first, .v = uv[1].second};
+        vertex[2] = {.x = left + width, .y = bottom, .u = uv[2].first, .v = uv[2].second};
+        vertex[3] = {.x = left, .y = bottom, .u = uv[3].first, .v = uv[3].second};
+    }
+    chunk.version++;
+}
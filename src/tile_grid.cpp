@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tmxpp.hpp>
+
+using Orientation = tmx::Map::Orientation;
+
+namespace {
+    // Calls function with the orientation and stagger axis as compile time constants
+    template <typename Function>
+    void dispatch(Orientation orientation, bool staggerX, Function&& function) {
+        using Ortho = std::integral_constant<Orientation, Orientation::ORTHOGONAL>;
+        using Iso = std::integral_constant<Orientation, Orientation::ISOMETRIC>;
+        using Staggered = std::integral_constant<Orientation, Orientation::STAGGERED>;
+        using Hexagonal = std::integral_constant<Orientation, Orientation::HEXAGONAL>;
+        switch(orientation) {
+            case Orientation::ORTHOGONAL:
+                function(Ortho(), std::false_type());
+                break;
+            case Orientation::ISOMETRIC:
+                function(Iso(), std::false_type());
+                break;
+            case Orientation::STAGGERED:
+                staggerX ? function(Staggered(), std::true_type()) : function(Staggered(), std::false_type());
+                break;
+            case Orientation::HEXAGONAL:
+                staggerX ? function(Hexagonal(), std::true_type()) : function(Hexagonal(), std::false_type());
+                break;
+        }
+    }
+
+    void checkSizes(std::size_t x, std::size_t y, std::size_t outX, std::size_t outY) {
+        if(x != y || outX != outY || outX != x) {
+            throw tmx::Exception("Coordinate arrays of a batch differ in size");
+        }
+    }
+
+    // Truncation and a correction for negative values, unlike std::floor it vectorizes without -ffast-math
+    int floorToInt(float value) {
+        auto truncated = static_cast<int>(value);
+        return truncated - static_cast<int>(static_cast<float>(truncated) > value);
+    }
+
+    // Indices of cells placed at index * step + offset with the given size that overlap the open interval from low
+    // to high, limited to the count cells of a layer
+    std::pair<int, int> cellRange(double low, double high, double offset, double step, double size, int count) {
+        double first = std::floor((low - offset - size) / step) + 1;
+        double end = std::ceil((high - offset) / step);
+        return {static_cast<int>(std::clamp(first, 0.0, static_cast<double>(count))),
+            static_cast<int>(std::clamp(end, 0.0, static_cast<double>(count)))};
+    }
+} // namespace
+
+tmx::TileGrid::TileGrid(const Map& map)
+    : gridOrientation(map.orientation()), staggerX(map.staggerAxis() == Map::StaggerAxis::X_AXIS),
+      staggerEven(map.staggerIndex() == Map::StaggerIndex::EVEN ? 1 : 0),
+      mapHeight(static_cast<float>(map.height())) {
+    int width = map.tileWidth();
+    int height = map.tileHeight();
+    int sideLength = 0;
+    // Tiled rounds tiles of staggered and hexagonal maps down to even sizes
+    if(gridOrientation == Orientation::STAGGERED || gridOrientation == Orientation::HEXAGONAL) {
+        width &= ~1;
+        height &= ~1;
+        sideLength = gridOrientation == Orientation::HEXAGONAL ? map.hexSideLength() : 0;
+    }
+    int sideX = staggerX ? sideLength : 0;
+    int sideY = staggerX ? 0 : sideLength;
+    tileWidth = static_cast<float>(width);
+    tileHeight = static_cast<float>(height);
+    sideLengthX = static_cast<float>(sideX);
+    sideLengthY = static_cast<float>(sideY);
+    columnWidth = static_cast<float>(((width - sideX) / 2) + sideX);
+    rowHeight = static_cast<float>(((height - sideY) / 2) + sideY);
+
+    // Tiles are drawn with the bottom left corner of their image at the one of their cell's bounding box. Reach
+    // covers the tiles of every tileset and is negative on sides where all of them stay inside the box
+    parallaxOrigin = map.parallaxOrigin();
+    bool first = true;
+    for(const Tileset& tileset : map.tilesets()) {
+        int drawWidth = tileset.tileWidth();
+        int drawHeight = tileset.tileHeight();
+        if(tileset.tileRenderSize() == Tileset::TileRenderSize::GRID) {
+            drawWidth = width;
+            drawHeight = height;
+        } else {
+            for(const Tile& tile : tileset.tiles()) {
+                if(tile.image().type() != Image::Type::EMPTY) {
+                    drawWidth = std::max(drawWidth, tile.width() > 0 ? tile.width() : tile.image().width());
+                    drawHeight = std::max(drawHeight, tile.height() > 0 ? tile.height() : tile.image().height());
+                }
+            }
+        }
+        IntPoint offset = tileset.tileOffset();
+        auto left = static_cast<float>(-offset.x);
+        auto right = static_cast<float>(offset.x + drawWidth - width);
+        auto up = static_cast<float>(drawHeight - height - offset.y);
+        auto down = static_cast<float>(offset.y);
+        reachLeft = first ? left : std::max(reachLeft, left);
+        reachRight = first ? right : std::max(reachRight, right);
+        reachUp = first ? up : std::max(reachUp, up);
+        reachDown = first ? down : std::max(reachDown, down);
+        first = false;
+    }
+}
+
+tmx::Map::Orientation tmx::TileGrid::orientation() const { return gridOrientation; }
+
+int tmx::TileGrid::neighborCount() const { return gridOrientation == Orientation::HEXAGONAL ? 6 : 4; }
+
+tmx::Point tmx::TileGrid::tileSize() const { return {.x = tileWidth, .y = tileHeight}; }
+
+tmx::Point tmx::TileGrid::tileToPixel(IntPoint tile) const {
+    float x = 0;
+    float y = 0;
+    tileToPixel(std::span<const int>(&tile.x, 1), std::span<const int>(&tile.y, 1), std::span<float>(&x, 1),
+        std::span<float>(&y, 1));
+    return {.x = x, .y = y};
+}
+
+tmx::IntPoint tmx::TileGrid::pixelToTile(Point pixel) const {
+    auto x = static_cast<float>(pixel.x);
+    auto y = static_cast<float>(pixel.y);
+    IntPoint tile;
+    pixelToTile(std::span<const float>(&x, 1), std::span<const float>(&y, 1), std::span<int>(&tile.x, 1),
+        std::span<int>(&tile.y, 1));
+    return tile;
+}
+
+void tmx::TileGrid::tileToPixel(
+    std::span<const int> x, std::span<const int> y, std::span<float> pixelX, std::span<float> pixelY) const {
+    checkSizes(x.size(), y.size(), pixelX.size(), pixelY.size());
+    dispatch(gridOrientation, staggerX, [&](auto orientation, auto alongX) {
+        tileToPixel<decltype(orientation)::value, decltype(alongX)::value>(
+            x.data(), y.data(), pixelX.data(), pixelY.data(), x.size());
+    });
+}
+
+void tmx::TileGrid::pixelToTile(
+    std::span<const float> x, std::span<const float> y, std::span<int> tileX, std::span<int> tileY) const {
+    checkSizes(x.size(), y.size(), tileX.size(), tileY.size());
+    dispatch(gridOrientation, staggerX, [&](auto orientation, auto alongX) {
+        pixelToTile<decltype(orientation)::value, decltype(alongX)::value>(
+            x.data(), y.data(), tileX.data(), tileY.data(), x.size());
+    });
+}
+
+void tmx::TileGrid::neighbors(
+    std::span<const int> x, std::span<const int> y, std::span<int> neighborX, std::span<int> neighborY) const {
+    // Offset of every neighbor from tiles that are not shifted followed by the one from shifted tiles. Isometric
+    // tile coordinates form the same grid as orthogonal ones
+    static constexpr std::array<IntPoint, 8> grid = {
+        {{-1, 0}, {-1, 0}, {1, 0}, {1, 0}, {0, -1}, {0, -1}, {0, 1}, {0, 1}}};
+    static constexpr std::array<IntPoint, 12> columns = {
+        {{-1, -1}, {-1, 0}, {1, -1}, {1, 0}, {-1, 0}, {-1, 1}, {1, 0}, {1, 1}, {0, -1}, {0, -1}, {0, 1}, {0, 1}}};
+    static constexpr std::array<IntPoint, 12> rows = {
+        {{-1, -1}, {0, -1}, {0, -1}, {1, -1}, {-1, 1}, {0, 1}, {0, 1}, {1, 1}, {-1, 0}, {-1, 0}, {1, 0}, {1, 0}}};
+
+    std::size_t count = x.size();
+    checkSizes(count * neighborCount(), y.size() * neighborCount(), neighborX.size(), neighborY.size());
+    const IntPoint* offsets = grid.data();
+    if(gridOrientation == Orientation::STAGGERED || gridOrientation == Orientation::HEXAGONAL) {
+        offsets = staggerX ? columns.data() : rows.data();
+    }
+    for(int k = 0; k < neighborCount(); k++) {
+        int* outX = neighborX.data() + (k * count);
+        int* outY = neighborY.data() + (k * count);
+        if(staggerX) {
+            neighbors<true>(x.data(), y.data(), outX, outY, count, offsets + (2 * k));
+        } else {
+            neighbors<false>(x.data(), y.data(), outX, outY, count, offsets + (2 * k));
+        }
+    }
+}
+
+void tmx::TileGrid::visibleCells(
+    const Map& map, Point position, Point size, std::vector<VisibleCells>& result) const {
+    std::size_t count = 0;
+    const std::vector<FlatLayer>& layers = map.flatLayers();
+    for(std::size_t i = 0; i < layers.size(); i++) {
+        const FlatLayer& flat = layers[i];
+        if(!flat.visible || flat.layer->type() != Layer::Type::TILE) {
+            continue;
+        }
+        if(count == result.size()) {
+            result.emplace_back();
+        }
+        VisibleCells& cells = result[count++];
+        cells.layer = static_cast<int>(i);
+        cells.spans.clear();
+
+        // Parallax moves a layer along with the camera by the part of the camera's movement that its factor
+        // leaves out, measured from the parallax origin to the center of the view
+        Point center = {.x = position.x + (size.x / 2), .y = position.y + (size.y / 2)};
+        cells.offset = {.x = flat.offset.x + ((1 - flat.parallaxFactor.x) * (center.x - parallaxOrigin.x)),
+            .y = flat.offset.y + ((1 - flat.parallaxFactor.y) * (center.y - parallaxOrigin.y))};
+
+        // View in pixels of the layer, grown by how far tiles may be drawn out of their cells
+        double left = position.x - cells.offset.x - reachRight;
+        double right = position.x + size.x - cells.offset.x + reachLeft;
+        double top = position.y - cells.offset.y - reachDown;
+        double bottom = position.y + size.y - cells.offset.y + reachUp;
+
+        const TileLayer& layer = flat.layer->tileLayer();
+        int width = layer.width();
+        int height = layer.height();
+        double halfWidth = tileWidth / 2.0;
+        double halfHeight = tileHeight / 2.0;
+        switch(gridOrientation) {
+            case Orientation::ORTHOGONAL: {
+                auto [firstX, endX] = cellRange(left, right, 0, tileWidth, tileWidth, width);
+                auto [firstY, endY] = cellRange(top, bottom, 0, tileHeight, tileHeight, height);
+                for(int y = firstY; y < endY && firstX < endX; y++) {
+                    cells.spans.push_back({.y = y, .x = firstX, .end = endX});
+                }
+                break;
+            }
+            case Orientation::ISOMETRIC: {
+                // Cell bounding boxes are at (x - y + height - 1) * halfWidth, (x + y) * halfHeight, so the view
+                // limits x - y and x + y
+                double originX = (mapHeight - 1) * halfWidth;
+                double minDifference = std::floor((left - tileWidth - originX) / halfWidth) + 1;
+                double endDifference = std::ceil((right - originX) / halfWidth);
+                double minSum = std::floor((top - tileHeight) / halfHeight) + 1;
+                double endSum = std::ceil(bottom / halfHeight);
+                auto rows = static_cast<double>(height);
+                auto columns = static_cast<double>(width);
+                auto firstY = static_cast<int>(std::clamp(std::floor((minSum - endDifference) / 2), 0.0, rows));
+                auto endY = static_cast<int>(std::clamp(std::ceil((endSum - minDifference) / 2) + 1, 0.0, rows));
+                for(int y = firstY; y < endY; y++) {
+                    double first = std::max({minDifference + y, minSum - y, 0.0});
+                    double end = std::min({endDifference + y, endSum - y, columns});
+                    if(first < end) {
+                        cells.spans.push_back({.y = y, .x = static_cast<int>(first), .end = static_cast<int>(end)});
+                    }
+                }
+                break;
+            }
+            case Orientation::STAGGERED:
+            case Orientation::HEXAGONAL: {
+                int even = staggerEven;
+                if(!staggerX) {
+                    auto [firstY, endY] = cellRange(top, bottom, 0, rowHeight, tileHeight, height);
+                    for(int y = firstY; y < endY; y++) {
+                        double shift = ((y & 1) ^ even) * columnWidth;
+                        auto [firstX, endX] = cellRange(left, right, shift, tileWidth + sideLengthX, tileWidth, width);
+                        if(firstX < endX) {
+                            cells.spans.push_back({.y = y, .x = firstX, .end = endX});
+                        }
+                    }
+                    break;
+                }
+
+                // Columns shifted down by half a row and the others see different rows
+                auto [firstX, endX] = cellRange(left, right, 0, columnWidth, tileWidth, width);
+                std::pair<int, int> rows[2];
+                for(int shifted = 0; shifted < 2; shifted++) {
+                    rows[shifted] =
+                        cellRange(top, bottom, shifted * rowHeight, tileHeight + sideLengthY, tileHeight, height);
+                }
+                int firstY = std::min(rows[0].first, rows[1].first);
+                int endY = std::max(rows[0].second, rows[1].second);
+                for(int y = firstY; y < endY; y++) {
+                    for(int shifted = 0; shifted < 2; shifted++) {
+                        int x = firstX + (((firstX & 1) ^ even) != shifted ? 1 : 0);
+                        if(y >= rows[shifted].first && y < rows[shifted].second && x < endX) {
+                            cells.spans.push_back({.y = y, .x = x, .end = endX, .step = 2});
+                        }
+                    }
+                }
+                break;
+            }
+        }
+    }
+    result.resize(count);
+}
+
+// Constants are copied to locals so writes to the output arrays can't alias them, which keeps loops vectorizable
+
+template <tmx::Map::Orientation orientation, bool alongX>
+void tmx::TileGrid::tileToPixel(const int* x, const int* y, float* pixelX, float* pixelY, std::size_t count) const {
+    const float width = tileWidth;
+    const float height = tileHeight;
+    const float halfWidth = tileWidth / 2;
+    const float halfHeight = tileHeight / 2;
+    // Left edge of tile 0, 0 on isometric maps, the map extends mapHeight tiles to the left of its top corner
+    const float originX = (mapHeight - 1) * halfWidth;
+    const float columnStep = tileWidth + sideLengthX;
+    const float rowStep = tileHeight + sideLengthY;
+    const float column = columnWidth;
+    const float row = rowHeight;
+    const int even = staggerEven;
+
+    for(std::size_t i = 0; i < count; i++) {
+        auto fx = static_cast<float>(x[i]);
+        auto fy = static_cast<float>(y[i]);
+        if constexpr(orientation == Orientation::ORTHOGONAL) {
+            pixelX[i] = fx * width;
+            pixelY[i] = fy * height;
+        } else if constexpr(orientation == Orientation::ISOMETRIC) {
+            pixelX[i] = ((fx - fy) * halfWidth) + originX;
+            pixelY[i] = (fx + fy) * halfHeight;
+        } else if constexpr(alongX) {
+            // Staggered columns are shifted down by half a row
+            auto shift = static_cast<float>((x[i] & 1) ^ even);
+            pixelX[i] = fx * column;
+            pixelY[i] = (fy * rowStep) + (shift * row);
+        } else {
+            auto shift = static_cast<float>((y[i] & 1) ^ even);
+            pixelX[i] = (fx * columnStep) + (shift * column);
+            pixelY[i] = fy * row;
+        }
+    }
+}
+
+template <tmx::Map::Orientation orientation, bool alongX>
+void tmx::TileGrid::pixelToTile(const float* x, const float* y, int* tileX, int* tileY, std::size_t count) const {
+    if constexpr(orientation == Orientation::ORTHOGONAL) {
+        const float width = tileWidth;
+        const float height = tileHeight;
+        for(std::size_t i = 0; i < count; i++) {
+            tileX[i] = floorToInt(x[i] / width);
+            tileY[i] = floorToInt(y[i] / height);
+        }
+    } else if constexpr(orientation == Orientation::ISOMETRIC) {
+        const float width = tileWidth;
+        const float height = tileHeight;
+        const float topX = mapHeight * tileWidth / 2;
+        for(std::size_t i = 0; i < count; i++) {
+            float column = (x[i] - topX) / width;
+            float row = y[i] / height;
+            tileX[i] = floorToInt(row + column);
+            tileY[i] = floorToInt(row - column);
+        }
+    } else {
+        // Major axis is the staggered one. The pixel lies between the centers of two lines of tiles along it, the
+        // nearest tile of each line is found by rounding and the nearer of the two wins. Hexagons are compared by
+        // distance to their center, diamonds of staggered maps by a distance scaled to the tile size so the tile
+        // containing the pixel is the nearest one
+        const float majorStep = alongX ? columnWidth : rowHeight;
+        const float minorStep = alongX ? tileHeight + sideLengthY : tileWidth + sideLengthX;
+        const float minorShift = alongX ? rowHeight : columnWidth;
+        const float majorHalf = (alongX ? tileWidth : tileHeight) / 2;
+        const float minorHalf = (alongX ? tileHeight : tileWidth) / 2;
+        const int even = staggerEven;
+
+        auto nearest = [&](float major, float minor, int line, int& index) {
+            float shift = static_cast<float>((line & 1) ^ even) * minorShift;
+            index = floorToInt(((minor - shift - minorHalf) / minorStep) + 0.5F);
+            float majorDistance = major - ((static_cast<float>(line) * majorStep) + majorHalf);
+            float minorDistance = minor - ((static_cast<float>(index) * minorStep) + shift + minorHalf);
+            if constexpr(orientation == Orientation::HEXAGONAL) {
+                return (majorDistance * majorDistance) + (minorDistance * minorDistance);
+            } else {
+                return (std::abs(majorDistance) * minorHalf) + (std::abs(minorDistance) * majorHalf);
+            }
+        };
+
+        for(std::size_t i = 0; i < count; i++) {
+            float major = alongX ? x[i] : y[i];
+            float minor = alongX ? y[i] : x[i];
+            int first = floorToInt((major - majorHalf) / majorStep);
+            int firstIndex = 0;
+            int secondIndex = 0;
+            float firstDistance = nearest(major, minor, first, firstIndex);
+            float secondDistance = nearest(major, minor, first + 1, secondIndex);
+            int line = secondDistance < firstDistance ? first + 1 : first;
+            int index = secondDistance < firstDistance ? secondIndex : firstIndex;
+            tileX[i] = alongX ? line : index;
+            tileY[i] = alongX ? index : line;
+        }
+    }
+}
+
+template <bool alongX>
+void tmx::TileGrid::neighbors(
+    const int* x, const int* y, int* neighborX, int* neighborY, std::size_t count, const IntPoint* offset) const {
+    const int even = staggerEven;
+    const IntPoint plain = offset[0];
+    const IntPoint shifted = {.x = offset[1].x - offset[0].x, .y = offset[1].y - offset[0].y};
+    for(std::size_t i = 0; i < count; i++) {
+        int shift = ((alongX ? x[i] : y[i]) & 1) ^ even;
+        neighborX[i] = x[i] + plain.x + (shift * shifted.x);
+        neighborY[i] = y[i] + plain.y + (shift * shifted.y);
+    }
+}
@@ -1,8 +1,23 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "hash.hpp"
+#include "profiling.hpp"
+#include "xml_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
-#include <iostream>
-#include <sstream>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 #include <tmxpp.hpp>
 
 #ifdef TMXPP_BASE64
@@ -19,20 +34,58 @@
 #endif
 
 struct tmx::TileLayer::Data {
-    std::vector<std::vector<unsigned int>> data;
+    // Shared between copies of the layer. Cells are immutable once decoded, owner keeps them alive, it is
+    // either a vector filled by the decoder or a memory mapped baked map
+    struct State {
+        std::once_flag decoded;
+        std::string payload;
+        const std::uint32_t* cells = nullptr;
+        std::shared_ptr<const void> owner;
+        // Cells owned by a vector of this state, patches are applied to them in place when the state isn't shared
+        std::uint32_t* writableCells = nullptr;
+
+        std::once_flag rowsBuilt;
+        std::vector<std::vector<unsigned int>> rows;
+    };
+
     int width = 0;
     int height = 0;
     std::string encoding;
     std::string compression;
+    // Hash of the encoded data as it appeared in the document, 0 if unknown. Lets reloading skip decoding
+    std::uint64_t dataHash = 0;
+    std::shared_ptr<State> state = std::make_shared<State>();
 };
 
 __TMXPP_CLASS_HEADER_IMPL__(tmx, TileLayer)
 
-const std::vector<std::vector<unsigned int>>& tmx::TileLayer::data() const { return d->data; }
+const std::vector<std::vector<unsigned int>>& tmx::TileLayer::data() const {
+    ensureDecoded();
+    std::call_once(d->state->rowsBuilt, [this]() {
+        if(d->state->cells == nullptr) {
+            return;
+        }
+        d->state->rows.resize(d->height);
+        for(int y = 0; y < d->height; y++) {
+            const std::uint32_t* row = d->state->cells + (static_cast<std::size_t>(y) * d->width);
+            d->state->rows[y].assign(row, row + d->width);
+        }
+    });
+    return d->state->rows;
+}
+
+std::span<const std::uint32_t> tmx::TileLayer::cells() const {
+    ensureDecoded();
+    if(d->state->cells == nullptr) {
+        return {};
+    }
+    return {d->state->cells, static_cast<std::size_t>(d->width) * d->height};
+}
+
 int tmx::TileLayer::width() const { return d->width; }
 int tmx::TileLayer::height() const { return d->height; }
-std::string tmx::TileLayer::encoding() const { return d->encoding; }
-std::string tmx::TileLayer::compression() const { return d->compression; }
+const std::string& tmx::TileLayer::encoding() const { return d->encoding; }
+const std::string& tmx::TileLayer::compression() const { return d->compression; }
 
 static constexpr unsigned int FLIP_H = 0x80000000;
 static constexpr unsigned int FLIP_V = 0x40000000;
@@ -41,27 +94,50 @@ static constexpr unsigned int ROTATE_HEX120 = 0x10000000;
 
 int tmx::TileLayer::at(int x, int y) const {
     checkBounds(x, y);
-    return static_cast<int>(d->data[y][x] & ~(FLIP_H | FLIP_V | FLIP_D | ROTATE_HEX120));
+    return static_cast<int>(cell(x, y) & ~(FLIP_H | FLIP_V | FLIP_D | ROTATE_HEX120));
 }
 
 bool tmx::TileLayer::flipHorizontal(int x, int y) const {
     checkBounds(x, y);
-    return (d->data[y][x] & FLIP_H) != 0;
+    return (cell(x, y) & FLIP_H) != 0;
 }
 
 bool tmx::TileLayer::flipVertical(int x, int y) const {
     checkBounds(x, y);
-    return (d->data[y][x] & FLIP_V) != 0;
+    return (cell(x, y) & FLIP_V) != 0;
 }
 
 bool tmx::TileLayer::flipDiagonal(int x, int y) const {
     checkBounds(x, y);
-    return (d->data[y][x] & FLIP_D) != 0;
+    return (cell(x, y) & FLIP_D) != 0;
 }
 
 bool tmx::TileLayer::rotateHex120(int x, int y) const {
     checkBounds(x, y);
-    return (d->data[y][x] & ROTATE_HEX120) != 0;
+    return (cell(x, y) & ROTATE_HEX120) != 0;
+}
+
+std::uint32_t tmx::TileLayer::cell(int x, int y) const {
+    ensureDecoded();
+    return d->state->cells[(static_cast<std::size_t>(y) * d->width) + x];
+}
+
+void tmx::TileLayer::ensureDecoded() const {
+    std::call_once(d->state->decoded, [this]() {
+        // Default constructed layers have no data to decode
+        if(!d->encoding.empty() && d->state->cells == nullptr) {
+            decode(d->state->payload);
+            std::string().swap(d->state->payload);
+        }
+    });
+}
+
+void tmx::TileLayer::setCells(const std::uint32_t* cells, std::shared_ptr<const void> owner) {
+    d->state = std::make_shared<Data::State>();
+    std::call_once(d->state->decoded, [this, cells, &owner]() {
+        d->state->cells = cells;
+        d->state->owner = std::move(owner);
+    });
 }
 
 void tmx::TileLayer::checkBounds(int x, int y) const {
@@ -75,91 +151,134 @@ void tmx::TileLayer::checkBounds(int x, int y) const {
     }
 }
 
-void tmx::TileLayer::parse(tinyxml2::XMLElement* root) {
+void tmx::TileLayer::parse(internal::Element& root, const ParseOptions& options, const TileLayer* previous) {
     AbstractLayer::parse(root);
-    root->QueryIntAttribute("width", &d->width);
-    root->QueryIntAttribute("height", &d->height);
-    parseData(root->FirstChildElement("data"));
-}
+    root.query("width", d->width);
+    root.query("height", d->height);
 
-void tmx::TileLayer::parseData(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
+    bool hasData = false;
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "data") {
+            parseData(*element, options.lazyTileData, previous);
+            hasData = true;
+        } else if(name == "properties" && !options.skipProperties) {
+            Properties::parse(*element);
+        }
+    }
+    if(!hasData) {
         throw Exception("Missing layer data element for " + name());
     }
+}
 
-    if(root->Attribute("encoding") == nullptr) {
+void tmx::TileLayer::parseData(internal::Element& root, bool lazy, const TileLayer* previous) {
+    if(!root.query("encoding", d->encoding)) {
         throw Exception("Layer data is stored as XML elements, this is deprecated and unsupported by neotmx");
     }
-    d->encoding = root->Attribute("encoding");
+    root.query("compression", d->compression);
+
+    if(d->width < 0 || d->height < 0) {
+        throw Exception("Invalid size of layer " + name());
+    }
+    if(d->encoding != "csv" && d->encoding != "base64") {
+        throw Exception("Unknown encoding " + d->encoding);
+    }
 
-    if(root->Attribute("compression") != nullptr) {
-        d->compression = root->Attribute("compression");
+    std::string_view text = root.text();
+    d->dataHash = internal::hashBytes(text);
+    if(previous != nullptr && previous->d->dataHash == d->dataHash && previous->d->width == d->width &&
+        previous->d->height == d->height && previous->d->encoding == d->encoding &&
+        previous->d->compression == d->compression) {
+        // Same data as in the previous version of the map, its cells are shared instead of decoded again
+        d->state = previous->d->state;
+        return;
     }
 
-    d->data.assign(d->height, std::vector<unsigned int>(d->width, 0));
+    d->state = std::make_shared<Data::State>();
+    if(lazy) {
+        d->state->payload = text;
+    } else {
+        std::call_once(d->state->decoded, [this, text]() { decode(text); });
+    }
+}
+
+void tmx::TileLayer::decode(std::string_view str) const {
+    TMXPP_PROFILE_SCOPE(DECODE, name());
+    TMXPP_PROFILE_BYTES(str.size(), static_cast<std::uint64_t>(d->width) * d->height * sizeof(std::uint32_t));
+    auto cells = std::make_shared<std::vector<std::uint32_t>>(static_cast<std::size_t>(d->width) * d->height);
     if(d->encoding == "csv") {
-        parseCSVData(root->GetText());
-    } else if(d->encoding == "base64") {
+        parseCSVData(str, cells->data());
+    } else {
 #ifdef TMXPP_BASE64
-        parseBase64Data(root->GetText());
+        parseBase64Data(str, cells->data());
 #else
         throw Exception("Tilemap uses base64 encoding, but tmxpp was build without base64 support");
 #endif
-    } else {
-        throw Exception("Unknown encoding " + d->encoding);
     }
+    d->state->cells = cells->data();
+    d->state->writableCells = cells->data();
+    d->state->owner = std::move(cells);
 }
 
-void tmx::TileLayer::parseCSVData(const std::string& str) {
-    std::stringstream ss;
-    ss << str;
+static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+void tmx::TileLayer::parseCSVData(std::string_view str, std::uint32_t* cells) const {
+    const char* pos = str.data();
+    const char* end = str.data() + str.size();
     for(int y = 0; y < d->height; y++) {
         for(int x = 0; x < d->width; x++) {
+            while(pos != end && isSpace(*pos)) {
+                ++pos;
+            }
             unsigned int value = 0;
-            if(!(ss >> value)) {
+            auto [next, error] = std::from_chars(pos, end, value);
+            if(error != std::errc()) {
                 throw Exception("Wrong data format for layer " + name());
             }
-            d->data[y][x] = value;
+            pos = next;
+            *cells++ = value;
             if(x != d->width - 1 || y != d->height - 1) {
-                char temp = '\0';
-                if(!(ss >> temp)) {
+                while(pos != end && isSpace(*pos)) {
+                    ++pos;
+                }
+                if(pos == end || *pos != ',') {
                     throw Exception("Wrong data format for layer " + name());
                 }
+                ++pos;
             }
         }
     }
 }
 
-void tmx::TileLayer::parseBase64Data(const std::string& str) {
+void tmx::TileLayer::parseBase64Data(std::string_view str, std::uint32_t* cells) const {
 #ifdef TMXPP_BASE64
-    auto begin = str.begin();
-    auto end = str.end();
-    while(*begin == ' ' || *begin == '\n' || *begin == '\t') {
-        ++begin;
+    while(!str.empty() && isSpace(str.front())) {
+        str.remove_prefix(1);
     }
-    while(*std::prev(end, 1) == ' ' || *std::prev(end, 1) == '\n' || *std::prev(end, 1) == '\t') {
-        --end;
+    while(!str.empty() && isSpace(str.back())) {
+        str.remove_suffix(1);
     }
 
-    std::string data = base64::from_base64(std::string_view(begin, end));
+    std::string data = base64::from_base64(str);
     if(!d->compression.empty()) {
-        data = decompressData(data, d->compression);
+        TMXPP_PROFILE_SCOPE(DECOMPRESS, name());
+        std::string decompressed = decompressData(data, d->compression);
+        TMXPP_PROFILE_BYTES(data.size(), decompressed.size());
+        data = std::move(decompressed);
     }
 
-    if(static_cast<int>(data.size()) < d->width * d->height * 4) {
+    std::size_t count = static_cast<std::size_t>(d->width) * d->height;
+    if(data.size() / 4 < count) {
         throw Exception("Wrong data format for layer " + name());
     }
-
-    int pos = 0;
-    for(int y = 0; y < d->height; y++) {
-        for(int x = 0; x < d->width; x++) {
-            uint32_t value = 0;
-            value |= static_cast<uint32_t>(data[pos]);
-            value |= static_cast<uint32_t>(data[pos + 1]) << 8U;
-            value |= static_cast<uint32_t>(data[pos + 2]) << 16U;
-            value |= static_cast<uint32_t>(data[pos + 3]) << 24U;
-            d->data[y][x] = value;
-            pos += 4;
+    if constexpr(std::endian::native == std::endian::little) {
+        std::memcpy(cells, data.data(), count * 4);
+    } else {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+        for(std::size_t i = 0; i < count; i++) {
+            cells[i] = static_cast<uint32_t>(bytes[4 * i]) | (static_cast<uint32_t>(bytes[(4 * i) + 1]) << 8U) |
+                       (static_cast<uint32_t>(bytes[(4 * i) + 2]) << 16U) |
+                       (static_cast<uint32_t>(bytes[(4 * i) + 3]) << 24U);
         }
     }
 #endif
@@ -220,4 +339,417 @@ std::string tmx::TileLayer::decompressData(std::string& str, const std::string&
 
     throw Exception("Unsupported compression " + compression);
 }
+std::string tmx::TileLayer::compressData(std::string_view str, const SaveOptions& options) {
+    if(options.compression == SaveOptions::Compression::ZSTD) {
+#ifdef TMXPP_ZSTD
+        int level = options.compressionLevel == -1 ? ZSTD_CLEVEL_DEFAULT : options.compressionLevel;
+        std::string res(ZSTD_compressBound(str.size()), '\0');
+        size_t size = ZSTD_compress(res.data(), res.size(), str.data(), str.size(), level);
+        if(ZSTD_isError(size)) {
+            throw Exception(std::string("zstd compress failed (") + ZSTD_getErrorName(size) + ")");
+        }
+        res.resize(size);
+        return res;
+#else
+        throw Exception("Tilemap uses zstd compression, but tmxpp was build without zstd support");
+#endif
+    }
+
+#ifdef TMXPP_ZLIB
+    int level = options.compressionLevel == -1 ? Z_DEFAULT_COMPRESSION : options.compressionLevel;
+    bool gzip = options.compression == SaveOptions::Compression::GZIP;
+    z_stream defStream;
+    memset(&defStream, 0, sizeof(defStream));
+    if(deflateInit2(&defStream, level, Z_DEFLATED, gzip ? 16 + MAX_WBITS : MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw Exception("zlib deflateInit failed");
+    }
+    std::string res(deflateBound(&defStream, str.size()), '\0');
+    defStream.avail_in = str.size();
+    defStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
+    defStream.avail_out = res.size();
+    defStream.next_out = reinterpret_cast<Bytef*>(res.data());
+    int result = deflate(&defStream, Z_FINISH);
+    deflateEnd(&defStream);
+    if(result != Z_STREAM_END) {
+        throw Exception("zlib compress failed (error code " + std::to_string(result) + ")");
+    }
+    res.resize(defStream.total_out);
+    return res;
+#else
+    throw Exception("Tilemap uses zlib compression, but tmxpp was built without zlib support");
+#endif
+}
 // NOLINTEND
+
+namespace {
+    // Every 12 bits of input map to a pair of output characters, so three bytes take two table lookups
+    constexpr std::array<std::array<char, 2>, 4096> base64Pairs = []() {
+        constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::array<std::array<char, 2>, 4096> table{};
+        for(std::size_t i = 0; i < table.size(); i++) {
+            table[i] = {alphabet[i >> 6U], alphabet[i & 0x3FU]};
+        }
+        return table;
+    }();
+
+    // Decimal text of GIDs below 10000 with its length in the last byte. Real maps rarely go beyond that, so
+    // CSV output is mostly a copy of four bytes per cell without branching on the number of digits
+    constexpr std::size_t csvTableSize = 10000;
+    constexpr std::array<std::array<char, 5>, csvTableSize> csvNumbers = []() {
+        std::array<std::array<char, 5>, csvTableSize> table{};
+        for(std::size_t i = 0; i < table.size(); i++) {
+            std::size_t length = i >= 1000 ? 4 : (i >= 100 ? 3 : (i >= 10 ? 2 : 1));
+            for(std::size_t value = i, digit = length; digit > 0; value /= 10, digit--) {
+                table[i][digit - 1] = static_cast<char>('0' + (value % 10));
+            }
+            table[i][4] = static_cast<char>(length);
+        }
+        return table;
+    }();
+
+    char* writeNumber(char* out, std::uint32_t value) {
+        if(value < csvTableSize) {
+            std::memcpy(out, csvNumbers[value].data(), 4);
+            return out + csvNumbers[value][4];
+        }
+        return std::to_chars(out, out + 10, value).ptr;
+    }
+} // namespace
+
+std::string tmx::internal::encodeBase64(std::string_view data) {
+    std::string result(((data.size() + 2) / 3) * 4, '\0');
+    const auto* in = reinterpret_cast<const unsigned char*>(data.data());
+    char* out = result.data();
+
+    std::size_t i = 0;
+    for(; i + 3 <= data.size(); i += 3) {
+        std::uint32_t value = (static_cast<std::uint32_t>(in[i]) << 16U) |
+                              (static_cast<std::uint32_t>(in[i + 1]) << 8U) | in[i + 2];
+        std::memcpy(out, base64Pairs[value >> 12U].data(), 2);
+        std::memcpy(out + 2, base64Pairs[value & 0xFFFU].data(), 2);
+        out += 4;
+    }
+
+    if(i < data.size()) {
+        std::uint32_t value = static_cast<std::uint32_t>(in[i]) << 16U;
+        if(i + 1 < data.size()) {
+            value |= static_cast<std::uint32_t>(in[i + 1]) << 8U;
+        }
+        std::memcpy(out, base64Pairs[value >> 12U].data(), 2);
+        out[2] = i + 1 < data.size() ? base64Pairs[value & 0xFFFU][0] : '=';
+        out[3] = '=';
+    }
+    return result;
+}
+
+std::string tmx::TileLayer::encode(const SaveOptions& options) const {
+    std::span<const std::uint32_t> values = cells();
+    if(options.encoding == SaveOptions::Encoding::CSV) {
+        if(options.compression != SaveOptions::Compression::NONE) {
+            throw Exception("CSV encoded layers can not be compressed");
+        }
+        // Same layout as Tiled, a row per line. Rows are formatted into a buffer sized for the longest possible
+        // numbers, the result is reserved for typical ones and grows if GIDs are larger
+        std::string result = "\n";
+        result.reserve((values.size() * 4) + d->height + 1);
+        std::string row((static_cast<std::size_t>(d->width) * 11) + 1, '\0');
+        const std::uint32_t* cell = values.data();
+        for(int y = 0; y < d->height; y++) {
+            char* out = row.data();
+            for(int x = 0; x < d->width; x++) {
+                out = writeNumber(out, *cell++);
+                *out++ = ',';
+            }
+            // Last cell has no trailing comma
+            if(y == d->height - 1 && d->width != 0) {
+                --out;
+            }
+            *out++ = '\n';
+            result.append(row.data(), out - row.data());
+        }
+        return result;
+    }
+
+    std::string bytes(values.size() * 4, '\0');
+    if constexpr(std::endian::native == std::endian::little) {
+        std::memcpy(bytes.data(), values.data(), bytes.size());
+    } else {
+        for(std::size_t i = 0; i < values.size(); i++) {
+            for(std::size_t b = 0; b < 4; b++) {
+                bytes[(4 * i) + b] = static_cast<char>((values[i] >> (8 * b)) & 0xFFU);
+            }
+        }
+    }
+    if(options.compression != SaveOptions::Compression::NONE) {
+        bytes = compressData(bytes, options);
+    }
+    return internal::encodeBase64(bytes);
+}
+
+void tmx::TileLayer::save(internal::XmlWriter& writer, const SaveOptions& options, std::string_view data) const {
+    writer.open("layer");
+    AbstractLayer::save(writer);
+    writer.attribute("width", d->width);
+    writer.attribute("height", d->height);
+    Properties::save(writer);
+
+    constexpr std::array<std::string_view, 4> compressionNames = {"", "zlib", "gzip", "zstd"};
+    writer.open("data");
+    writer.attribute("encoding", options.encoding == SaveOptions::Encoding::CSV ? "csv" : "base64");
+    writer.attribute("compression", compressionNames.at(static_cast<std::size_t>(options.compression)),
+        compressionNames[0]);
+    writer.rawText(data);
+    writer.close();
+    writer.close();
+}
+
+std::vector<tmx::MapChanges::Rect> tmx::TileLayer::changedRects(const TileLayer& previous) const {
+    if(d->state == previous.d->state) {
+        return {};
+    }
+    if(d->width != previous.d->width || d->height != previous.d->height) {
+        return {{.x = 0, .y = 0, .width = d->width, .height = d->height}};
+    }
+
+    // Cells are compared in square blocks, changed blocks next to each other in a row are joined into a rect and
+    // rects of consecutive block rows with the same horizontal extent are joined vertically
+    constexpr int blockSize = 16;
+    std::span<const std::uint32_t> before = previous.cells();
+    std::span<const std::uint32_t> after = cells();
+    auto blockChanged = [&](int blockX, int blockY) {
+        int x = blockX * blockSize;
+        int width = std::min(blockSize, d->width - x);
+        for(int y = blockY * blockSize; y < std::min((blockY + 1) * blockSize, d->height); y++) {
+            std::size_t offset = (static_cast<std::size_t>(y) * d->width) + x;
+            if(std::memcmp(before.data() + offset, after.data() + offset, width * sizeof(std::uint32_t)) != 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<MapChanges::Rect> rects;
+    int blocksX = (d->width + blockSize - 1) / blockSize;
+    int blocksY = (d->height + blockSize - 1) / blockSize;
+    for(int blockY = 0; blockY < blocksY; blockY++) {
+        std::size_t rowBegin = rects.size();
+        int y = blockY * blockSize;
+        int height = std::min(blockSize, d->height - y);
+        for(int blockX = 0; blockX < blocksX; blockX++) {
+            if(!blockChanged(blockX, blockY)) {
+                continue;
+            }
+            int x = blockX * blockSize;
+            int width = std::min(blockSize, d->width - x);
+            if(rects.size() > rowBegin && rects.back().x + rects.back().width == x) {
+                rects.back().width += width;
+            } else {
+                rects.push_back({.x = x, .y = y, .width = width, .height = height});
+            }
+        }
+
+        // Extend rects ending at the previous block row that match a rect in this one
+        for(std::size_t i = rowBegin; i < rects.size();) {
+            auto match = std::find_if(rects.begin(), rects.begin() + static_cast<std::ptrdiff_t>(rowBegin),
+                [&](const MapChanges::Rect& rect) {
+                    return rect.x == rects[i].x && rect.width == rects[i].width && rect.y + rect.height == y;
+                });
+            if(match != rects.begin() + static_cast<std::ptrdiff_t>(rowBegin)) {
+                match->height += height;
+                rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                i++;
+            }
+        }
+    }
+    return rects;
+}
+
+void tmx::TileLayer::serializeAttributes(internal::BinaryWriter& writer) const {
+    AbstractLayer::serialize(writer);
+    writer.write(d->width);
+    writer.write(d->height);
+    writer.write(d->encoding);
+    writer.write(d->compression);
+}
+
+void tmx::TileLayer::serialize(internal::BinaryWriter& writer) const {
+    serializeAttributes(writer);
+    writer.writeCells(cells());
+}
+
+void tmx::TileLayer::deserialize(internal::BinaryReader& reader) {
+    AbstractLayer::deserialize(reader);
+    reader.read(d->width);
+    reader.read(d->height);
+    reader.read(d->encoding);
+    reader.read(d->compression);
+    if(d->width < 0 || d->height < 0) {
+        throw Exception("Baked map is corrupted");
+    }
+    auto [cells, owner] = reader.readCells(static_cast<std::size_t>(d->width) * d->height);
+    setCells(cells, std::move(owner));
+}
+
+namespace {
+    constexpr std::uint8_t tileLayerPatch = 'T';
+    constexpr std::uint8_t patchVersion = 1;
+} // namespace
+
+std::string tmx::TileLayer::diff(const TileLayer& base) const {
+    internal::BinaryWriter writer;
+    writer.write(tileLayerPatch);
+    writer.write(patchVersion);
+    writer.writeVarint(base.d->width);
+    writer.writeVarint(base.d->height);
+
+    internal::BinaryWriter attributes;
+    internal::BinaryWriter baseAttributes;
+    serializeAttributes(attributes);
+    base.serializeAttributes(baseAttributes);
+    bool attributesChanged = attributes.metadataSection() != baseAttributes.metadataSection();
+    writer.write(attributesChanged);
+    if(attributesChanged) {
+        serializeAttributes(writer);
+    }
+
+    std::span<const std::uint32_t> after = cells();
+    std::span<const std::uint32_t> before = base.cells();
+    bool resized = d->width != base.d->width || d->height != base.d->height || after.size() != before.size();
+    writer.write(resized);
+    if(resized) {
+        writer.writeVarint(after.size());
+        for(std::uint32_t cell : after) {
+            writer.write(cell);
+        }
+        return writer.metadataSection();
+    }
+
+    // Whole rows are compared with memcmp, which is vectorized, and only rows that differ are scanned cell by
+    // cell. Runs are stored as offset from the end of the previous run, length and new values
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    auto rowSize = static_cast<std::size_t>(d->width);
+    for(std::size_t row = 0; row < after.size(); row += rowSize) {
+        if(std::memcmp(after.data() + row, before.data() + row, rowSize * sizeof(std::uint32_t)) == 0) {
+            continue;
+        }
+        for(std::size_t i = row; i < row + rowSize; i++) {
+            if(after[i] == before[i]) {
+                continue;
+            }
+            if(!runs.empty() && runs.back().first + runs.back().second == i) {
+                runs.back().second++;
+            } else {
+                runs.emplace_back(i, 1);
+            }
+        }
+    }
+
+    writer.writeVarint(runs.size());
+    std::size_t end = 0;
+    for(auto [offset, length] : runs) {
+        writer.writeVarint(offset - end);
+        writer.writeVarint(length);
+        for(std::size_t i = offset; i < offset + length; i++) {
+            writer.write(after[i]);
+        }
+        end = offset + length;
+    }
+    return writer.metadataSection();
+}
+
+void tmx::TileLayer::applyPatch(std::string_view patch) {
+    internal::BinaryReader reader(patch, {}, nullptr, "Tile layer patch");
+    if(reader.read<std::uint8_t>() != tileLayerPatch || reader.read<std::uint8_t>() != patchVersion) {
+        throw Exception("Not a tile layer patch");
+    }
+    if(reader.readVarint() != static_cast<std::uint64_t>(d->width) ||
+        reader.readVarint() != static_cast<std::uint64_t>(d->height)) {
+        throw Exception("Patch was made for a layer of different size than " + name());
+    }
+    ensureDecoded();
+
+    // Patch is read completely before anything is modified, so an invalid one leaves the layer as it was
+    std::optional<TileLayer> attributes;
+    if(reader.read<bool>()) {
+        attributes.emplace();
+        attributes->AbstractLayer::deserialize(reader);
+        reader.read(attributes->d->width);
+        reader.read(attributes->d->height);
+        reader.read(attributes->d->encoding);
+        reader.read(attributes->d->compression);
+    }
+    int width = attributes ? attributes->d->width : d->width;
+    int height = attributes ? attributes->d->height : d->height;
+    if(width < 0 || height < 0) {
+        throw Exception("Tile layer patch is corrupted");
+    }
+    auto cellCount = static_cast<std::size_t>(width) * height;
+
+    std::shared_ptr<std::vector<std::uint32_t>> resized;
+    std::vector<std::pair<std::size_t, std::string_view>> runs;
+    if(reader.read<bool>()) {
+        if(reader.readCount(sizeof(std::uint32_t)) != cellCount) {
+            throw Exception("Tile layer patch is corrupted");
+        }
+        resized = std::make_shared<std::vector<std::uint32_t>>(cellCount);
+        for(std::uint32_t& cell : *resized) {
+            reader.read(cell);
+        }
+    } else {
+        if(width != d->width || height != d->height) {
+            throw Exception("Tile layer patch is corrupted");
+        }
+        // Each run is at least its offset and length
+        runs.resize(reader.readCount(2));
+        std::size_t end = 0;
+        for(auto& [offset, values] : runs) {
+            offset = end + reader.readVarint();
+            std::uint64_t length = reader.readVarint();
+            if(offset > cellCount || length > cellCount - offset) {
+                throw Exception("Tile layer patch is corrupted");
+            }
+            values = reader.readBytes(length * sizeof(std::uint32_t));
+            end = offset + length;
+        }
+    }
+
+    if(attributes) {
+        static_cast<AbstractLayer&>(*this) = *attributes;
+        d->width = width;
+        d->height = height;
+        d->encoding = std::move(attributes->d->encoding);
+        d->compression = std::move(attributes->d->compression);
+    }
+    d->dataHash = 0;
+    if(resized) {
+        setCells(resized->data(), resized);
+        d->state->writableCells = resized->data();
+        return;
+    }
+    if(runs.empty()) {
+        return;
+    }
+
+    // Cells shared with copies of the layer or memory mapped are copied first
+    if(d->state->writableCells == nullptr || d->state.use_count() != 1) {
+        std::span<const std::uint32_t> current = cells();
+        auto copy = std::make_shared<std::vector<std::uint32_t>>(current.begin(), current.end());
+        setCells(copy->data(), copy);
+        d->state->writableCells = copy->data();
+    }
+    Data::State& state = *d->state;
+    for(const auto& [offset, values] : runs) {
+        for(std::size_t i = 0; i < values.size() / sizeof(std::uint32_t); i++) {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(values.data() + (4 * i));
+            std::uint32_t cell = static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8U) |
+                                 (static_cast<std::uint32_t>(bytes[2]) << 16U) |
+                                 (static_cast<std::uint32_t>(bytes[3]) << 24U);
+            state.writableCells[offset + i] = cell;
+            // Rows already built by data() are kept in sync
+            if(!state.rows.empty()) {
+                state.rows[(offset + i) / width][(offset + i) % width] = cell;
+            }
+        }
+    }
+}
@@ -1,5 +1,13 @@
-#include <tinyxml2.h>
+#include "binary.hpp"
+#include "element.hpp"
+#include "hash.hpp"
+#include "xml_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <tmxpp.hpp>
 
 struct tmx::Tileset::Data {
@@ -24,14 +32,17 @@ struct tmx::Tileset::Data {
 
     Image image;
     std::vector<Tile> tiles;
+
+    // Hash of the external tileset file, 0 for embedded tilesets
+    std::uint64_t sourceHash = 0;
 };
 
 __TMXPP_CLASS_HEADER_IMPL__(tmx, Tileset)
 
 int tmx::Tileset::firstGID() const { return d->firstGID; }
-std::string tmx::Tileset::source() const { return d->source; }
-std::string tmx::Tileset::name() const { return d->name; }
-std::string tmx::Tileset::className() const { return d->className; }
+const std::string& tmx::Tileset::source() const { return d->source; }
+const std::string& tmx::Tileset::name() const { return d->name; }
+const std::string& tmx::Tileset::className() const { return d->className; }
 int tmx::Tileset::tileWidth() const { return d->tileWidth; }
 int tmx::Tileset::tileHeight() const { return d->tileHeight; }
 int tmx::Tileset::spacing() const { return d->spacing; }
@@ -50,58 +61,38 @@ int tmx::Tileset::gridHeight() const { return d->gridHeight; }
 const tmx::Image& tmx::Tileset::image() const { return d->image; }
 const std::vector<tmx::Tile>& tmx::Tileset::tiles() const { return d->tiles; }
 
-void tmx::Tileset::parseFromData(const std::string& data) {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLError error = doc.Parse(data.c_str());
-    if(error != 0) {
-        throw Exception("XML parse failed (error code " + std::to_string(error) + ")");
-    }
-    parse(doc.FirstChildElement("tileset"));
+void tmx::Tileset::parseFromData(const std::string& data, const ParseOptions& options) {
+    parseFromData(Buffer(data.data(), data.size()), options);
 }
 
-void tmx::Tileset::parseFromFile(const std::filesystem::path& path, const LoaderType& loader) {
-    tinyxml2::XMLDocument doc;
-    auto error = static_cast<tinyxml2::XMLError>(0);
-    if(loader == nullptr) {
-        error = doc.LoadFile(path.string().c_str());
-    } else {
-        error = doc.Parse(loader(path).c_str());
-    }
-    if(error != 0) {
-        throw Exception("XML parse failed (error code " + std::to_string(error) + ")");
-    }
-    parse(doc.FirstChildElement("tileset"));
+void tmx::Tileset::parseFromData(const Buffer& data, const ParseOptions& options) {
+    internal::parseDocument(
+        data, options.backend, "tileset", [this, &options](internal::Element& root) { parse(root, options); });
 }
 
-void tmx::Tileset::parse(tinyxml2::XMLElement* root) {
-    if(root == nullptr) {
-        throw Exception("Missing tileset root element");
-    }
+void tmx::Tileset::parseFromFile(
+    const std::filesystem::path& path, const LoaderType& loader, const ParseOptions& options) {
+    parseFromData(loader != nullptr ? loader(path) : Buffer::fromFile(path), options);
+}
 
-    if(root->Attribute("firstgid") != nullptr) {
-        d->firstGID = root->IntAttribute("firstgid");
-    }
-    if(root->Attribute("source") != nullptr) {
-        d->source = root->Attribute("source");
+void tmx::Tileset::parse(internal::Element& root, const ParseOptions& options) {
+    root.query("firstgid", d->firstGID);
+    if(root.query("source", d->source)) {
         return;
     }
 
-    if(root->Attribute("name") != nullptr) {
-        d->name = root->Attribute("name");
-    }
-    if(root->Attribute("class") != nullptr) {
-        d->className = root->Attribute("class");
-    }
+    root.query("name", d->name);
+    root.query("class", d->className);
 
-    root->QueryIntAttribute("tilewidth", &d->tileWidth);
-    root->QueryIntAttribute("tileheight", &d->tileHeight);
-    root->QueryIntAttribute("spacing", &d->spacing);
-    root->QueryIntAttribute("margin", &d->margin);
-    root->QueryIntAttribute("tilecount", &d->tileCount);
-    root->QueryIntAttribute("columns", &d->columns);
+    root.query("tilewidth", d->tileWidth);
+    root.query("tileheight", d->tileHeight);
+    root.query("spacing", d->spacing);
+    root.query("margin", d->margin);
+    root.query("tilecount", d->tileCount);
+    root.query("columns", d->columns);
 
-    if(root->Attribute("objectalignment") != nullptr) {
-        std::string value = root->Attribute("objectalignment");
+    std::string value;
+    if(root.query("objectalignment", value)) {
         if(value == "unspecified") {
             d->objectAlignment = ObjectAlignment::UNSPECIFIED;
         } else if(value == "topleft") {
@@ -127,8 +118,7 @@ void tmx::Tileset::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    if(root->Attribute("tilerendersize") != nullptr) {
-        std::string value = root->Attribute("tilerendersize");
+    if(root.query("tilerendersize", value)) {
         if(value == "tile") {
             d->tileRenderSize = TileRenderSize::TILE;
         } else if(value == "grid") {
@@ -138,8 +128,7 @@ void tmx::Tileset::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    if(root->Attribute("fillmode") != nullptr) {
-        std::string value = root->Attribute("fillmode");
+    if(root.query("fillmode", value)) {
         if(value == "stretch") {
             d->fillMode = FillMode::STRETCH;
         } else if(value == "preserve-aspect-fit") {
@@ -147,42 +136,169 @@ void tmx::Tileset::parse(tinyxml2::XMLElement* root) {
         }
     }
 
-    if(root->FirstChildElement("tileoffset") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("tileoffset");
-        d->tileOffset.x = element->IntAttribute("x");
-        d->tileOffset.y = element->IntAttribute("y");
+    while(internal::Element* element = root.nextChild()) {
+        std::string_view name = element->name();
+        if(name == "tileoffset") {
+            d->tileOffset.x = element->intAttribute("x");
+            d->tileOffset.y = element->intAttribute("y");
+        } else if(name == "grid") {
+            if(element->query("orientation", value)) {
+                if(value == "orthogonal") {
+                    d->gridOrientation = GridOrientation::ORTHOGONAL;
+                } else if(value == "isometric") {
+                    d->gridOrientation = GridOrientation::ISOMETRIC;
+                } else {
+                    throw Exception("Invalid grid orientation " + value);
+                }
+            }
+            d->gridWidth = element->intAttribute("width");
+            d->gridHeight = element->intAttribute("height");
+        } else if(name == "image") {
+            d->image.parse(*element);
+        } else if(name == "tile" && !options.skipTileMetadata) {
+            parseTile(*element, options);
+        } else if(name == "properties" && !options.skipProperties) {
+            Properties::parse(*element);
+        }
     }
+}
 
-    if(root->FirstChildElement("grid") != nullptr) {
-        tinyxml2::XMLElement* element = root->FirstChildElement("grid");
-        if(element->Attribute("orientation") != nullptr) {
-            std::string value = element->Attribute("orientation");
-            if(value == "orthogonal") {
-                d->gridOrientation = GridOrientation::ORTHOGONAL;
-            } else if(value == "isometric") {
-                d->gridOrientation = GridOrientation::ISOMETRIC;
-            } else {
-                throw Exception("Invalid grid orientation " + value);
-            }
+void tmx::Tileset::loadSource(const std::filesystem::path& path, const LoaderType& loader,
+    const ParseOptions& options, const std::vector<Tileset>& previous) {
+    Buffer data = loader != nullptr ? loader(path) : Buffer::fromFile(path);
+    std::uint64_t hash = internal::hashBytes(data.view());
+    for(const Tileset& tileset : previous) {
+        if(tileset.d->sourceHash == hash && tileset.d->source == d->source && tileset.d->firstGID == d->firstGID) {
+            *this = tileset;
+            return;
         }
-        d->gridWidth = element->IntAttribute("width");
-        d->gridHeight = element->IntAttribute("height");
     }
+    parseFromData(data, options);
+    d->sourceHash = hash;
+}
+
+void tmx::Tileset::registerImages(const internal::ImageRegistry& registry) {
+    d->image.setHandle(registry(d->image));
+    for(Tile& tile : d->tiles) {
+        tile.registerImages(registry);
+    }
+}
+
+void tmx::Tileset::parseTile(internal::Element& element, const ParseOptions& options) {
+    // Tiles are small handles, room for every tile of the tileset is reserved on the first one since the number
+    // of <tile> elements is not known in advance. Capped so a bogus tile count can't make it allocate a lot
+    constexpr int maxReservedTiles = 4096;
+    if(d->tiles.capacity() == 0) {
+        d->tiles.reserve(static_cast<std::size_t>(std::clamp(d->tileCount, 1, maxReservedTiles)));
+    }
+    Tile tile;
+    tile.parse(element, options);
+    d->tiles.push_back(std::move(tile));
+}
 
-    if(root->FirstChildElement("image") != nullptr) {
-        d->image.parse(root->FirstChildElement("image"));
+void tmx::Tileset::save(internal::XmlWriter& writer) const {
+    writer.open("tileset");
+    writer.attribute("firstgid", d->firstGID);
+    if(!d->source.empty()) {
+        writer.attribute("source", d->source);
+        writer.close();
+        return;
     }
 
-    parseTiles(root);
-    Properties::parse(root->FirstChildElement("properties"));
+    writer.attribute("name", d->name);
+    writer.attribute("class", d->className, std::string());
+    writer.attribute("tilewidth", d->tileWidth);
+    writer.attribute("tileheight", d->tileHeight);
+    writer.attribute("spacing", d->spacing, 0);
+    writer.attribute("margin", d->margin, 0);
+    writer.attribute("tilecount", d->tileCount);
+    writer.attribute("columns", d->columns);
+
+    constexpr std::array<std::string_view, 10> alignmentNames = {"unspecified", "topleft", "top", "topright", "left",
+        "center", "right", "bottomleft", "bottom", "bottomright"};
+    writer.attribute("objectalignment", alignmentNames.at(static_cast<std::size_t>(d->objectAlignment)),
+        alignmentNames[0]);
+    if(d->tileRenderSize == TileRenderSize::GRID) {
+        writer.attribute("tilerendersize", "grid");
+    }
+    if(d->fillMode == FillMode::PRESERVE_ASPECT_FIT) {
+        writer.attribute("fillmode", "preserve-aspect-fit");
+    }
+
+    if(d->tileOffset.x != 0 || d->tileOffset.y != 0) {
+        writer.open("tileoffset");
+        writer.attribute("x", d->tileOffset.x);
+        writer.attribute("y", d->tileOffset.y);
+        writer.close();
+    }
+    if(d->gridOrientation != GridOrientation::ORTHOGONAL || d->gridWidth != 0 || d->gridHeight != 0) {
+        writer.open("grid");
+        if(d->gridOrientation == GridOrientation::ISOMETRIC) {
+            writer.attribute("orientation", "isometric");
+        }
+        writer.attribute("width", d->gridWidth);
+        writer.attribute("height", d->gridHeight);
+        writer.close();
+    }
+    Properties::save(writer);
+    d->image.save(writer);
+    for(const Tile& tile : d->tiles) {
+        tile.save(writer);
+    }
+    writer.close();
+}
+
+void tmx::Tileset::serialize(internal::BinaryWriter& writer) const {
+    writer.write(d->firstGID);
+    writer.write(d->source);
+    writer.write(d->name);
+    writer.write(d->className);
+    writer.write(d->tileWidth);
+    writer.write(d->tileHeight);
+    writer.write(d->spacing);
+    writer.write(d->margin);
+    writer.write(d->tileCount);
+    writer.write(d->columns);
+    writer.write(d->objectAlignment);
+    writer.write(d->tileRenderSize);
+    writer.write(d->fillMode);
+    writer.write(d->tileOffset);
+    writer.write(d->gridOrientation);
+    writer.write(d->gridWidth);
+    writer.write(d->gridHeight);
+    d->image.serialize(writer);
+    Properties::serialize(writer);
+
+    writer.write(static_cast<std::uint32_t>(d->tiles.size()));
+    for(const Tile& tile : d->tiles) {
+        tile.serialize(writer);
+    }
 }
 
-void tmx::Tileset::parseTiles(tinyxml2::XMLElement* root) {
-    tinyxml2::XMLElement* element = root->FirstChildElement("tile");
-    while(element != nullptr) {
-        Tile tile;
-        tile.parse(element);
-        d->tiles.push_back(tile);
-        element = element->NextSiblingElement();
+void tmx::Tileset::deserialize(internal::BinaryReader& reader) {
+    reader.read(d->firstGID);
+    reader.read(d->source);
+    reader.read(d->name);
+    reader.read(d->className);
+    reader.read(d->tileWidth);
+    reader.read(d->tileHeight);
+    reader.read(d->spacing);
+    reader.read(d->margin);
+    reader.read(d->tileCount);
+    reader.read(d->columns);
+    reader.read(d->objectAlignment);
+    reader.read(d->tileRenderSize);
+    reader.read(d->fillMode);
+    reader.read(d->tileOffset);
+    reader.read(d->gridOrientation);
+    reader.read(d->gridWidth);
+    reader.read(d->gridHeight);
+    d->image.deserialize(reader);
+    Properties::deserialize(reader);
+
+    // Every tile starts with its id
+    d->tiles.resize(reader.readCount<std::uint32_t>(sizeof(int)));
+    for(Tile& tile : d->tiles) {
+        tile.deserialize(reader);
     }
 }
@@ -8,9 +8,12 @@ tmx::Color tmx::colorFromString(const std::string& str) {
         if('A' <= c && c <= 'F') {
             return 10 + (c - 'A');
         }
+        if('a' <= c && c <= 'f') {
+            return 10 + (c - 'a');
+        }
         throw Exception("Unknown color format" + str);
     };
-    auto convert2 = [convert](char a, char b) { return (convert(a) * 10) + convert(b); };
+    auto convert2 = [convert](char a, char b) { return (convert(a) * 16) + convert(b); };
 
     if((str.size() == 7 || str.size() == 9) && str[0] != '#') {
         throw Exception("Unknown color format" + str);
@@ -0,0 +1,55 @@
+#include "xml_writer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <tmxpp.hpp>
+#include <vector>
+
+std::string tmx::Map::saveToData(const SaveOptions& options) const {
+    // Encoding and compression of tile data is the expensive part, it is done for all layers up front on a pool
+    // of workers, the document itself is then written in a single pass
+    const std::vector<FlatLayer>& layers = flatLayers();
+    std::vector<std::string> layerData(layers.size());
+    std::atomic<std::size_t> nextLayer = 0;
+    auto worker = [&layers, &layerData, &nextLayer, &options]() {
+        for(std::size_t i = nextLayer++; i < layers.size(); i = nextLayer++) {
+            if(layers[i].layer->type() == Layer::Type::TILE) {
+                layerData[i] = layers[i].layer->tileLayer().encode(options);
+            }
+        }
+    };
+
+    auto tileLayerCount = static_cast<unsigned int>(std::count_if(layers.begin(), layers.end(),
+        [](const FlatLayer& layer) { return layer.layer->type() == Layer::Type::TILE; }));
+    unsigned int threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+    threads = std::max(std::min(threads, tileLayerCount), 1U);
+
+    std::vector<std::future<void>> workers;
+    for(unsigned int i = 1; i < threads; i++) {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for(std::future<void>& future : workers) {
+        future.get();
+    }
+
+    internal::XmlWriter writer;
+    std::size_t dataSize = 0;
+    for(const std::string& data : layerData) {
+        dataSize += data.size();
+    }
+    writer.reserve(dataSize + 4096);
+    save(writer, options, layerData);
+    return std::move(writer.result());
+}
+
+void tmx::Map::saveToFile(const std::filesystem::path& path, const SaveOptions& options) const {
+    std::string data = saveToData(options);
+    std::ofstream file(path, std::ios::binary);
+    if(!file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+        throw Exception("Failed to write file " + path.string());
+    }
+}
@@ -0,0 +1,406 @@
+#include "element.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+// Forward-only XML reader working directly on the input buffer. Names, attribute values and text are returned
+// as views into the input, only values containing entity references or carriage returns are copied and decoded.
+// Doctype and processing instructions are skipped, namespaces are not interpreted
+
+namespace {
+    class Cursor {
+    public:
+        Cursor(const char* begin, const char* end) : begin(begin), pos(begin), end(end) {}
+
+        [[nodiscard]] bool atEnd() const { return pos >= end; }
+        [[nodiscard]] char peek(std::size_t offset = 0) const { return pos + offset < end ? pos[offset] : '\0'; }
+        [[nodiscard]] bool startsWith(std::string_view str) const {
+            return static_cast<std::size_t>(end - pos) >= str.size() && std::memcmp(pos, str.data(), str.size()) == 0;
+        }
+        [[nodiscard]] std::size_t offset() const { return pos - begin; }
+
+        static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+        void skipSpaces() {
+            while(pos < end && isSpace(*pos)) {
+                ++pos;
+            }
+        }
+
+        void expect(char c) {
+            if(pos >= end || *pos != c) {
+                fail(std::string("expected '") + c + "'");
+            }
+            ++pos;
+        }
+
+        // Moves past the next occurrence of str
+        void skipPast(std::string_view str) {
+            std::string_view rest(pos, end - pos);
+            std::size_t found = rest.find(str);
+            if(found == std::string_view::npos) {
+                fail("unexpected end of file");
+            }
+            pos += found + str.size();
+        }
+
+        std::string_view readName() {
+            const char* start = pos;
+            while(pos < end && !isSpace(*pos) && *pos != '/' && *pos != '>' && *pos != '=') {
+                ++pos;
+            }
+            if(pos == start) {
+                fail("expected name");
+            }
+            return {start, static_cast<std::size_t>(pos - start)};
+        }
+
+        // Skips comments, processing instructions and doctype, stops at the next element tag or text
+        void skipMarkup() {
+            while(pos < end && *pos == '<') {
+                if(startsWith("<!--")) {
+                    skipPast("-->");
+                } else if(startsWith("<?")) {
+                    skipPast("?>");
+                } else if(startsWith("<!DOCTYPE")) {
+                    skipDoctype();
+                } else {
+                    return;
+                }
+            }
+        }
+
+        [[noreturn]] void fail(const std::string& error) const {
+            int line = 1 + static_cast<int>(std::count(begin, std::min(pos, end), '\n'));
+            throw tmx::Exception("XML parse failed (" + error + " at line " + std::to_string(line) + ")");
+        }
+
+        const char* begin;
+        const char* pos;
+        const char* end;
+
+    private:
+        void skipDoctype() {
+            int depth = 0;
+            while(pos < end) {
+                char c = *pos++;
+                if(c == '[') {
+                    depth++;
+                } else if(c == ']') {
+                    depth--;
+                } else if(c == '>' && depth <= 0) {
+                    return;
+                }
+            }
+            fail("unexpected end of file");
+        }
+    };
+
+    void appendCodePoint(std::string& out, unsigned long code) {
+        if(code < 0x80) {
+            out += static_cast<char>(code);
+        } else if(code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if(code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool needsDecoding(std::string_view str) {
+        return str.find_first_of("&\r") != std::string_view::npos;
+    }
+
+    // Expands entity references and normalizes line endings, unknown entities are kept as is
+    void decode(std::string_view str, std::string& out) {
+        for(std::size_t i = 0; i < str.size(); i++) {
+            char c = str[i];
+            if(c == '\r') {
+                out += '\n';
+                if(i + 1 < str.size() && str[i + 1] == '\n') {
+                    i++;
+                }
+                continue;
+            }
+            if(c != '&') {
+                out += c;
+                continue;
+            }
+
+            std::size_t semicolon = str.find(';', i);
+            if(semicolon == std::string_view::npos) {
+                out += c;
+                continue;
+            }
+            std::string_view entity = str.substr(i + 1, semicolon - i - 1);
+            if(entity == "lt") {
+                out += '<';
+            } else if(entity == "gt") {
+                out += '>';
+            } else if(entity == "amp") {
+                out += '&';
+            } else if(entity == "quot") {
+                out += '"';
+            } else if(entity == "apos") {
+                out += '\'';
+            } else if(entity.size() > 1 && entity[0] == '#') {
+                bool hex = entity[1] == 'x' || entity[1] == 'X';
+                std::string digits(entity.substr(hex ? 2 : 1));
+                char* parsed = nullptr;
+                unsigned long code = std::strtoul(digits.c_str(), &parsed, hex ? 16 : 10);
+                if(digits.empty() || *parsed != '\0') {
+                    out += c;
+                    continue;
+                }
+                appendCodePoint(out, code);
+            } else {
+                out += c;
+                continue;
+            }
+            i = semicolon;
+        }
+    }
+
+    class StreamElement : public tmx::internal::Element {
+    public:
+        explicit StreamElement(Cursor& cursor) : cursor(cursor) {}
+
+        // Reads start tag, cursor must point right after '<'
+        void open() {
+            attributes.clear();
+            decoded.clear();
+            childOpen = false;
+            textRead = false;
+
+            tagName = cursor.readName();
+            while(true) {
+                cursor.skipSpaces();
+                if(cursor.atEnd()) {
+                    cursor.fail("unexpected end of file");
+                }
+                if(cursor.peek() == '/') {
+                    ++cursor.pos;
+                    cursor.expect('>');
+                    finished = true;
+                    return;
+                }
+                if(cursor.peek() == '>') {
+                    ++cursor.pos;
+                    finished = false;
+                    return;
+                }
+
+                std::string_view attrName = cursor.readName();
+                cursor.skipSpaces();
+                cursor.expect('=');
+                cursor.skipSpaces();
+                char quote = cursor.peek();
+                if(quote != '"' && quote != '\'') {
+                    cursor.fail("expected attribute value");
+                }
+                ++cursor.pos;
+                const char* start = cursor.pos;
+                const void* found = std::memchr(start, quote, cursor.end - start);
+                if(found == nullptr) {
+                    cursor.fail("unexpected end of file");
+                }
+                cursor.pos = static_cast<const char*>(found) + 1;
+
+                std::string_view value(start, static_cast<const char*>(found) - start);
+                if(needsDecoding(value)) {
+                    decode(value, decoded.emplace_back());
+                    value = decoded.back();
+                }
+                attributes.push_back({attrName, value});
+            }
+        }
+
+        [[nodiscard]] std::string_view name() const override { return tagName; }
+
+        [[nodiscard]] std::optional<std::string_view> attribute(std::string_view name) const override {
+            for(const Attribute& attr : attributes) {
+                if(attr.name == name) {
+                    return attr.value;
+                }
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] std::string_view text() override {
+            if(finished || textRead) {
+                return {};
+            }
+            textRead = true;
+            closeChild();
+
+            // Fast path: single text node followed by the closing tag is returned in place
+            const char* start = cursor.pos;
+            const void* found = std::memchr(start, '<', cursor.end - start);
+            if(found == nullptr) {
+                cursor.fail("unexpected end of file");
+            }
+            std::string_view chunk(start, static_cast<const char*>(found) - start);
+            cursor.pos = static_cast<const char*>(found);
+            if(cursor.peek(1) == '/' && !needsDecoding(chunk)) {
+                readEndTag();
+                return chunk;
+            }
+
+            std::string& storage = decoded.emplace_back();
+            decode(chunk, storage);
+            while(true) {
+                if(cursor.startsWith("<![CDATA[")) {
+                    cursor.pos += 9;
+                    const char* cdata = cursor.pos;
+                    cursor.skipPast("]]>");
+                    storage.append(cdata, cursor.pos - 3);
+                } else if(cursor.startsWith("</")) {
+                    readEndTag();
+                    return storage;
+                } else if(cursor.startsWith("<!") || cursor.startsWith("<?")) {
+                    cursor.skipMarkup();
+                    if(cursor.pos == found) {
+                        cursor.fail("unexpected markup");
+                    }
+                } else {
+                    openChild();
+                    closeChild();
+                }
+
+                start = cursor.pos;
+                found = std::memchr(start, '<', cursor.end - start);
+                if(found == nullptr) {
+                    cursor.fail("unexpected end of file");
+                }
+                decode(std::string_view(start, static_cast<const char*>(found) - start), storage);
+                cursor.pos = static_cast<const char*>(found);
+            }
+        }
+
+        [[nodiscard]] Element* nextChild() override {
+            if(finished || textRead) {
+                return nullptr;
+            }
+            closeChild();
+
+            while(true) {
+                const void* found = std::memchr(cursor.pos, '<', cursor.end - cursor.pos);
+                if(found == nullptr) {
+                    cursor.pos = cursor.end;
+                    cursor.fail("unexpected end of file");
+                }
+                cursor.pos = static_cast<const char*>(found);
+
+                if(cursor.startsWith("</")) {
+                    readEndTag();
+                    return nullptr;
+                }
+                if(cursor.startsWith("<![CDATA[")) {
+                    cursor.skipPast("]]>");
+                } else if(cursor.startsWith("<!") || cursor.startsWith("<?")) {
+                    cursor.skipMarkup();
+                    if(cursor.pos == found) {
+                        cursor.fail("unexpected markup");
+                    }
+                } else {
+                    openChild();
+                    return child.get();
+                }
+            }
+        }
+
+        [[nodiscard]] int childCount(std::initializer_list<std::string_view> /*names*/) const override { return 0; }
+        [[nodiscard]] std::size_t position() const override { return cursor.offset(); }
+
+        // Consumes the rest of the element
+        void skip() {
+            if(textRead) {
+                return;
+            }
+            while(nextChild() != nullptr) {
+            }
+        }
+
+    private:
+        struct Attribute {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        void openChild() {
+            ++cursor.pos;
+            if(child == nullptr) {
+                child = std::make_unique<StreamElement>(cursor);
+            }
+            child->open();
+            childOpen = true;
+        }
+
+        void closeChild() {
+            if(childOpen) {
+                child->skip();
+                childOpen = false;
+            }
+        }
+
+        void readEndTag() {
+            cursor.pos += 2;
+            std::string_view endName = cursor.readName();
+            if(endName != tagName) {
+                cursor.fail("mismatched end tag " + std::string(endName) + " for " + std::string(tagName));
+            }
+            cursor.skipSpaces();
+            cursor.expect('>');
+            finished = true;
+        }
+
+        Cursor& cursor;
+        std::string_view tagName;
+        std::vector<Attribute> attributes;
+        std::deque<std::string> decoded;
+        bool finished = true;
+        bool textRead = false;
+        bool childOpen = false;
+        std::unique_ptr<StreamElement> child;
+    };
+}
+
+void tmx::internal::parseStreamDocument(
+    const Buffer& data, std::string_view rootName, const std::function<void(Element&)>& callback) {
+    Cursor cursor(data.data(), data.data() + data.size());
+    if(cursor.startsWith("\xEF\xBB\xBF")) {
+        cursor.pos += 3;
+    }
+
+    cursor.skipSpaces();
+    while(cursor.startsWith("<!--") || cursor.startsWith("<?") || cursor.startsWith("<!DOCTYPE")) {
+        cursor.skipMarkup();
+        cursor.skipSpaces();
+    }
+    if(cursor.atEnd()) {
+        cursor.fail("empty document");
+    }
+    if(cursor.peek() != '<') {
+        cursor.fail("unexpected text");
+    }
+
+    ++cursor.pos;
+    StreamElement root(cursor);
+    root.open();
+    if(root.name() != rootName) {
+        throw Exception("Missing " + std::string(rootName) + " root element");
+    }
+    callback(root);
+    root.skip();
+}
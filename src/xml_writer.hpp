@@ -0,0 +1,168 @@
+#ifndef TMXPP_XML_WRITER_HPP
+#define TMXPP_XML_WRITER_HPP
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tmxpp.hpp>
+#include <type_traits>
+#include <vector>
+
+// Builds TMX output in a single string. Elements without content are closed with "/>", nested elements are
+// indented by one space per level the same way Tiled does it
+
+class tmx::internal::XmlWriter {
+public:
+    XmlWriter() { out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"; }
+
+    void open(std::string_view name) {
+        if(tagOpen) {
+            out += ">\n";
+        }
+        out.append(stack.size(), ' ');
+        out += '<';
+        out += name;
+        stack.push_back({.name = name});
+        tagOpen = true;
+    }
+
+    void close() {
+        Open element = stack.back();
+        stack.pop_back();
+        if(tagOpen) {
+            out += "/>\n";
+            tagOpen = false;
+            return;
+        }
+        if(!element.hasText) {
+            out.append(stack.size(), ' ');
+        }
+        out += "</";
+        out += element.name;
+        out += ">\n";
+    }
+
+    void attribute(std::string_view name, std::string_view value) {
+        out += ' ';
+        out += name;
+        out += "=\"";
+        escape(value, true);
+        out += '"';
+    }
+
+    void attribute(std::string_view name, const std::string& value) { attribute(name, std::string_view(value)); }
+    void attribute(std::string_view name, const char* value) { attribute(name, std::string_view(value)); }
+    void attribute(std::string_view name, bool value) { attribute(name, value ? "1" : "0"); }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void attribute(std::string_view name, T value) {
+        // Shortest representation that parses back to the same value
+        std::array<char, 32> buffer{};
+        auto [end, error] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+        attribute(name, std::string_view(buffer.data(), end - buffer.data()));
+    }
+
+    void attribute(std::string_view name, Color value) {
+        constexpr std::string_view digits = "0123456789abcdef";
+        std::string str = "#";
+        auto append = [&str, digits](unsigned char c) {
+            str += digits[c >> 4U];
+            str += digits[c & 0xFU];
+        };
+        if(value.a != 255) {
+            append(value.a);
+        }
+        append(value.r);
+        append(value.g);
+        append(value.b);
+        attribute(name, str);
+    }
+
+    // Attributes equal to their default value are left out, as Tiled does
+    template <typename T>
+    void attribute(std::string_view name, const T& value, const T& defaultValue) {
+        if(value != defaultValue) {
+            attribute(name, value);
+        }
+    }
+
+    void attribute(std::string_view name, Color value, Color defaultValue) {
+        if(value.r != defaultValue.r || value.g != defaultValue.g || value.b != defaultValue.b ||
+            value.a != defaultValue.a) {
+            attribute(name, value);
+        }
+    }
+
+    // Element text, must be followed by close() of the same element
+    void text(std::string_view value) {
+        startText();
+        escape(value, false);
+    }
+
+    // Text that is known not to need escaping, such as encoded tile data
+    void rawText(std::string_view value) {
+        startText();
+        out += value;
+    }
+
+    void reserve(std::size_t size) { out.reserve(size); }
+    [[nodiscard]] std::string& result() { return out; }
+
+private:
+    struct Open {
+        std::string_view name;
+        bool hasText = false;
+    };
+
+    void startText() {
+        if(tagOpen) {
+            out += '>';
+            tagOpen = false;
+        }
+        stack.back().hasText = true;
+    }
+
+    void escape(std::string_view value, bool inAttribute) {
+        for(char c : value) {
+            switch(c) {
+                case '&':
+                    out += "&amp;";
+                    break;
+                case '<':
+                    out += "&lt;";
+                    break;
+                case '>':
+                    out += "&gt;";
+                    break;
+                case '"':
+                    out += inAttribute ? "&quot;" : "\"";
+                    break;
+                case '\n':
+                    out += inAttribute ? "&#10;" : "\n";
+                    break;
+                case '\r':
+                    out += "&#13;";
+                    break;
+                case '\t':
+                    out += inAttribute ? "&#9;" : "\t";
+                    break;
+                default:
+                    out += c;
+            }
+        }
+    }
+
+    std::string out;
+    std::vector<Open> stack;
+    bool tagOpen = false;
+};
+
+namespace tmx::internal {
+    // Standard base64 with padding, used for tile data and embedded images
+    std::string encodeBase64(std::string_view data);
+} // namespace tmx::internal
+
+#endif // TMXPP_XML_WRITER_HPP
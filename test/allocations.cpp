@@ -0,0 +1,40 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <tmxpp.hpp>
+
+namespace {
+    std::atomic<std::size_t> allocations{0};
+
+    std::size_t countAllocations(const std::string& path) {
+        tmx::Map map;
+        std::size_t before = allocations.load();
+        map.parseFromFile(path);
+        return allocations.load() - before;
+    }
+} // namespace
+
+// Allocations of the whole test binary are counted, only those made while a map is parsed end up in stats
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    tmx::ParseStats::recordAllocation();
+    if(void* pointer = std::malloc(size != 0 ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+// Upper bounds with some headroom, most of what is left are the pimpls of tiles, objects and their properties
+TEST(AllocationsTest, Parse) {
+    EXPECT_LE(countAllocations("assets/pf1.tmx"), 900);
+    EXPECT_LE(countAllocations("assets/pf1_base64.tmx"), 930);
+    EXPECT_LE(countAllocations("assets/pf1_zlib.tmx"), 930);
+    EXPECT_LE(countAllocations("assets/pf1_external.tmx"), 930);
+    EXPECT_LE(countAllocations("assets/pf1.tmj"), 950);
+}
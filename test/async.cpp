@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <stop_token>
+#include <tmxpp.hpp>
+#include <vector>
+
+TEST(AsyncTest, Progress) {
+    std::vector<tmx::ParseProgress> events;
+    tmx::ParseOptions options;
+    options.backend = tmx::ParseOptions::Backend::DOM;
+    options.progress = [&events](const tmx::ParseProgress& progress) { events.push_back(progress); };
+
+    tmx::Map map = tmx::Map::parseFromFileAsync("assets/pf1.tmx", nullptr, options).get();
+    EXPECT_EQ(map.width(), 128);
+    EXPECT_EQ(map.layers().size(), 3);
+
+    ASSERT_EQ(events.size(), 6);
+    EXPECT_EQ(events[0].stage, tmx::ParseProgress::Stage::XML_PARSED);
+    EXPECT_EQ(events[1].stage, tmx::ParseProgress::Stage::TILESET_LOADED);
+    EXPECT_EQ(events[1].index, 0);
+    EXPECT_EQ(events[1].count, 1);
+    for(int i = 0; i < 3; i++) {
+        EXPECT_EQ(events[2 + i].stage, tmx::ParseProgress::Stage::LAYER_PARSED);
+        EXPECT_EQ(events[2 + i].index, i);
+        EXPECT_EQ(events[2 + i].count, 3);
+    }
+    EXPECT_EQ(events[5].stage, tmx::ParseProgress::Stage::FINISHED);
+}
+
+TEST(AsyncTest, StreamingProgress) {
+    std::vector<tmx::ParseProgress> events;
+    tmx::ParseOptions options;
+    options.progress = [&events](const tmx::ParseProgress& progress) { events.push_back(progress); };
+
+    tmx::Map map = tmx::Map::parseFromFileAsync("assets/pf1.tmx", nullptr, options).get();
+    EXPECT_EQ(map.layers().size(), 3);
+
+    // Element counts are not known in advance, but input position is
+    ASSERT_EQ(events.size(), 6);
+    for(std::size_t i = 1; i < events.size(); i++) {
+        EXPECT_GE(events[i].bytesParsed, events[i - 1].bytesParsed);
+        EXPECT_EQ(events[i].bytesTotal, events[0].bytesTotal);
+    }
+    EXPECT_EQ(events[2].stage, tmx::ParseProgress::Stage::LAYER_PARSED);
+    EXPECT_EQ(events[2].count, 0);
+    EXPECT_LT(events[2].bytesParsed, events[2].bytesTotal);
+    EXPECT_EQ(events[5].stage, tmx::ParseProgress::Stage::FINISHED);
+    EXPECT_EQ(events[5].bytesParsed, events[5].bytesTotal);
+}
+
+TEST(AsyncTest, CancelBeforeStart) {
+    std::stop_source source;
+    source.request_stop();
+    tmx::ParseOptions options;
+    options.stopToken = source.get_token();
+
+    auto future = tmx::Map::parseFromFileAsync("assets/pf1.tmx", nullptr, options);
+    EXPECT_THROW(future.get(), tmx::CancelledException);
+}
+
+TEST(AsyncTest, CancelBetweenStages) {
+    std::stop_source source;
+    int layers = 0;
+    tmx::ParseOptions options;
+    options.stopToken = source.get_token();
+    options.progress = [&](const tmx::ParseProgress& progress) {
+        if(progress.stage == tmx::ParseProgress::Stage::LAYER_PARSED) {
+            layers++;
+            source.request_stop();
+        }
+    };
+
+    tmx::Map map;
+    EXPECT_THROW(map.parseFromFile("assets/pf1.tmx", nullptr, options), tmx::CancelledException);
+    EXPECT_EQ(layers, 1);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+
+static std::string collectionMap(int count, int firstSize) {
+    std::string tiles;
+    for(int i = 0; i < count; i++) {
+        // Sparse ids and a few sizes
+        int size = firstSize >> (i % 3);
+        std::string id = std::to_string(i * 2);
+        tiles += "<tile id=\"" + id + "\"><image source=\"tile" + id + ".png\" width=\"" + std::to_string(size) +
+                 "\" height=\"" + std::to_string(size / 2) + "\"/></tile>";
+    }
+    return "<map version=\"1.10\" orientation=\"orthogonal\" width=\"4\" height=\"4\" tilewidth=\"16\" "
+           "tileheight=\"16\">"
+           " <tileset firstgid=\"1\" name=\"sheet\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"4\" columns=\"2\">"
+           "  <image source=\"sheet.png\" width=\"32\" height=\"32\"/>"
+           " </tileset>"
+           " <tileset firstgid=\"5\" name=\"collection\" tilewidth=\"64\" tileheight=\"64\" tilecount=\"" +
+           std::to_string(count) + "\" columns=\"0\">" + tiles +
+           "  <tile id=\"100\"><image source=\"sheet.png\" width=\"64\" height=\"64\"/></tile>"
+           "  <tile id=\"101\" x=\"16\" y=\"8\" width=\"8\" height=\"4\"><image source=\"sheet.png\" width=\"64\" "
+           "height=\"64\"/></tile>"
+           " </tileset>"
+           "</map>";
+}
+
+static void expectNoOverlap(const tmx::AtlasLayout& layout, int padding) {
+    for(const tmx::AtlasLayout::Slot& slot : layout.slots) {
+        EXPECT_GE(slot.x, padding);
+        EXPECT_GE(slot.y, padding);
+        EXPECT_LE(slot.x + slot.width + padding, layout.width);
+        EXPECT_LE(slot.y + slot.height + padding, layout.height);
+        EXPECT_LT(slot.page, layout.pages);
+        for(const tmx::AtlasLayout::Slot& other : layout.slots) {
+            if(&slot == &other || slot.page != other.page) {
+                continue;
+            }
+            bool apart = slot.x + slot.width + (2 * padding) <= other.x ||
+                         other.x + other.width + (2 * padding) <= slot.x ||
+                         slot.y + slot.height + (2 * padding) <= other.y ||
+                         other.y + other.height + (2 * padding) <= slot.y;
+            EXPECT_TRUE(apart);
+        }
+    }
+}
+
+TEST(AtlasTest, Pack) {
+    tmx::Map map;
+    map.parseFromData(collectionMap(20, 64));
+    tmx::AtlasLayout layout = tmx::AtlasLayout::pack(map.tilesets());
+
+    ASSERT_EQ(layout.slots.size(), 22);
+    EXPECT_EQ(layout.pages, 1);
+    expectNoOverlap(layout, 1);
+    EXPECT_LE(layout.width, 256);
+
+    // Tilesets with a single image have no slots
+    EXPECT_TRUE(layout.localSlots[0].empty());
+    EXPECT_EQ(layout.slot(1), -1);
+    ASSERT_EQ(layout.localSlots[1].size(), 102);
+    EXPECT_EQ(layout.localSlots[1][1], -1);
+
+    int slot = layout.localSlots[1][2];
+    ASSERT_NE(slot, -1);
+    EXPECT_EQ(layout.slots[slot].tileset, 1);
+    EXPECT_EQ(layout.slots[slot].id, 2);
+    EXPECT_EQ(layout.slots[slot].width, 32);
+    EXPECT_EQ(layout.slots[slot].height, 16);
+    EXPECT_EQ(layout.slot(5 + 2), slot);
+    EXPECT_EQ(layout.slot((5 + 2) | 0x80000000U), slot);
+    EXPECT_EQ(layout.slot(5 + 1), -1);
+    EXPECT_EQ(layout.slot(1000), -1);
+
+    // Sub-rectangle of an image
+    const tmx::AtlasLayout::Slot& subrect = layout.slots[layout.slot(5 + 101)];
+    EXPECT_EQ(subrect.width, 8);
+    EXPECT_EQ(subrect.height, 4);
+    EXPECT_EQ(subrect.source.x, 16);
+    EXPECT_EQ(subrect.source.y, 8);
+    EXPECT_EQ(layout.gidSlots.size(), 5 + 101 + 1);
+}
+
+TEST(AtlasTest, Pages) {
+    tmx::Map map;
+    map.parseFromData(collectionMap(40, 64));
+    tmx::AtlasOptions options;
+    options.maxWidth = 128;
+    options.maxHeight = 128;
+    options.padding = 2;
+    tmx::AtlasLayout layout = tmx::AtlasLayout::pack(map.tilesets(), options);
+
+    EXPECT_GT(layout.pages, 1);
+    EXPECT_LE(layout.width, 128);
+    EXPECT_LE(layout.height, 128);
+    expectNoOverlap(layout, 2);
+
+    options.maxWidth = 64;
+    EXPECT_THROW(static_cast<void>(tmx::AtlasLayout::pack(map.tilesets(), options)), tmx::Exception);
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <tmxpp.hpp>
+
+static void expectSameCells(const tmx::Map& expected, const tmx::Map& actual) {
+    ASSERT_EQ(actual.layers().size(), expected.layers().size());
+    for(std::size_t i = 0; i < expected.layers().size(); i++) {
+        ASSERT_EQ(actual.layers()[i].type(), expected.layers()[i].type());
+        if(expected.layers()[i].type() != tmx::Layer::Type::TILE) {
+            continue;
+        }
+        const tmx::TileLayer& expectedLayer = expected.layers()[i].tileLayer();
+        const tmx::TileLayer& actualLayer = actual.layers()[i].tileLayer();
+        EXPECT_EQ(actualLayer.name(), expectedLayer.name());
+        ASSERT_EQ(actualLayer.width(), expectedLayer.width());
+        ASSERT_EQ(actualLayer.height(), expectedLayer.height());
+        ASSERT_EQ(actualLayer.cells().size(), expectedLayer.cells().size());
+        EXPECT_EQ(std::memcmp(actualLayer.cells().data(), expectedLayer.cells().data(),
+                      expectedLayer.cells().size() * sizeof(std::uint32_t)),
+            0);
+        EXPECT_EQ(actualLayer.data(), expectedLayer.data());
+    }
+}
+
+TEST(BakedTest, RoundTrip) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_external.tmx");
+
+    tmx::Map baked;
+    baked.loadBakedFromData(map.bake());
+    EXPECT_EQ(baked.version(), map.version());
+    EXPECT_EQ(baked.width(), map.width());
+    EXPECT_EQ(baked.height(), map.height());
+    ASSERT_EQ(baked.tilesets().size(), 1);
+    EXPECT_EQ(baked.tilesets()[0].source(), "pf1_external.tsx");
+    EXPECT_EQ(baked.tilesets()[0].tileCount(), 132);
+    EXPECT_EQ(baked.tilesets()[0].image().source(), map.tilesets()[0].image().source());
+    expectSameCells(map, baked);
+}
+
+TEST(BakedTest, PropertiesAndObjects) {
+    std::string data =
+        "<map version=\"1.10\" orientation=\"hexagonal\" width=\"2\" height=\"1\" backgroundcolor=\"#80112233\">"
+        " <properties>"
+        "  <property name=\"name\" value=\"level\"/>"
+        "  <property name=\"count\" type=\"int\" value=\"-7\"/>"
+        "  <property name=\"speed\" type=\"float\" value=\"1.5\"/>"
+        "  <property name=\"enabled\" type=\"bool\" value=\"true\"/>"
+        "  <property name=\"nested\" type=\"class\"><properties>"
+        "   <property name=\"inner\" type=\"int\" value=\"3\"/>"
+        "  </properties></property>"
+        " </properties>"
+        " <layer id=\"1\" name=\"tiles\" width=\"2\" height=\"1\">"
+        "  <data encoding=\"csv\">2147483649,7</data>"
+        " </layer>"
+        " <objectgroup id=\"2\" name=\"objects\" color=\"#FF00FF00\">"
+        "  <object id=\"1\" name=\"area\" x=\"1\" y=\"2\" width=\"3\" height=\"4\"><ellipse width=\"3\" height=\"4\"/></object>"
+        "  <object id=\"2\" x=\"5\" y=\"6\"><point x=\"5\" y=\"6\"/></object>"
+        "  <object id=\"3\" x=\"0\" y=\"0\"><polygon points=\"0,0 1,0 1,1\"/></object>"
+        "  <object id=\"4\" x=\"0\" y=\"0\"><text bold=\"1\">Hello</text></object>"
+        "  <object id=\"5\" x=\"0\" y=\"0\">"
+        "   <properties><property name=\"target\" type=\"object\" value=\"1\"/></properties>"
+        "  </object>"
+        " </objectgroup>"
+        "</map>";
+
+    tmx::Map map;
+    map.parseFromData(data);
+    tmx::Map baked;
+    baked.loadBakedFromData(map.bake());
+
+    EXPECT_EQ(baked.orientation(), tmx::Map::Orientation::HEXAGONAL);
+    EXPECT_EQ(baked.backgroundColor().a, map.backgroundColor().a);
+    EXPECT_EQ(baked.backgroundColor().r, map.backgroundColor().r);
+    EXPECT_EQ(baked.property("name").stringValue(), "level");
+    EXPECT_EQ(baked.property("count").intValue(), -7);
+    EXPECT_FLOAT_EQ(baked.property("speed").floatValue(), 1.5F);
+    EXPECT_TRUE(baked.property("enabled").boolValue());
+    EXPECT_EQ(baked.property("nested").type(), tmx::Type::CLASS);
+    EXPECT_EQ(baked.property("nested").classValue().property("inner").intValue(), 3);
+    expectSameCells(map, baked);
+    EXPECT_TRUE(baked.layers()[0].tileLayer().flipHorizontal(0, 0));
+
+    const tmx::ObjectGroup& objectGroup = baked.layers()[1].objectGroup();
+    EXPECT_EQ(objectGroup.name(), "objects");
+    EXPECT_EQ(objectGroup.color().g, map.layers()[1].objectGroup().color().g);
+    ASSERT_EQ(objectGroup.objects().size(), 5);
+    EXPECT_EQ(objectGroup.objects()[0].name(), "area");
+    EXPECT_EQ(objectGroup.objects()[0].type(), tmx::Object::Type::ELLIPSE);
+    EXPECT_FLOAT_EQ(objectGroup.objects()[0].ellipse().size.y, 4);
+    EXPECT_EQ(objectGroup.objects()[1].type(), tmx::Object::Type::POINT);
+    EXPECT_FLOAT_EQ(objectGroup.objects()[1].point().y, 6);
+    ASSERT_EQ(objectGroup.objects()[2].polygon().size(), 3);
+    EXPECT_FLOAT_EQ(objectGroup.objects()[2].polygon()[2].y, 1);
+    EXPECT_EQ(objectGroup.objects()[3].text().text(), "Hello");
+    EXPECT_TRUE(objectGroup.objects()[3].text().bold());
+    EXPECT_EQ(objectGroup.objects()[4].property("target").objectValue(), 1);
+}
+
+TEST(BakedTest, MappedFileInPlace) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_zstd.tmx");
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "tmxpp_baked_test.tmxb";
+    map.bakeToFile(path);
+
+    tmx::Buffer buffer = tmx::Buffer::fromFile(path);
+    tmx::Map baked;
+    baked.loadBakedFromData(buffer);
+    expectSameCells(map, baked);
+
+    // Tile data points into the mapping instead of being copied
+    const std::uint32_t* cells = baked.layers()[0].tileLayer().cells().data();
+    EXPECT_GE(reinterpret_cast<const char*>(cells), buffer.data());
+    EXPECT_LT(reinterpret_cast<const char*>(cells), buffer.data() + buffer.size());
+
+    tmx::Map fromFile;
+    fromFile.loadBaked(path);
+    expectSameCells(map, fromFile);
+    std::filesystem::remove(path);
+}
+
+TEST(BakedTest, Errors) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1.tmx");
+    std::string data = map.bake();
+
+    tmx::Map baked;
+    EXPECT_THROW(baked.loadBakedFromData(std::string("TMXB")), tmx::Exception);
+    EXPECT_THROW(baked.loadBakedFromData(std::string(64, 'x')), tmx::Exception);
+    EXPECT_THROW(baked.loadBakedFromData(data.substr(0, data.size() / 2)), tmx::Exception);
+
+    std::string wrongVersion = data;
+    wrongVersion[4] = 99;
+    EXPECT_THROW(baked.loadBakedFromData(wrongVersion), tmx::Exception);
+}
+
+TEST(BakedTest, CorruptedCounts) {
+    // Ids are distinctive so their counts can be found in the baked map
+    tmx::Map map;
+    map.parseFromData("<map width=\"1\" height=\"1\">"
+                      " <tileset firstgid=\"1\" name=\"tiles\" tilecount=\"1\">"
+                      "  <tile id=\"0\"><animation><frame tileid=\"0\" duration=\"305419896\"/></animation></tile>"
+                      " </tileset>"
+                      " <objectgroup id=\"1\"><object id=\"305419896\"/></objectgroup>"
+                      "</map>");
+    std::string data = map.bake();
+    std::string id = "\x78\x56\x34\x12";
+    for(const std::string& counted : {std::string("\1\0\0\0", 4) + id, std::string("\1\0\0\0\0\0\0\0", 8) + id}) {
+        std::string corrupted = data;
+        std::size_t offset = corrupted.find(counted);
+        ASSERT_NE(offset, std::string::npos);
+        corrupted.replace(offset, 4, "\xFF\xFF\xFF\xFF");
+        tmx::Map baked;
+        EXPECT_THROW(baked.loadBakedFromData(corrupted), tmx::Exception);
+    }
+
+    // Nesting of groups is limited so corrupted maps can't overflow the stack
+    std::string nested = "<map width=\"1\" height=\"1\">";
+    for(int i = 0; i < 300; i++) {
+        nested += "<group>";
+    }
+    for(int i = 0; i < 300; i++) {
+        nested += "</group>";
+    }
+    map.parseFromData(nested + "</map>");
+    tmx::Map baked;
+    EXPECT_THROW(baked.loadBakedFromData(map.bake()), tmx::Exception);
+}
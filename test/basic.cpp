@@ -194,3 +194,8 @@ TEST_F(BasicTest, PolygonObject) {
     ASSERT_DOUBLE_EQ(polygon[3].x, 0);
     ASSERT_DOUBLE_EQ(polygon[3].y, 16);
 }
+
+TEST(BasicFileTest, MissingFile) {
+    tmx::Map map;
+    EXPECT_THROW(map.parseFromFile("assets/missing.tmx"), tmx::Exception);
+}
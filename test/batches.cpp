@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+
+static std::string batchMap(const std::string& tiles) {
+    return "<map version=\"1.10\" orientation=\"orthogonal\" width=\"5\" height=\"3\" tilewidth=\"16\" "
+           "tileheight=\"16\">"
+           " <tileset firstgid=\"1\" name=\"sheet\" tilewidth=\"16\" tileheight=\"16\" spacing=\"2\" margin=\"1\" "
+           "tilecount=\"4\" columns=\"2\">"
+           "  <tileoffset x=\"2\" y=\"-3\"/>"
+           "  <image source=\"sheet.png\" width=\"36\" height=\"36\"/>"
+           " </tileset>"
+           " <tileset firstgid=\"5\" name=\"collection\" tilewidth=\"32\" tileheight=\"48\" tilecount=\"1\" "
+           "columns=\"0\">"
+           "  <tile id=\"0\"><image source=\"tree.png\" width=\"32\" height=\"48\"/></tile>"
+           " </tileset>"
+           " <layer id=\"1\" name=\"tiles\" width=\"5\" height=\"3\"><data encoding=\"csv\">" +
+           tiles + "</data></layer></map>";
+}
+
+// Horizontally flipped 2 and diagonally flipped 1 on the second row
+static const std::string batchTiles = "1,2,0,5,3,2147483650,536870913,4,0,0,0,0,0,0,1";
+
+static void expectVertex(const tmx::TileBatches::Vertex& vertex, float x, float y, float u, float v) {
+    EXPECT_FLOAT_EQ(vertex.x, x);
+    EXPECT_FLOAT_EQ(vertex.y, y);
+    EXPECT_FLOAT_EQ(vertex.u, u);
+    EXPECT_FLOAT_EQ(vertex.v, v);
+}
+
+TEST(BatchesTest, Chunks) {
+    tmx::Map map;
+    map.parseFromData(batchMap(batchTiles));
+    tmx::BatchOptions options;
+    options.chunkSize = 2;
+    tmx::TileBatches batches(map, map.layers()[0].tileLayer(), options);
+
+    EXPECT_EQ(batches.columns(), 3);
+    EXPECT_EQ(batches.rows(), 2);
+    ASSERT_EQ(batches.chunks().size(), 6);
+    const tmx::TileBatches::Chunk& corner = batches.chunks()[2];
+    EXPECT_EQ(corner.cells.x, 4);
+    EXPECT_EQ(corner.cells.width, 1);
+    EXPECT_EQ(corner.cells.height, 2);
+    EXPECT_EQ(batches.chunks()[4].cells.height, 1);
+
+    // Four quads of the sheet in cell order, moved by the tile offset
+    const tmx::TileBatches::Chunk& first = batches.chunks()[0];
+    ASSERT_EQ(first.ranges.size(), 1);
+    EXPECT_EQ(first.ranges[0].tileset, 0);
+    EXPECT_EQ(first.ranges[0].tile, -1);
+    EXPECT_EQ(first.ranges[0].count, 4);
+    ASSERT_EQ(first.vertices.size(), 16);
+    expectVertex(first.vertices[0], 2, -3, 1 / 36.0F, 1 / 36.0F);
+    expectVertex(first.vertices[2], 18, 13, 17 / 36.0F, 17 / 36.0F);
+    expectVertex(first.vertices[4], 18, -3, 19 / 36.0F, 1 / 36.0F);
+    // Flips swap texture coordinates only
+    expectVertex(first.vertices[8], 2, 13, 35 / 36.0F, 1 / 36.0F);
+    expectVertex(first.vertices[9], 18, 13, 19 / 36.0F, 1 / 36.0F);
+    expectVertex(first.vertices[13], 34, 13, 1 / 36.0F, 17 / 36.0F);
+    expectVertex(first.vertices[15], 18, 29, 17 / 36.0F, 1 / 36.0F);
+
+    // One range per texture, collection tiles are sized by their image and aligned to the bottom of the cell
+    const tmx::TileBatches::Chunk& second = batches.chunks()[1];
+    ASSERT_EQ(second.ranges.size(), 2);
+    EXPECT_EQ(second.ranges[0].count, 1);
+    EXPECT_EQ(second.ranges[1].tileset, 1);
+    EXPECT_EQ(second.ranges[1].tile, 0);
+    EXPECT_EQ(second.ranges[1].first, 1);
+    expectVertex(second.vertices[4], 48, -32, 0, 0);
+    expectVertex(second.vertices[6], 80, 16, 1, 1);
+
+    EXPECT_TRUE(batches.chunks()[3].vertices.empty());
+    EXPECT_TRUE(batches.chunks()[3].ranges.empty());
+    EXPECT_EQ(batches.chunks()[3].version, 1);
+}
+
+TEST(BatchesTest, Dirty) {
+    tmx::Map map;
+    map.parseFromData(batchMap(batchTiles));
+    tmx::Map target;
+    target.parseFromData(batchMap("1,2,0,5,3,2147483650,536870913,4,0,0,0,0,0,0,0"));
+    tmx::BatchOptions options;
+    options.chunkSize = 2;
+    tmx::TileLayer layer = map.layers()[0].tileLayer();
+    tmx::TileBatches batches(map, layer, options);
+    EXPECT_EQ(batches.update(layer), 0);
+
+    layer.applyPatch(target.layers()[0].tileLayer().diff(layer));
+    batches.markDirty({.x = 4, .y = 2, .width = 1, .height = 1});
+    EXPECT_EQ(batches.update(layer), 1);
+    EXPECT_TRUE(batches.chunks()[5].vertices.empty());
+    EXPECT_EQ(batches.chunks()[5].version, 2);
+    EXPECT_EQ(batches.chunks()[0].version, 1);
+
+    // Areas outside of the layer are ignored
+    batches.markDirty({.x = -4, .y = 3, .width = 20, .height = 2});
+    EXPECT_EQ(batches.update(layer), 0);
+    batches.markAllDirty();
+    EXPECT_EQ(batches.update(layer), 6);
+}
+
+TEST(BatchesTest, Threads) {
+    tmx::Map map;
+    map.parseFromData(batchMap(batchTiles));
+    tmx::BatchOptions options;
+    options.chunkSize = 1;
+    options.threads = 1;
+    tmx::TileBatches serial(map, map.layers()[0].tileLayer(), options);
+    options.threads = 4;
+    tmx::TileBatches parallel(map, map.layers()[0].tileLayer(), options);
+
+    ASSERT_EQ(serial.chunks().size(), parallel.chunks().size());
+    for(std::size_t i = 0; i < serial.chunks().size(); i++) {
+        const tmx::TileBatches::Chunk& chunk = serial.chunks()[i];
+        ASSERT_EQ(chunk.vertices.size(), parallel.chunks()[i].vertices.size());
+        for(std::size_t j = 0; j < chunk.vertices.size(); j++) {
+            const tmx::TileBatches::Vertex& other = parallel.chunks()[i].vertices[j];
+            expectVertex(chunk.vertices[j], other.x, other.y, other.u, other.v);
+        }
+    }
+
+    options.chunkSize = 0;
+    EXPECT_THROW(static_cast<void>(tmx::TileBatches(map, map.layers()[0].tileLayer(), options)), tmx::Exception);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+static std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+static void writeFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary);
+    file << data;
+}
+
+class CacheTest : public testing::Test {
+protected:
+    CacheTest() {
+        root = std::filesystem::temp_directory_path() / "tmxpp_cache_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "maps");
+        std::filesystem::copy_file("assets/pf1_external.tmx", root / "maps" / "pf1_external.tmx");
+        std::filesystem::copy_file("assets/pf1_external.tsx", root / "maps" / "pf1_external.tsx");
+        options.cacheDirectory = root / "cache";
+        options.progress = [this](const tmx::ParseProgress& progress) { stages.push_back(progress.stage); };
+    }
+
+    ~CacheTest() override { std::filesystem::remove_all(root); }
+
+    // Parses the map and returns whether it was loaded from the cache
+    bool parse(tmx::Map& map, const tmx::LoaderType& loader = nullptr) {
+        stages.clear();
+        map.parseFromFile(root / "maps" / "pf1_external.tmx", loader, options);
+        return stages.size() == 1 && stages[0] == tmx::ParseProgress::Stage::FINISHED;
+    }
+
+    std::filesystem::path root;
+    tmx::ParseOptions options;
+    std::vector<tmx::ParseProgress::Stage> stages;
+};
+
+TEST_F(CacheTest, Hit) {
+    tmx::Map parsed;
+    EXPECT_FALSE(parse(parsed));
+    EXPECT_FALSE(std::filesystem::is_empty(root / "cache"));
+
+    tmx::Map cached;
+    EXPECT_TRUE(parse(cached));
+    ASSERT_EQ(cached.tilesets().size(), 1);
+    EXPECT_EQ(cached.tilesets()[0].tileCount(), 132);
+    ASSERT_EQ(cached.layers().size(), parsed.layers().size());
+    EXPECT_EQ(cached.layers()[0].tileLayer().data(), parsed.layers()[0].tileLayer().data());
+
+    // Touching a file without changing it keeps the entry valid
+    std::filesystem::last_write_time(
+        root / "maps" / "pf1_external.tsx", std::filesystem::file_time_type::clock::now() + std::chrono::hours(1));
+    tmx::Map touched;
+    EXPECT_TRUE(parse(touched));
+}
+
+TEST_F(CacheTest, DependencyChanged) {
+    tmx::Map parsed;
+    EXPECT_FALSE(parse(parsed));
+
+    std::filesystem::path tileset = root / "maps" / "pf1_external.tsx";
+    std::string data = readFile(tileset);
+    data.replace(data.find("tilecount=\"132\""), 15, "tilecount=\"13\"");
+    writeFile(tileset, data);
+
+    tmx::Map changed;
+    EXPECT_FALSE(parse(changed));
+    EXPECT_EQ(changed.tilesets()[0].tileCount(), 13);
+
+    tmx::Map cached;
+    EXPECT_TRUE(parse(cached));
+    EXPECT_EQ(cached.tilesets()[0].tileCount(), 13);
+}
+
+TEST_F(CacheTest, CustomLoader) {
+    std::map<std::filesystem::path, std::string> pak;
+    pak[root / "maps" / "pf1_external.tmx"] = readFile(root / "maps" / "pf1_external.tmx");
+    pak[root / "maps" / "pf1_external.tsx"] = readFile(root / "maps" / "pf1_external.tsx");
+    tmx::LoaderType loader = [&pak](const std::filesystem::path& path) { return pak.at(path.lexically_normal()); };
+
+    tmx::Map parsed;
+    EXPECT_FALSE(parse(parsed, loader));
+    tmx::Map cached;
+    EXPECT_TRUE(parse(cached, loader));
+
+    // Loaded files are compared by content hash
+    std::string& map = pak[root / "maps" / "pf1_external.tmx"];
+    map.replace(map.find("name=\"layer2\""), 13, "name=\"renamed\"");
+    tmx::Map changed;
+    EXPECT_FALSE(parse(changed, loader));
+    EXPECT_EQ(changed.layers()[0].tileLayer().name(), "renamed");
+}
+
+TEST_F(CacheTest, CorruptedEntry) {
+    tmx::Map parsed;
+    EXPECT_FALSE(parse(parsed));
+    for(const auto& entry : std::filesystem::directory_iterator(root / "cache")) {
+        std::string data = readFile(entry.path());
+        writeFile(entry.path(), data.substr(0, data.size() / 2));
+    }
+
+    tmx::Map reparsed;
+    EXPECT_FALSE(parse(reparsed));
+    EXPECT_EQ(reparsed.tilesets()[0].tileCount(), 132);
+    tmx::Map cached;
+    EXPECT_TRUE(parse(cached));
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+static std::string collisionMap(const std::vector<unsigned int>& ground, const std::vector<unsigned int>& bridges) {
+    auto data = [](const std::vector<unsigned int>& cells) {
+        std::string result;
+        for(unsigned int gid : cells) {
+            result += (result.empty() ? "" : ",") + std::to_string(gid);
+        }
+        return result;
+    };
+    return "<map version=\"1.10\" orientation=\"orthogonal\" width=\"70\" height=\"2\" tilewidth=\"8\" tileheight=\"8\">"
+           " <tileset firstgid=\"1\" name=\"terrain\" tilewidth=\"8\" tileheight=\"8\" tilecount=\"8\" columns=\"4\">"
+           "  <image source=\"terrain.png\" width=\"32\" height=\"16\"/>"
+           "  <tile id=\"0\"><properties><property name=\"solid\" type=\"bool\" value=\"true\"/></properties></tile>"
+           "  <tile id=\"1\"><properties><property name=\"solid\" type=\"bool\" value=\"false\"/></properties></tile>"
+           "  <tile id=\"2\"><properties><property name=\"kind\" value=\"wall\"/></properties></tile>"
+           "  <tile id=\"3\"><objectgroup draworder=\"index\" id=\"2\">"
+           "   <object id=\"1\" x=\"0\" y=\"0\" width=\"8\" height=\"4\"/></objectgroup></tile>"
+           "  <tile id=\"4\"><properties><property name=\"height\" type=\"float\" value=\"1.5\"/></properties></tile>"
+           " </tileset>"
+           " <layer id=\"1\" name=\"ground\" width=\"70\" height=\"2\"><data encoding=\"csv\">" +
+           data(ground) +
+           "</data></layer>"
+           " <layer id=\"2\" name=\"bridges\" width=\"70\" height=\"2\"><data encoding=\"csv\">" +
+           data(bridges) + "</data></layer></map>";
+}
+
+TEST(CollisionTest, Layer) {
+    std::vector<unsigned int> ground(140);
+    std::vector<unsigned int> bridges(140);
+    for(std::size_t i = 0; i < ground.size(); i++) {
+        ground[i] = i % 7;
+        bridges[i] = i % 3 == 0 ? 1 : 0;
+    }
+    // Flipped and out of range GIDs
+    ground[65] = 0x80000000U | 1U;
+    ground[66] = 100;
+    tmx::Map map;
+    map.parseFromData(collisionMap(ground, bridges));
+    const tmx::TileLayer& layer = map.layers()[0].tileLayer();
+
+    int calls = 0;
+    tmx::CollisionGrid grid = tmx::CollisionGrid::fromLayer(map, layer, [&calls](const tmx::Tile& tile) {
+        calls++;
+        return tile.id() == 0 || tile.id() == 3;
+    });
+    EXPECT_EQ(calls, 5);
+    EXPECT_EQ(grid.width(), 70);
+    EXPECT_EQ(grid.height(), 2);
+    EXPECT_EQ(grid.wordsPerRow(), 2);
+    for(int y = 0; y < 2; y++) {
+        for(int x = 0; x < 70; x++) {
+            int gid = layer.at(x, y);
+            EXPECT_EQ(grid.at(x, y), gid == 1 || gid == 4) << x << ", " << y;
+        }
+        // Padding bits are clear
+        EXPECT_EQ(grid.row(y)[1] >> 6U, 0);
+    }
+    EXPECT_TRUE(grid.at(65, 0));
+    EXPECT_FALSE(grid.at(66, 0));
+    EXPECT_FALSE(grid.at(-1, 0));
+    EXPECT_FALSE(grid.at(0, 2));
+}
+
+TEST(CollisionTest, Predicates) {
+    tmx::Map map;
+    map.parseFromData(collisionMap(std::vector<unsigned int>(140, 0), std::vector<unsigned int>(140, 0)));
+    auto solid = [&map](const tmx::TilePredicate& predicate) {
+        std::vector<int> gids;
+        std::vector<std::uint8_t> flags = tmx::CollisionGrid::solidTiles(map, predicate);
+        for(std::size_t gid = 0; gid < flags.size(); gid++) {
+            if(flags[gid] != 0) {
+                gids.push_back(static_cast<int>(gid));
+            }
+        }
+        return gids;
+    };
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("solid")), std::vector<int>({1}));
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("kind")), std::vector<int>({3}));
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("kind", "wall")), std::vector<int>({3}));
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("kind", "floor")), std::vector<int>());
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("solid", "false")), std::vector<int>({2}));
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("height", "1.5")), std::vector<int>({5}));
+    EXPECT_EQ(solid(tmx::CollisionGrid::withProperty("height", "1.50x")), std::vector<int>());
+    EXPECT_EQ(solid(tmx::CollisionGrid::withCollisionObjects()), std::vector<int>({4}));
+}
+
+TEST(CollisionTest, Combine) {
+    std::vector<unsigned int> ground(140, 1);
+    std::vector<unsigned int> bridges(140, 0);
+    ground[3] = 0;
+    bridges[3] = 1;
+    bridges[69] = 1;
+    bridges[139] = 1;
+    tmx::Map map;
+    map.parseFromData(collisionMap(ground, bridges));
+    std::vector<std::uint8_t> flags = tmx::CollisionGrid::solidTiles(map, tmx::CollisionGrid::withProperty("solid"));
+    tmx::CollisionGrid walls = tmx::CollisionGrid::fromLayer(map.layers()[0].tileLayer(), flags);
+    tmx::CollisionGrid over = tmx::CollisionGrid::fromLayer(map.layers()[1].tileLayer(), flags);
+
+    EXPECT_EQ(walls.count(), 139);
+    EXPECT_EQ((walls | over).count(), 140);
+    EXPECT_EQ((walls & over).count(), 2);
+    EXPECT_EQ((walls ^ over).count(), 138);
+    tmx::CollisionGrid passable = walls;
+    passable.subtract(over);
+    EXPECT_EQ(passable.count(), 137);
+    EXPECT_FALSE(passable.at(69, 0));
+    passable.set(69, 0, true);
+    passable.set(5, 1, false);
+    EXPECT_TRUE(passable.at(69, 0));
+    EXPECT_FALSE(passable.at(5, 1));
+    EXPECT_NE(passable, walls);
+
+    EXPECT_THROW(passable.set(70, 0, true), tmx::Exception);
+    EXPECT_THROW(passable |= tmx::CollisionGrid(70, 3), tmx::Exception);
+    EXPECT_THROW(tmx::CollisionGrid(1, -1), tmx::Exception);
+    EXPECT_THROW(tmx::CollisionGrid(-1, 1), tmx::Exception);
+}
+
+static tmx::CollisionGrid pattern(const std::vector<std::string>& rows) {
+    tmx::CollisionGrid grid(static_cast<int>(rows[0].size()), static_cast<int>(rows.size()));
+    for(std::size_t y = 0; y < rows.size(); y++) {
+        for(std::size_t x = 0; x < rows[y].size(); x++) {
+            grid.set(static_cast<int>(x), static_cast<int>(y), rows[y][x] == '#');
+        }
+    }
+    return grid;
+}
+
+static tmx::CollisionGrid randomGrid(int width, int height, unsigned int seed) {
+    tmx::CollisionGrid grid(width, height);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            seed = (seed * 1103515245U) + 12345U;
+            grid.set(x, y, ((seed >> 16U) % 3) != 0);
+        }
+    }
+    return grid;
+}
+
+TEST(CollisionTest, Rectangles) {
+    EXPECT_EQ(pattern({"###", "###"}).rectangles().size(), 1);
+    EXPECT_TRUE(pattern({"...", "..."}).rectangles().empty());
+    tmx::CollisionGrid comb = pattern({"#.", "##", "#."});
+    EXPECT_EQ(comb.rectangles(tmx::CollisionGrid::Merge::ROWS).size(), 3);
+    EXPECT_EQ(comb.rectangles(tmx::CollisionGrid::Merge::BEST).size(), 2);
+
+    // Every solid cell is covered exactly once
+    for(unsigned int seed : {1U, 2U, 3U}) {
+        tmx::CollisionGrid grid = randomGrid(150, 40, seed);
+        std::size_t rows = 0;
+        for(tmx::CollisionGrid::Merge merge : {tmx::CollisionGrid::Merge::ROWS, tmx::CollisionGrid::Merge::BEST}) {
+            std::vector<tmx::MapChanges::Rect> rects = grid.rectangles(merge);
+            tmx::CollisionGrid covered(grid.width(), grid.height());
+            int area = 0;
+            for(const tmx::MapChanges::Rect& rect : rects) {
+                for(int y = rect.y; y < rect.y + rect.height; y++) {
+                    for(int x = rect.x; x < rect.x + rect.width; x++) {
+                        EXPECT_FALSE(covered.at(x, y));
+                        covered.set(x, y, true);
+                    }
+                }
+                area += rect.width * rect.height;
+            }
+            EXPECT_EQ(covered, grid);
+            EXPECT_EQ(area, grid.count());
+            if(merge == tmx::CollisionGrid::Merge::ROWS) {
+                rows = rects.size();
+            } else {
+                EXPECT_LE(rects.size(), rows);
+            }
+        }
+    }
+}
+
+TEST(CollisionTest, Outlines) {
+    std::vector<std::vector<tmx::IntPoint>> square = pattern({"....", ".##.", ".##."}).outlines();
+    ASSERT_EQ(square.size(), 1);
+    ASSERT_EQ(square[0].size(), 4);
+    EXPECT_EQ(square[0][0].x, 1);
+    EXPECT_EQ(square[0][0].y, 1);
+    EXPECT_EQ(square[0][1].x, 3);
+    EXPECT_EQ(square[0][1].y, 1);
+    EXPECT_EQ(square[0][2].x, 3);
+    EXPECT_EQ(square[0][2].y, 3);
+
+    EXPECT_EQ(pattern({"###", "#.#", "###"}).outlines().size(), 2);
+    std::vector<std::vector<tmx::IntPoint>> corners = pattern({"#.", ".#"}).outlines();
+    ASSERT_EQ(corners.size(), 2);
+    EXPECT_EQ(corners[0].size(), 4);
+    EXPECT_EQ(corners[1].size(), 4);
+
+    // Outer outlines add their area and holes subtract theirs, edges are axis aligned
+    tmx::CollisionGrid grid = randomGrid(90, 30, 7);
+    int area = 0;
+    for(const std::vector<tmx::IntPoint>& outline : grid.outlines()) {
+        int twice = 0;
+        for(std::size_t i = 0; i < outline.size(); i++) {
+            const tmx::IntPoint& point = outline[i];
+            const tmx::IntPoint& next = outline[(i + 1) % outline.size()];
+            EXPECT_TRUE(point.x == next.x || point.y == next.y);
+            twice += (point.x * next.y) - (next.x * point.y);
+        }
+        area += twice / 2;
+    }
+    EXPECT_EQ(area, grid.count());
+}
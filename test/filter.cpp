@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+static const std::string data =
+    "<map width=\"2\" height=\"1\">"
+    " <properties><property name=\"map\" value=\"1\"/></properties>"
+    " <tileset firstgid=\"1\" name=\"tiles\" tilecount=\"4\">"
+    "  <tile id=\"0\"><animation><frame tileid=\"1\" duration=\"100\"/></animation></tile>"
+    " </tileset>"
+    " <layer id=\"1\" name=\"collision\" width=\"2\" height=\"1\">"
+    "  <properties><property name=\"solid\" type=\"bool\" value=\"true\"/></properties>"
+    "  <data encoding=\"csv\">1,2</data>"
+    " </layer>"
+    " <layer id=\"2\" name=\"decoration\" class=\"editor\" width=\"2\" height=\"1\">"
+    "  <data encoding=\"csv\">invalid</data>"
+    " </layer>"
+    " <objectgroup id=\"3\" name=\"objects\">"
+    "  <object id=\"1\" name=\"spawn\" class=\"spawn\" x=\"1\" y=\"2\">"
+    "   <properties><property name=\"team\" type=\"int\" value=\"2\"/></properties>"
+    "  </object>"
+    "  <object id=\"2\" name=\"label\" x=\"0\" y=\"0\"><text>Hello</text></object>"
+    "  <object id=\"3\" name=\"trigger\" x=\"0\" y=\"0\"><ellipse/></object>"
+    " </objectgroup>"
+    "</map>";
+
+TEST(FilterTest, Layers) {
+    tmx::ParseOptions options;
+    options.layerFilter = [](const tmx::LayerInfo& layer) {
+        return layer.type == tmx::LayerType::OBJECT || layer.name == "collision";
+    };
+
+    // Filtered out layer with invalid data is never decoded
+    tmx::Map map;
+    map.parseFromData(data, options);
+    ASSERT_EQ(map.layers().size(), 2);
+    EXPECT_EQ(map.layers()[0].tileLayer().name(), "collision");
+    EXPECT_EQ(map.layers()[0].tileLayer().at(1, 0), 2);
+    EXPECT_EQ(map.layers()[1].objectGroup().objects().size(), 3);
+
+    options.layerFilter = [](const tmx::LayerInfo& layer) { return layer.className != "editor"; };
+    tmx::Map byClass;
+    byClass.parseFromData(data, options);
+    EXPECT_EQ(byClass.layers().size(), 2);
+}
+
+TEST(FilterTest, Objects) {
+    tmx::ParseOptions options;
+    options.layerFilter = [](const tmx::LayerInfo& layer) { return layer.id != 2; };
+    options.objectFilter = [](const tmx::ObjectInfo& object) { return object.className == "spawn"; };
+
+    tmx::Map map;
+    map.parseFromData(data, options);
+    const tmx::ObjectGroup& objectGroup = map.layers()[1].objectGroup();
+    ASSERT_EQ(objectGroup.objects().size(), 1);
+    EXPECT_EQ(objectGroup.objects()[0].name(), "spawn");
+    EXPECT_EQ(objectGroup.objects()[0].property("team").intValue(), 2);
+    EXPECT_EQ(objectGroup.objects()[0].className(), "spawn");
+
+    // Tiled before 1.9 wrote object class as "type"
+    std::string legacy = data;
+    legacy.replace(legacy.find("class=\"spawn\""), 5, "type");
+    tmx::Map legacyMap;
+    legacyMap.parseFromData(legacy, options);
+    EXPECT_EQ(legacyMap.layers()[1].objectGroup().objects().size(), 1);
+}
+
+TEST(FilterTest, Skip) {
+    tmx::ParseOptions options;
+    options.layerFilter = [](const tmx::LayerInfo& layer) { return layer.id != 2; };
+    options.skipProperties = true;
+    options.skipText = true;
+    options.skipTileMetadata = true;
+
+    tmx::Map map;
+    map.parseFromData(data, options);
+    EXPECT_TRUE(map.properties().empty());
+    ASSERT_EQ(map.tilesets().size(), 1);
+    EXPECT_EQ(map.tilesets()[0].tileCount(), 4);
+    EXPECT_TRUE(map.tilesets()[0].tiles().empty());
+    EXPECT_TRUE(map.layers()[0].tileLayer().properties().empty());
+
+    const tmx::ObjectGroup& objectGroup = map.layers()[1].objectGroup();
+    ASSERT_EQ(objectGroup.objects().size(), 2);
+    EXPECT_EQ(objectGroup.objects()[0].name(), "spawn");
+    EXPECT_TRUE(objectGroup.objects()[0].properties().empty());
+    EXPECT_EQ(objectGroup.objects()[1].type(), tmx::Object::Type::ELLIPSE);
+
+    options.skipTilesets = true;
+    // Skipped tilesets still advance progress
+    std::vector<int> tilesetIndices;
+    options.progress = [&tilesetIndices](const tmx::ParseProgress& progress) {
+        if(progress.stage == tmx::ParseProgress::Stage::TILESET_LOADED) {
+            tilesetIndices.push_back(progress.index);
+        }
+    };
+    tmx::Map withoutTilesets;
+    withoutTilesets.parseFromFile("assets/pf1_external.tmx", nullptr, options);
+    EXPECT_TRUE(withoutTilesets.tilesets().empty());
+    EXPECT_EQ(tilesetIndices, std::vector<int>{0});
+    EXPECT_EQ(withoutTilesets.layers()[0].tileLayer().at(0, 0), 121);
+}
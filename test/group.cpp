@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+
+static const std::string groupMap =
+    "<map version=\"1.10\" orientation=\"orthogonal\" width=\"2\" height=\"2\" tilewidth=\"8\" tileheight=\"8\">"
+    " <layer id=\"1\" name=\"ground\" width=\"2\" height=\"2\"><data encoding=\"csv\">1,2,3,4</data></layer>"
+    " <group id=\"2\" name=\"outer\" offsetx=\"10\" offsety=\"5\" opacity=\"0.5\" tintcolor=\"#ff8000\""
+    "  parallaxx=\"0.5\">"
+    "  <properties><property name=\"kind\" value=\"background\"/></properties>"
+    "  <imagelayer id=\"3\" name=\"sky\" opacity=\"0.5\" repeatx=\"1\">"
+    "   <image source=\"sky.png\" width=\"64\" height=\"32\"/>"
+    "  </imagelayer>"
+    "  <group id=\"4\" name=\"inner\" offsetx=\"1\" offsety=\"1\" visible=\"0\" tintcolor=\"#808080\""
+    "   parallaxx=\"0.5\" parallaxy=\"2\">"
+    "   <objectgroup id=\"5\" name=\"objects\"><object id=\"1\" x=\"1\" y=\"2\"/></objectgroup>"
+    "   <layer id=\"6\" name=\"details\" width=\"2\" height=\"2\"><data encoding=\"csv\">5,6,7,8</data></layer>"
+    "  </group>"
+    " </group>"
+    "</map>";
+
+static void expectSameFlatLayers(const tmx::Map& map, const tmx::Map& other) {
+    ASSERT_EQ(map.flatLayers().size(), other.flatLayers().size());
+    for(std::size_t i = 0; i < map.flatLayers().size(); i++) {
+        const tmx::FlatLayer& a = map.flatLayers()[i];
+        const tmx::FlatLayer& b = other.flatLayers()[i];
+        EXPECT_EQ(a.layer->type(), b.layer->type());
+        EXPECT_EQ(a.layer->abstractLayer().name(), b.layer->abstractLayer().name());
+        EXPECT_EQ(a.depth, b.depth);
+        EXPECT_DOUBLE_EQ(a.offset.x, b.offset.x);
+        EXPECT_DOUBLE_EQ(a.offset.y, b.offset.y);
+        EXPECT_DOUBLE_EQ(a.opacity, b.opacity);
+        EXPECT_EQ(a.visible, b.visible);
+        EXPECT_EQ(a.tintColor.g, b.tintColor.g);
+        EXPECT_DOUBLE_EQ(a.parallaxFactor.y, b.parallaxFactor.y);
+    }
+}
+
+TEST(GroupTest, Tree) {
+    tmx::Map map;
+    map.parseFromData(groupMap);
+
+    ASSERT_EQ(map.layers().size(), 2);
+    EXPECT_EQ(map.layers()[0].type(), tmx::Layer::Type::TILE);
+    ASSERT_EQ(map.layers()[1].type(), tmx::Layer::Type::GROUP);
+    const tmx::GroupLayer& outer = map.layers()[1].groupLayer();
+    EXPECT_EQ(outer.name(), "outer");
+    EXPECT_EQ(outer.property("kind").stringValue(), "background");
+    ASSERT_EQ(outer.layers().size(), 2);
+
+    ASSERT_EQ(outer.layers()[0].type(), tmx::Layer::Type::IMAGE);
+    const tmx::ImageLayer& sky = outer.layers()[0].imageLayer();
+    EXPECT_EQ(sky.image().source(), "sky.png");
+    EXPECT_TRUE(sky.repeatX());
+    EXPECT_FALSE(sky.repeatY());
+
+    const tmx::GroupLayer& inner = outer.layers()[1].groupLayer();
+    ASSERT_EQ(inner.layers().size(), 2);
+    EXPECT_EQ(inner.layers()[0].objectGroup().objects().size(), 1);
+    EXPECT_EQ(inner.layers()[1].tileLayer().at(1, 1), 8);
+    EXPECT_THROW(static_cast<void>(inner.layers()[1].groupLayer()), tmx::Exception);
+}
+
+TEST(GroupTest, FlatLayers) {
+    tmx::Map map;
+    map.parseFromData(groupMap);
+
+    const std::vector<tmx::FlatLayer>& flat = map.flatLayers();
+    ASSERT_EQ(flat.size(), 4);
+    EXPECT_EQ(flat[0].layer, &map.layers()[0]);
+    EXPECT_EQ(flat[0].group, nullptr);
+    EXPECT_EQ(flat[0].depth, 0);
+    EXPECT_EQ(flat[0].tintColor.b, 255);
+
+    const tmx::FlatLayer& sky = flat[1];
+    EXPECT_EQ(sky.layer->imageLayer().name(), "sky");
+    EXPECT_EQ(sky.group, &map.layers()[1].groupLayer());
+    EXPECT_EQ(sky.depth, 1);
+    EXPECT_DOUBLE_EQ(sky.offset.x, 10);
+    EXPECT_DOUBLE_EQ(sky.opacity, 0.25);
+    EXPECT_TRUE(sky.visible);
+    EXPECT_EQ(sky.tintColor.r, 255);
+    EXPECT_EQ(sky.tintColor.g, 128);
+    EXPECT_EQ(sky.tintColor.b, 0);
+    EXPECT_DOUBLE_EQ(sky.parallaxFactor.x, 0.5);
+    EXPECT_DOUBLE_EQ(sky.parallaxFactor.y, 1);
+
+    for(const tmx::FlatLayer* layer : {&flat[2], &flat[3]}) {
+        EXPECT_EQ(layer->depth, 2);
+        EXPECT_EQ(layer->group->name(), "inner");
+        EXPECT_DOUBLE_EQ(layer->offset.x, 11);
+        EXPECT_DOUBLE_EQ(layer->offset.y, 6);
+        EXPECT_DOUBLE_EQ(layer->opacity, 0.5);
+        EXPECT_FALSE(layer->visible);
+        EXPECT_EQ(layer->tintColor.r, 128);
+        EXPECT_EQ(layer->tintColor.g, 64);
+        EXPECT_DOUBLE_EQ(layer->parallaxFactor.x, 0.25);
+        EXPECT_DOUBLE_EQ(layer->parallaxFactor.y, 2);
+    }
+    EXPECT_EQ(flat[2].layer->type(), tmx::Layer::Type::OBJECT);
+    EXPECT_EQ(flat[3].layer->tileLayer().name(), "details");
+
+    // Copies point into their own layers
+    tmx::Map copy = map;
+    ASSERT_EQ(copy.flatLayers().size(), 4);
+    EXPECT_EQ(copy.flatLayers()[3].layer, &copy.layers()[1].groupLayer().layers()[1].groupLayer().layers()[1]);
+    expectSameFlatLayers(map, copy);
+}
+
+TEST(GroupTest, Filter) {
+    tmx::ParseOptions options;
+    options.layerFilter = [](const tmx::LayerInfo& info) { return info.type != tmx::LayerType::GROUP; };
+    tmx::Map map;
+    map.parseFromData(groupMap, options);
+    ASSERT_EQ(map.layers().size(), 1);
+    EXPECT_EQ(map.flatLayers().size(), 1);
+}
+
+TEST(GroupTest, SaveAndBake) {
+    tmx::Map map;
+    map.parseFromData(groupMap);
+
+    tmx::Map saved;
+    saved.parseFromData(map.saveToData());
+    expectSameFlatLayers(map, saved);
+    EXPECT_EQ(saved.flatLayers()[1].layer->imageLayer().image().source(), "sky.png");
+    EXPECT_EQ(saved.flatLayers()[3].layer->tileLayer().at(0, 1), 7);
+    EXPECT_EQ(saved.layers()[1].groupLayer().property("kind").stringValue(), "background");
+
+    tmx::Map baked;
+    baked.loadBakedFromData(map.bake());
+    expectSameFlatLayers(map, baked);
+    EXPECT_EQ(baked.flatLayers()[3].layer->tileLayer().at(0, 1), 7);
+}
+
+TEST(GroupTest, JSON) {
+    tmx::Map map;
+    map.parseFromData(R"({"type": "map", "version": "1.10", "orientation": "orthogonal", "width": 2, "height": 2,
+        "tilewidth": 8, "tileheight": 8, "layers": [
+            {"type": "group", "id": 1, "name": "group", "offsetx": 4, "opacity": 0.5, "layers": [
+                {"type": "imagelayer", "id": 2, "name": "sky", "image": "sky.png", "repeaty": true},
+                {"type": "tilelayer", "id": 3, "name": "tiles", "width": 2, "height": 2, "data": [1, 2, 3, 4],
+                    "offsetx": 1}
+            ]}
+        ]})");
+
+    ASSERT_EQ(map.layers().size(), 1);
+    ASSERT_EQ(map.flatLayers().size(), 2);
+    EXPECT_EQ(map.flatLayers()[0].layer->imageLayer().image().source(), "sky.png");
+    EXPECT_TRUE(map.flatLayers()[0].layer->imageLayer().repeatY());
+    EXPECT_DOUBLE_EQ(map.flatLayers()[1].offset.x, 5);
+    EXPECT_DOUBLE_EQ(map.flatLayers()[1].opacity, 0.5);
+    EXPECT_EQ(map.flatLayers()[1].layer->tileLayer().at(1, 1), 4);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <tmxpp.hpp>
+
+static const std::map<std::string, std::string> imageFiles = {
+    {"maps/level.tmx",
+        "<map version=\"1.10\" orientation=\"orthogonal\" width=\"4\" height=\"4\" tilewidth=\"16\" tileheight=\"16\">"
+        " <tileset firstgid=\"1\" name=\"ground\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"4\" columns=\"2\">"
+        "  <image source=\"../images/tiles.png\" width=\"32\" height=\"32\"/>"
+        " </tileset>"
+        " <tileset firstgid=\"5\" source=\"../tilesets/props.tsx\"/>"
+        " <tileset firstgid=\"7\" name=\"collection\" tilewidth=\"32\" tileheight=\"32\" tilecount=\"2\" columns=\"0\">"
+        "  <tile id=\"0\"><image source=\"../images/tree.png\" width=\"32\" height=\"32\"/></tile>"
+        "  <tile id=\"1\"><image source=\"../images/rock.png\" width=\"32\" height=\"32\"/></tile>"
+        " </tileset>"
+        " <imagelayer id=\"1\" name=\"background\"><image source=\"../images/tree.png\"/></imagelayer>"
+        " <group id=\"2\" name=\"group\">"
+        "  <imagelayer id=\"3\" name=\"sky\"><image source=\"../images/sky.png\"/></imagelayer>"
+        " </group>"
+        "</map>"},
+    {"tilesets/props.tsx",
+        "<tileset version=\"1.10\" name=\"props\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"2\" columns=\"2\">"
+        " <image source=\"../images/tiles.png\" width=\"32\" height=\"32\"/>"
+        "</tileset>"},
+};
+
+static tmx::Buffer loadImageFile(const std::filesystem::path& path) {
+    return tmx::Buffer(imageFiles.at(path.lexically_normal().generic_string()));
+}
+
+TEST(ImagesTest, Handles) {
+    tmx::Map map;
+    map.parseFromFile("maps/level.tmx", loadImageFile);
+
+    // Same file referenced from the map and from a tileset in another directory
+    EXPECT_EQ(map.images(),
+        std::vector<std::filesystem::path>({"images/tiles.png", "images/tree.png", "images/rock.png", "images/sky.png"}));
+    EXPECT_EQ(map.tilesets()[0].image().handle(), 0);
+    EXPECT_EQ(map.tilesets()[1].image().handle(), 0);
+    EXPECT_EQ(map.tilesets()[2].image().handle(), -1);
+    EXPECT_EQ(map.tilesets()[2].tiles()[0].image().handle(), 1);
+    EXPECT_EQ(map.tilesets()[2].tiles()[1].image().handle(), 2);
+    EXPECT_EQ(map.layers()[0].imageLayer().image().handle(), 1);
+    EXPECT_EQ(map.layers()[1].groupLayer().layers()[0].imageLayer().image().handle(), 3);
+
+    tmx::Map baked;
+    baked.loadBakedFromData(map.bake());
+    EXPECT_EQ(baked.images(), map.images());
+    EXPECT_EQ(baked.tilesets()[2].tiles()[1].image().handle(), 2);
+    EXPECT_EQ(baked.layers()[1].groupLayer().layers()[0].imageLayer().image().handle(), 3);
+}
+
+TEST(ImagesTest, StandaloneTileset) {
+    tmx::Tileset tileset;
+    tileset.parseFromData(imageFiles.at("tilesets/props.tsx"));
+    EXPECT_EQ(tileset.image().handle(), -1);
+}
+
+#ifdef TMXPP_BASE64
+
+static std::string embeddedMap(const std::string& data) {
+    return "<map version=\"1.10\" orientation=\"orthogonal\" width=\"4\" height=\"4\" tilewidth=\"16\" "
+           "tileheight=\"16\">"
+           " <tileset firstgid=\"1\" name=\"ground\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"4\" "
+           "columns=\"2\">"
+           "  <image format=\"png\" width=\"32\" height=\"32\">" +
+           data +
+           "</image>"
+           " </tileset>"
+           " <imagelayer id=\"1\" name=\"background\"><image source=\"sky.png\"/></imagelayer>"
+           "</map>";
+}
+
+static std::string imageBytes(const tmx::Image& image) {
+    return {reinterpret_cast<const char*>(image.data().data()), image.data().size()};
+}
+
+static const std::string pngBytes = "\x89PNG\r\n\x1a\nembedded";
+
+TEST(ImagesTest, Embedded) {
+    tmx::Map map;
+    map.parseFromData(embeddedMap("<data encoding=\"base64\">\n   iVBORw0KGgplbWJlZGRlZA==\n  </data>"));
+    const tmx::Image& image = map.tilesets()[0].image();
+    EXPECT_EQ(image.type(), tmx::Image::Type::EMBEDDED);
+    EXPECT_EQ(image.format(), "png");
+    EXPECT_EQ(imageBytes(image), pngBytes);
+    EXPECT_EQ(image.handle(), -1);
+    EXPECT_EQ(map.images(), std::vector<std::filesystem::path>({"sky.png"}));
+    EXPECT_TRUE(map.layers()[0].imageLayer().image().data().empty());
+
+    // Copies share the decoded buffer
+    tmx::Map copy = map;
+    EXPECT_EQ(copy.tilesets()[0].image().data().data(), image.data().data());
+
+    tmx::Map saved;
+    saved.parseFromData(map.saveToData());
+    EXPECT_EQ(saved.tilesets()[0].image().format(), "png");
+    EXPECT_EQ(imageBytes(saved.tilesets()[0].image()), pngBytes);
+
+    tmx::Map baked;
+    baked.loadBakedFromData(map.bake());
+    EXPECT_EQ(baked.tilesets()[0].image().type(), tmx::Image::Type::EMBEDDED);
+    EXPECT_EQ(imageBytes(baked.tilesets()[0].image()), pngBytes);
+
+    tmx::Map wrong;
+    EXPECT_THROW(wrong.parseFromData(embeddedMap("<data encoding=\"csv\">1</data>")), tmx::Exception);
+}
+
+#ifdef TMXPP_ZLIB
+
+TEST(ImagesTest, EmbeddedCompressed) {
+    tmx::Map map;
+    map.parseFromData(
+        embeddedMap("<data encoding=\"base64\" compression=\"zlib\">eJzrDPBz5+WS4krNTUpNSUlNAQAl6QTU</data>"));
+    EXPECT_EQ(imageBytes(map.tilesets()[0].image()), pngBytes);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+#include <utility>
+#include <vector>
+
+static void expectSameMaps(const tmx::Map& a, const tmx::Map& b) {
+    EXPECT_EQ(a.version(), b.version());
+    EXPECT_EQ(a.tiledVersion(), b.tiledVersion());
+    EXPECT_EQ(a.orientation(), b.orientation());
+    EXPECT_EQ(a.width(), b.width());
+    EXPECT_EQ(a.height(), b.height());
+    EXPECT_EQ(a.tileWidth(), b.tileWidth());
+    ASSERT_EQ(a.tilesets().size(), b.tilesets().size());
+    for(std::size_t i = 0; i < a.tilesets().size(); i++) {
+        const tmx::Tileset& ta = a.tilesets()[i];
+        const tmx::Tileset& tb = b.tilesets()[i];
+        EXPECT_EQ(ta.firstGID(), tb.firstGID());
+        EXPECT_EQ(ta.name(), tb.name());
+        EXPECT_EQ(ta.tileCount(), tb.tileCount());
+        EXPECT_EQ(ta.columns(), tb.columns());
+        EXPECT_EQ(ta.image().source(), tb.image().source());
+        EXPECT_EQ(ta.image().width(), tb.image().width());
+        ASSERT_EQ(ta.tiles().size(), tb.tiles().size());
+        for(std::size_t j = 0; j < ta.tiles().size(); j++) {
+            EXPECT_EQ(ta.tiles()[j].id(), tb.tiles()[j].id());
+            const std::vector<tmx::Object>& oa = ta.tiles()[j].objectGroup().objects();
+            const std::vector<tmx::Object>& ob = tb.tiles()[j].objectGroup().objects();
+            ASSERT_EQ(oa.size(), ob.size());
+            for(std::size_t k = 0; k < oa.size(); k++) {
+                ASSERT_EQ(oa[k].type(), ob[k].type());
+                if(oa[k].type() == tmx::Object::Type::POLYGON) {
+                    ASSERT_EQ(oa[k].polygon().size(), ob[k].polygon().size());
+                    EXPECT_FLOAT_EQ(oa[k].polygon().back().x, ob[k].polygon().back().x);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(a.layers().size(), b.layers().size());
+    for(std::size_t i = 0; i < a.layers().size(); i++) {
+        ASSERT_EQ(a.layers()[i].type(), b.layers()[i].type());
+        if(a.layers()[i].type() == tmx::Layer::Type::TILE) {
+            EXPECT_EQ(a.layers()[i].tileLayer().name(), b.layers()[i].tileLayer().name());
+            EXPECT_EQ(a.layers()[i].tileLayer().data(), b.layers()[i].tileLayer().data());
+        }
+    }
+}
+
+TEST(JsonTest, SameAsXml) {
+    std::vector<std::pair<std::string, std::string>> assets = {
+        {"assets/pf1.tmj", "assets/pf1.tmx"}, {"assets/pf1_external.tmj", "assets/pf1_external.tmx"}};
+#if defined(TMXPP_BASE64) && defined(TMXPP_ZLIB)
+    assets.emplace_back("assets/pf1_zlib.tmj", "assets/pf1_zlib.tmx");
+#endif
+    for(const auto& [json, xml] : assets) {
+        SCOPED_TRACE(json);
+        tmx::Map a;
+        a.parseFromFile(json);
+        tmx::Map b;
+        b.parseFromFile(xml);
+        expectSameMaps(a, b);
+    }
+}
+
+TEST(JsonTest, ObjectsAndProperties) {
+    std::string data = R"(
+    {
+        "type": "map", "version": "1.10", "orientation": "isometric", "width": 2, "height": 1,
+        "class": "level",
+        "properties": [
+            {"name": "title", "type": "string", "value": "Café \"A\"\n😀"},
+            {"name": "count", "type": "int", "value": -3},
+            {"name": "speed", "type": "float", "value": 2.5},
+            {"name": "enabled", "type": "bool", "value": true},
+            {"name": "target", "type": "object", "value": 5},
+            {"name": "spawn", "type": "class", "propertytype": "Spawn",
+             "value": {"team": 2, "weight": 0.5, "boss": false, "tag": "red", "nested": {"depth": 1}}}
+        ],
+        "tilesets": [{"firstgid": 1, "name": "tiles", "tilewidth": 16, "tileheight": 16, "tilecount": 4,
+                      "columns": 2, "image": "tiles.png", "imagewidth": 32, "imageheight": 32,
+                      "tileoffset": {"x": 1, "y": -2},
+                      "tiles": [{"id": 1, "type": "wall",
+                                 "animation": [{"tileid": 1, "duration": 100}, {"tileid": 2, "duration": 50}]}]}],
+        "layers": [
+            {"type": "tilelayer", "id": 1, "name": "ground", "class": "floor", "width": 2, "height": 1,
+             "opacity": 0.5, "visible": false, "data": [2147483649, 3]},
+            {"type": "objectgroup", "id": 2, "name": "objects", "draworder": "index", "objects": [
+                {"id": 1, "name": "zone", "type": "trigger", "x": 1, "y": 2, "width": 3, "height": 4, "ellipse": true},
+                {"id": 2, "x": 5, "y": 6, "point": true},
+                {"id": 3, "x": 0, "y": 0, "polyline": [{"x": 0, "y": 0}, {"x": 1.5, "y": -2}]},
+                {"id": 4, "x": 0, "y": 0, "text": {"text": "Hello", "wrap": true, "halign": "center"}}
+            ]}
+        ]
+    })";
+
+    tmx::Map map;
+    map.parseFromData(data);
+    EXPECT_EQ(map.orientation(), tmx::Map::Orientation::ISOMETRIC);
+    EXPECT_EQ(map.className(), "level");
+    EXPECT_EQ(map.property("title").stringValue(), "Caf\xC3\xA9 \"A\"\n\xF0\x9F\x98\x80");
+    EXPECT_EQ(map.property("count").intValue(), -3);
+    EXPECT_FLOAT_EQ(map.property("speed").floatValue(), 2.5F);
+    EXPECT_TRUE(map.property("enabled").boolValue());
+    EXPECT_EQ(map.property("target").objectValue(), 5);
+    const tmx::Properties& spawn = map.property("spawn").classValue();
+    EXPECT_EQ(spawn.property("team").intValue(), 2);
+    EXPECT_FLOAT_EQ(spawn.property("weight").floatValue(), 0.5F);
+    EXPECT_FALSE(spawn.property("boss").boolValue());
+    EXPECT_EQ(spawn.property("tag").stringValue(), "red");
+    EXPECT_EQ(spawn.property("nested").classValue().property("depth").intValue(), 1);
+
+    const tmx::Tileset& tileset = map.tilesets().at(0);
+    EXPECT_EQ(tileset.image().source(), "tiles.png");
+    EXPECT_EQ(tileset.image().height(), 32);
+    EXPECT_EQ(tileset.tileOffset().y, -2);
+    ASSERT_EQ(tileset.tiles().size(), 1);
+    EXPECT_EQ(tileset.tiles()[0].className(), "wall");
+    ASSERT_EQ(tileset.tiles()[0].animation().size(), 2);
+    EXPECT_EQ(tileset.tiles()[0].animation()[1].duration, 50);
+
+    ASSERT_EQ(map.layers().size(), 2);
+    const tmx::TileLayer& layer = map.layers()[0].tileLayer();
+    EXPECT_EQ(layer.className(), "floor");
+    EXPECT_FLOAT_EQ(layer.opacity(), 0.5F);
+    EXPECT_FALSE(layer.visible());
+    EXPECT_EQ(layer.at(0, 0), 1);
+    EXPECT_TRUE(layer.flipHorizontal(0, 0));
+    EXPECT_EQ(layer.at(1, 0), 3);
+
+    const tmx::ObjectGroup& objectGroup = map.layers()[1].objectGroup();
+    EXPECT_EQ(objectGroup.drawOrder(), tmx::ObjectGroup::DrawOrder::INDEX);
+    const std::vector<tmx::Object>& objects = objectGroup.objects();
+    ASSERT_EQ(objects.size(), 4);
+    EXPECT_EQ(objects[0].className(), "trigger");
+    EXPECT_EQ(objects[0].type(), tmx::Object::Type::ELLIPSE);
+    EXPECT_FLOAT_EQ(objects[0].size().y, 4);
+    EXPECT_EQ(objects[1].type(), tmx::Object::Type::POINT);
+    ASSERT_EQ(objects[2].type(), tmx::Object::Type::POLYLINE);
+    EXPECT_FLOAT_EQ(objects[2].polyline()[1].y, -2);
+    ASSERT_EQ(objects[3].type(), tmx::Object::Type::TEXT);
+    EXPECT_EQ(objects[3].text().text(), "Hello");
+    EXPECT_TRUE(objects[3].text().wrap());
+}
+
+TEST(JsonTest, Errors) {
+    tmx::Map map;
+    EXPECT_THROW(map.parseFromData("{"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("{\"type\": \"tileset\"}"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("{\"width\": 2,}"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("{\"name\": \"unterminated}"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("{\"layers\": [{\"type\": \"tilelayer\", \"width\": 2, \"height\": 1, \"data\": [1]}]}"),
+        tmx::Exception);
+    EXPECT_THROW(map.parseFromData("{} {}"), tmx::Exception);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <tmxpp.hpp>
+#include <vector>
+
+class LazyTest : public testing::TestWithParam<std::string> {};
+
+TEST_P(LazyTest, SameAsEager) {
+    tmx::Map eager;
+    eager.parseFromFile("assets/" + GetParam());
+    tmx::ParseOptions options;
+    options.lazyTileData = true;
+    tmx::Map lazy;
+    lazy.parseFromFile("assets/" + GetParam(), nullptr, options);
+
+    ASSERT_EQ(lazy.layers().size(), eager.layers().size());
+    for(std::size_t i = 0; i < eager.layers().size(); i++) {
+        if(eager.layers()[i].type() != tmx::Layer::Type::TILE) {
+            continue;
+        }
+        const tmx::TileLayer& layer = lazy.layers()[i].tileLayer();
+        EXPECT_EQ(layer.at(0, 0), eager.layers()[i].tileLayer().at(0, 0));
+        EXPECT_EQ(layer.data(), eager.layers()[i].tileLayer().data());
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Assets, LazyTest,
+    testing::Values("pf1.tmx"
+#ifdef TMXPP_BASE64
+        ,
+        "pf1_base64.tmx"
+#ifdef TMXPP_ZLIB
+        ,
+        "pf1_zlib.tmx", "pf1_gzip.tmx"
+#endif
+#ifdef TMXPP_ZSTD
+        ,
+        "pf1_zstd.tmx"
+#endif
+#endif
+        ));
+
+TEST(LazyDecodeTest, ErrorsOnAccess) {
+    std::string data =
+        "<map width=\"2\" height=\"1\">"
+        " <layer id=\"1\" name=\"used\" width=\"2\" height=\"1\"><data encoding=\"csv\">1,2</data></layer>"
+        " <layer id=\"2\" name=\"unused\" width=\"2\" height=\"1\"><data encoding=\"csv\">1,x</data></layer>"
+        "</map>";
+
+    tmx::Map eager;
+    EXPECT_THROW(eager.parseFromData(data), tmx::Exception);
+
+    // Unused layer is never decoded, so its data is not validated until accessed
+    tmx::ParseOptions options;
+    options.lazyTileData = true;
+    tmx::Map lazy;
+    lazy.parseFromData(data, options);
+    EXPECT_EQ(lazy.layers()[0].tileLayer().at(1, 0), 2);
+    EXPECT_THROW(lazy.layers()[1].tileLayer().ensureDecoded(), tmx::Exception);
+    EXPECT_THROW((void)lazy.layers()[1].tileLayer().at(0, 0), tmx::Exception);
+}
+
+TEST(LazyDecodeTest, ConcurrentAccess) {
+    tmx::ParseOptions options;
+    options.lazyTileData = true;
+    tmx::Map map;
+    map.parseFromFile("assets/pf1.tmx", nullptr, options);
+    const tmx::TileLayer& layer = map.layers()[0].tileLayer();
+    tmx::TileLayer copy = layer;
+
+    std::vector<int> sums(8);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 8; i++) {
+        threads.emplace_back([&, i]() {
+            const tmx::TileLayer& target = i % 2 == 0 ? layer : copy;
+            for(int y = 0; y < target.height(); y++) {
+                for(int x = 0; x < target.width(); x++) {
+                    sums[i] += target.at(x, y);
+                }
+            }
+        });
+    }
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+    for(int sum : sums) {
+        EXPECT_EQ(sum, sums[0]);
+    }
+    EXPECT_EQ(copy.cells().data(), layer.cells().data());
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tmxpp.hpp>
+
+static std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+TEST(LoaderTest, StringLoader) {
+    int calls = 0;
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_external.tmx", [&calls](const std::filesystem::path& path) {
+        calls++;
+        return readFile(path);
+    });
+    EXPECT_EQ(calls, 2);
+    ASSERT_EQ(map.tilesets().size(), 1);
+    EXPECT_EQ(map.tilesets()[0].tileCount(), 132);
+    EXPECT_EQ(map.layers()[0].tileLayer().at(0, 0), 121);
+}
+
+TEST(LoaderTest, BufferViewLoader) {
+    // Files are kept alive by the caller, parser reads them in place
+    std::map<std::filesystem::path, std::string> pak;
+    pak["assets/pf1_external.tmx"] = readFile("assets/pf1_external.tmx");
+    pak["assets/pf1_external.tsx"] = readFile("assets/pf1_external.tsx");
+
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_external.tmx", [&pak](const std::filesystem::path& path) {
+        const std::string& file = pak.at(path.lexically_normal());
+        return tmx::Buffer(file.data(), file.size());
+    });
+    ASSERT_EQ(map.tilesets().size(), 1);
+    EXPECT_EQ(map.tilesets()[0].tileCount(), 132);
+}
+
+TEST(LoaderTest, OwningBufferLoader) {
+    int released = 0;
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_external.tmx", [&released](const std::filesystem::path& path) {
+        auto* file = new std::string(readFile(path));
+        std::shared_ptr<const void> owner(file, [&released](const std::string* ptr) {
+            released++;
+            delete ptr;
+        });
+        return tmx::Buffer(file->data(), file->size(), owner);
+    });
+    EXPECT_EQ(released, 2);
+    EXPECT_EQ(map.layers().size(), 3);
+}
+
+TEST(LoaderTest, ParseFromBuffer) {
+    std::string data = readFile("assets/pf1.tmx");
+    tmx::Map map;
+    map.parseFromData(tmx::Buffer(data.data(), data.size()));
+    EXPECT_EQ(map.width(), 128);
+    EXPECT_EQ(map.layers().size(), 3);
+}
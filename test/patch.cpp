@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+
+static std::string layerMap(const std::string& tiles, const std::string& objects, int width = 4) {
+    return "<map version=\"1.10\" orientation=\"orthogonal\" width=\"4\" height=\"3\" tilewidth=\"8\" tileheight=\"8\">"
+           " <layer id=\"1\" name=\"tiles\" width=\"" +
+           std::to_string(width) + "\" height=\"3\"><data encoding=\"csv\">" + tiles +
+           "</data></layer>"
+           " <objectgroup id=\"2\" name=\"objects\">" +
+           objects +
+           "</objectgroup>"
+           "</map>";
+}
+
+static const std::string baseObjects = "<object id=\"1\" name=\"a\" x=\"1\" y=\"1\"/>"
+                                       "<object id=\"2\" name=\"b\" x=\"2\" y=\"2\"/>"
+                                       "<object id=\"3\" name=\"c\" x=\"3\" y=\"3\"/>";
+
+TEST(PatchTest, TileLayer) {
+    tmx::Map base;
+    base.parseFromData(layerMap("1,1,1,1,1,1,1,1,1,1,1,1", baseObjects));
+    tmx::Map target;
+    target.parseFromData(layerMap("1,1,1,1,1,1,7,8,2147483657,1,1,1", baseObjects));
+
+    tmx::TileLayer layer = base.layers()[0].tileLayer();
+    std::string patch = target.layers()[0].tileLayer().diff(layer);
+    // Header, base size, two flags and a single run of three cells
+    EXPECT_EQ(patch.size(), 2 + 2 + 2 + 3 + (3 * 4));
+
+    // Data is shared with the map, so it is copied rather than modified under it
+    static_cast<void>(layer.data());
+    layer.applyPatch(patch);
+    EXPECT_EQ(layer.at(2, 1), 7);
+    EXPECT_EQ(layer.at(3, 1), 8);
+    EXPECT_EQ(layer.at(0, 2), 9);
+    EXPECT_TRUE(layer.flipHorizontal(0, 2));
+    EXPECT_EQ(layer.data()[1][2], 7);
+    EXPECT_EQ(base.layers()[0].tileLayer().at(2, 1), 1);
+
+    // Applied in place once the layer owns its cells, rows built by data() are updated as well
+    const std::uint32_t* cells = layer.cells().data();
+    layer.applyPatch(base.layers()[0].tileLayer().diff(layer));
+    EXPECT_EQ(layer.cells().data(), cells);
+    EXPECT_EQ(layer.at(2, 1), 1);
+    EXPECT_EQ(layer.data()[1][2], 1);
+
+    EXPECT_TRUE(layer.diff(base.layers()[0].tileLayer()).size() == 2 + 2 + 2 + 1);
+}
+
+TEST(PatchTest, TileLayerAttributesAndSize) {
+    tmx::Map base;
+    base.parseFromData(layerMap("1,1,1,1,1,1,1,1,1,1,1,1", baseObjects));
+    tmx::Map target;
+    target.parseFromData(layerMap("1,2,3,4,5,6", baseObjects, 2));
+
+    tmx::TileLayer layer = base.layers()[0].tileLayer();
+    layer.applyPatch(target.layers()[0].tileLayer().diff(layer));
+    EXPECT_EQ(layer.width(), 2);
+    EXPECT_EQ(layer.height(), 3);
+    EXPECT_EQ(layer.at(1, 2), 6);
+}
+
+TEST(PatchTest, TileLayerErrors) {
+    tmx::Map base;
+    base.parseFromData(layerMap("1,1,1,1,1,1,1,1,1,1,1,1", baseObjects));
+    tmx::Map target;
+    target.parseFromData(layerMap("1,1,1,1,1,1,7,8,9,1,1,1", baseObjects));
+    tmx::Map resized;
+    resized.parseFromData(layerMap("1,2,3,4,5,6", baseObjects, 2));
+
+    tmx::TileLayer layer = base.layers()[0].tileLayer();
+    std::string patch = target.layers()[0].tileLayer().diff(layer);
+    EXPECT_THROW(layer.applyPatch(patch.substr(0, patch.size() - 1)), tmx::Exception);
+    EXPECT_THROW(layer.applyPatch(""), tmx::Exception);
+    EXPECT_THROW(layer.applyPatch(target.layers()[1].objectGroup().diff(base.layers()[1].objectGroup())),
+        tmx::Exception);
+    tmx::TileLayer smaller = resized.layers()[0].tileLayer();
+    EXPECT_THROW(smaller.applyPatch(patch), tmx::Exception);
+
+    // Counts larger than the patch could hold are rejected before anything is allocated
+    std::string huge = "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x7F";
+    EXPECT_THROW(layer.applyPatch(patch.substr(0, 4) + std::string("\0\0", 2) + huge), tmx::Exception);
+    EXPECT_THROW(layer.applyPatch(patch.substr(0, 4) + std::string("\0\1", 2) + huge), tmx::Exception);
+    EXPECT_EQ(layer.at(2, 1), 1);
+}
+
+TEST(PatchTest, ObjectGroup) {
+    tmx::Map base;
+    base.parseFromData(layerMap("1,1,1,1,1,1,1,1,1,1,1,1", baseObjects));
+    tmx::Map target;
+    target.parseFromData(layerMap("1,1,1,1,1,1,1,1,1,1,1,1",
+        "<object id=\"3\" name=\"c\" x=\"3\" y=\"3\"/>"
+        "<object id=\"4\" name=\"d\" x=\"4\" y=\"4\"/>"
+        "<object id=\"1\" name=\"a\" x=\"10\" y=\"1\"/>"));
+
+    tmx::ObjectGroup group = base.layers()[1].objectGroup();
+    group.applyPatch(target.layers()[1].objectGroup().diff(group));
+    ASSERT_EQ(group.objects().size(), 3);
+    EXPECT_EQ(group.objects()[0].name(), "c");
+    EXPECT_EQ(group.objects()[1].name(), "d");
+    EXPECT_DOUBLE_EQ(group.objects()[1].position().x, 4);
+    EXPECT_EQ(group.objects()[2].name(), "a");
+    EXPECT_DOUBLE_EQ(group.objects()[2].position().x, 10);
+    EXPECT_EQ(base.layers()[1].objectGroup().objects().size(), 3);
+
+    // Unchanged group gives a patch that does nothing
+    std::string empty = group.diff(group);
+    group.applyPatch(empty);
+    EXPECT_EQ(group.objects().size(), 3);
+    EXPECT_EQ(empty.size(), 2 + 1 + 1 + 1 + 1 + 1 + 1);
+
+    // Patch made against another version of the group is rejected
+    EXPECT_THROW(group.applyPatch(target.layers()[1].objectGroup().diff(base.layers()[1].objectGroup())),
+        tmx::Exception);
+
+    // Object counts larger than the patch could hold fail once it runs out
+    std::string huge = "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x7F";
+    EXPECT_THROW(group.applyPatch(empty.substr(0, 3) + std::string("\0\1", 2) + huge), tmx::Exception);
+    EXPECT_THROW(group.applyPatch(empty.substr(0, 3) + std::string("\0\0\0", 3) + huge), tmx::Exception);
+    EXPECT_EQ(group.objects().size(), 3);
+
+    // Point count of a changed polygon is bounded the same way
+    tmx::Map polygon;
+    polygon.parseFromData(layerMap("1,1,1,1,1,1,1,1,1,1,1,1",
+        baseObjects + "<object id=\"4\" x=\"4\" y=\"4\"><polygon points=\"0,0 8,0 8,8\"/></object>"));
+    std::string patch = polygon.layers()[1].objectGroup().diff(group);
+    std::string points = std::string("\3\0\0\0", 4) + std::string(16, '\0');
+    ASSERT_NE(patch.find(points), std::string::npos);
+    patch.replace(patch.find(points), 4, "\xFF\xFF\xFF\xFF");
+    EXPECT_THROW(group.applyPatch(patch), tmx::Exception);
+    EXPECT_EQ(group.objects().size(), 3);
+}
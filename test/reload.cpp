@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+static std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+static void writeFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary);
+    file << data;
+}
+
+// 40x20 map with two tile layers and an object group, the cell at (x, y) of the first layer is set to gid
+static std::string generateMap(int x = -1, int y = -1, int gid = 0, const std::string& extraLayer = "") {
+    std::string ground;
+    std::string decoration;
+    for(int row = 0; row < 20; row++) {
+        for(int column = 0; column < 40; column++) {
+            ground += std::to_string(column == x && row == y ? gid : 1) + ",";
+            decoration += "0,";
+        }
+        ground += "\n";
+        decoration += "\n";
+    }
+    ground.pop_back();
+    ground.pop_back();
+    decoration.pop_back();
+    decoration.pop_back();
+
+    return "<map version=\"1.10\" orientation=\"orthogonal\" width=\"40\" height=\"20\" tilewidth=\"16\" "
+           "tileheight=\"16\">\n"
+           " <tileset firstgid=\"1\" source=\"pf1_external.tsx\"/>\n"
+           " <layer id=\"1\" name=\"ground\" width=\"40\" height=\"20\"><data encoding=\"csv\">" +
+           ground +
+           "</data></layer>\n"
+           " <layer id=\"2\" name=\"decoration\" width=\"40\" height=\"20\"><data encoding=\"csv\">" +
+           decoration + "</data></layer>\n" + extraLayer +
+           " <objectgroup id=\"3\" name=\"objects\"><object id=\"1\" x=\"1\" y=\"2\"/></objectgroup>\n"
+           "</map>\n";
+}
+
+class ReloadTest : public testing::Test {
+protected:
+    ReloadTest() {
+        root = std::filesystem::temp_directory_path() / "tmxpp_reload_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root);
+        std::filesystem::copy_file("assets/pf1_external.tsx", root / "pf1_external.tsx");
+        writeFile(root / "map.tmx", generateMap());
+        map.parseFromFile(root / "map.tmx");
+    }
+
+    ~ReloadTest() override { std::filesystem::remove_all(root); }
+
+    std::filesystem::path root;
+    tmx::Map map;
+};
+
+TEST_F(ReloadTest, Unchanged) {
+    const std::uint32_t* cells = map.layers()[0].tileLayer().cells().data();
+    tmx::MapChanges changes = map.reload();
+    EXPECT_TRUE(changes.empty());
+    // Unchanged tile data is taken over without decoding it again
+    EXPECT_EQ(map.layers()[0].tileLayer().cells().data(), cells);
+    EXPECT_EQ(map.tilesets()[0].tileCount(), 132);
+}
+
+TEST_F(ReloadTest, CallbacksNotReused) {
+    int calls = 0;
+    tmx::ParseOptions options;
+    options.progress = [&calls](const tmx::ParseProgress&) { calls++; };
+    tmx::Map other;
+    other.parseFromFile(root / "map.tmx", nullptr, options);
+    int parsed = calls;
+    EXPECT_GT(parsed, 0);
+    // Progress callback and stats may be gone by the time the map is reloaded
+    other.reload();
+    EXPECT_EQ(calls, parsed);
+}
+
+TEST_F(ReloadTest, ChangedCells) {
+    writeFile(root / "map.tmx", generateMap(20, 17, 5));
+    tmx::MapChanges changes = map.reload();
+    EXPECT_FALSE(changes.mapChanged);
+    EXPECT_FALSE(changes.orderChanged);
+    EXPECT_TRUE(changes.tilesets.empty());
+    ASSERT_EQ(changes.layers.size(), 1);
+
+    const tmx::MapChanges::LayerChange& change = changes.layers[0];
+    EXPECT_EQ(change.kind, tmx::MapChanges::LayerChange::Kind::MODIFIED);
+    EXPECT_EQ(change.id, 1);
+    EXPECT_FALSE(change.attributesChanged);
+    ASSERT_EQ(change.dirtyRects.size(), 1);
+    EXPECT_EQ(change.dirtyRects[0].x, 16);
+    EXPECT_EQ(change.dirtyRects[0].y, 16);
+    EXPECT_EQ(change.dirtyRects[0].width, 16);
+    EXPECT_EQ(change.dirtyRects[0].height, 4);
+    EXPECT_EQ(map.layers()[0].tileLayer().at(20, 17), 5);
+}
+
+TEST_F(ReloadTest, LayersAndTilesets) {
+    writeFile(root / "map.tmx", generateMap(-1, -1, 0, " <objectgroup id=\"4\" name=\"spawns\"/>\n"));
+    std::string tileset = readFile(root / "pf1_external.tsx");
+    tileset.replace(tileset.find("tilecount=\"132\""), 15, "tilecount=\"131\"");
+    writeFile(root / "pf1_external.tsx", tileset);
+
+    tmx::MapChanges changes = map.reload();
+    EXPECT_FALSE(changes.mapChanged);
+    ASSERT_EQ(changes.tilesets.size(), 1);
+    ASSERT_EQ(changes.layers.size(), 1);
+    EXPECT_EQ(changes.layers[0].kind, tmx::MapChanges::LayerChange::Kind::ADDED);
+    EXPECT_EQ(changes.layers[0].index, 2);
+    EXPECT_EQ(changes.layers[0].type, tmx::LayerType::OBJECT);
+    EXPECT_EQ(map.tilesets()[0].tileCount(), 131);
+
+    writeFile(root / "map.tmx", generateMap());
+    changes = map.reload();
+    ASSERT_EQ(changes.layers.size(), 1);
+    EXPECT_EQ(changes.layers[0].kind, tmx::MapChanges::LayerChange::Kind::REMOVED);
+    EXPECT_EQ(changes.layers[0].id, 4);
+}
+
+TEST_F(ReloadTest, FileWatcher) {
+    std::vector<std::filesystem::path> files = map.sourceFiles();
+    ASSERT_EQ(files.size(), 2);
+    EXPECT_EQ(files[1], root / "pf1_external.tsx");
+
+    tmx::FileWatcher watcher(files);
+    EXPECT_FALSE(watcher.poll());
+    writeFile(root / "unrelated.txt", "");
+    EXPECT_FALSE(watcher.poll());
+
+    // Written with a different size so the change is seen even where modification times are coarse
+    writeFile(root / "map.tmx", generateMap(0, 0, 12));
+    EXPECT_TRUE(watcher.poll());
+    EXPECT_FALSE(watcher.poll());
+    EXPECT_EQ(map.reload().layers.size(), 1);
+}
+
+TEST_F(ReloadTest, NotLoadedFromFile) {
+    tmx::Map parsed;
+    parsed.parseFromData(readFile("assets/pf1.tmx"));
+    EXPECT_THROW(static_cast<void>(parsed.reload()), tmx::Exception);
+    EXPECT_TRUE(parsed.sourceFiles().empty());
+}
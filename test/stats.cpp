@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+// operator new is replaced in allocations.cpp, it reports every allocation to ParseStats
+
+#ifdef TMXPP_PROFILING
+
+TEST(StatsTest, Scopes) {
+    tmx::ParseStats stats;
+    tmx::ParseOptions options;
+    options.stats = &stats;
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_zlib.tmx", nullptr, options);
+
+    ASSERT_FALSE(stats.scopes.empty());
+    const tmx::ParseStats::Scope& root = stats.scopes.front();
+    EXPECT_EQ(root.phase, tmx::ParseStats::Phase::MAP);
+    EXPECT_EQ(root.name, "pf1_zlib.tmx");
+    EXPECT_EQ(root.depth, 0);
+    EXPECT_GT(root.bytesIn, 0);
+    EXPECT_GT(root.allocations, 0);
+    EXPECT_LE(root.selfNanoseconds, root.nanoseconds);
+
+    std::vector<std::string> layers;
+    for(const tmx::ParseStats::Scope& scope : stats.scopes) {
+        if(scope.phase == tmx::ParseStats::Phase::LAYER) {
+            layers.push_back(scope.name);
+            EXPECT_EQ(scope.depth, 1);
+        } else if(scope.phase == tmx::ParseStats::Phase::DECOMPRESS) {
+            EXPECT_EQ(scope.depth, 3);
+            EXPECT_EQ(scope.bytesOut, 128 * 28 * 4);
+            EXPECT_LT(scope.bytesIn, scope.bytesOut);
+        }
+        EXPECT_LE(scope.nanoseconds, root.nanoseconds);
+    }
+    EXPECT_EQ(layers, std::vector<std::string>({"layer2", "layer1", "layer0"}));
+
+    EXPECT_EQ(stats.total(tmx::ParseStats::Phase::TILESET).bytesIn, 0);
+    EXPECT_EQ(stats.total(tmx::ParseStats::Phase::DECODE).bytesOut, 3 * 128 * 28 * 4);
+    EXPECT_EQ(stats.total(tmx::ParseStats::Phase::DECOMPRESS).bytesOut, 3 * 128 * 28 * 4);
+
+    // Scopes of later parses are appended
+    std::size_t count = stats.scopes.size();
+    map.parseFromFile("assets/pf1_zlib.tmx", nullptr, options);
+    EXPECT_EQ(stats.scopes.size(), 2 * count);
+}
+
+TEST(StatsTest, Callbacks) {
+    std::vector<tmx::ParseStats::Phase> open;
+    int scopes = 0;
+    tmx::ParseOptions options;
+    options.scopeBegin = [&](tmx::ParseStats::Phase phase, std::string_view) {
+        open.push_back(phase);
+        scopes++;
+    };
+    options.scopeEnd = [&](tmx::ParseStats::Phase phase) {
+        ASSERT_FALSE(open.empty());
+        EXPECT_EQ(open.back(), phase);
+        open.pop_back();
+    };
+    options.lazyTileData = true;
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_external.tmx", nullptr, options);
+    EXPECT_TRUE(open.empty());
+    // Map, tileset and three layers, lazily decoded data is not profiled
+    EXPECT_EQ(scopes, 5);
+    static_cast<void>(map.layers()[0].tileLayer().at(0, 0));
+    EXPECT_EQ(scopes, 5);
+}
+
+#else
+
+TEST(StatsTest, Disabled) {
+    tmx::ParseStats stats;
+    tmx::ParseOptions options;
+    options.stats = &stats;
+    options.scopeBegin = [](tmx::ParseStats::Phase, std::string_view) { FAIL(); };
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_zlib.tmx", nullptr, options);
+    EXPECT_TRUE(stats.scopes.empty());
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+static tmx::Map parse(const std::string& path, tmx::ParseOptions::Backend backend) {
+    tmx::ParseOptions options;
+    options.backend = backend;
+    tmx::Map map;
+    map.parseFromFile(path, nullptr, options);
+    return map;
+}
+
+static void expectSameMaps(const tmx::Map& a, const tmx::Map& b) {
+    EXPECT_EQ(a.version(), b.version());
+    EXPECT_EQ(a.width(), b.width());
+    EXPECT_EQ(a.height(), b.height());
+    ASSERT_EQ(a.tilesets().size(), b.tilesets().size());
+    for(std::size_t i = 0; i < a.tilesets().size(); i++) {
+        const tmx::Tileset& ta = a.tilesets()[i];
+        const tmx::Tileset& tb = b.tilesets()[i];
+        EXPECT_EQ(ta.name(), tb.name());
+        EXPECT_EQ(ta.image().source(), tb.image().source());
+        ASSERT_EQ(ta.tiles().size(), tb.tiles().size());
+        for(std::size_t j = 0; j < ta.tiles().size(); j++) {
+            EXPECT_EQ(ta.tiles()[j].id(), tb.tiles()[j].id());
+            EXPECT_EQ(ta.tiles()[j].animation().size(), tb.tiles()[j].animation().size());
+            EXPECT_EQ(ta.tiles()[j].objectGroup().objects().size(), tb.tiles()[j].objectGroup().objects().size());
+        }
+    }
+    ASSERT_EQ(a.layers().size(), b.layers().size());
+    for(std::size_t i = 0; i < a.layers().size(); i++) {
+        ASSERT_EQ(a.layers()[i].type(), b.layers()[i].type());
+        if(a.layers()[i].type() == tmx::Layer::Type::TILE) {
+            const tmx::TileLayer& la = a.layers()[i].tileLayer();
+            const tmx::TileLayer& lb = b.layers()[i].tileLayer();
+            EXPECT_EQ(la.name(), lb.name());
+            EXPECT_EQ(la.properties().size(), lb.properties().size());
+            EXPECT_EQ(la.data(), lb.data());
+        }
+    }
+}
+
+TEST(StreamingTest, SameAsDom) {
+    std::vector<std::string> assets = {"assets/pf1.tmx", "assets/pf1_external.tmx"};
+#ifdef TMXPP_BASE64
+    assets.emplace_back("assets/pf1_base64.tmx");
+#ifdef TMXPP_ZLIB
+    assets.emplace_back("assets/pf1_zlib.tmx");
+    assets.emplace_back("assets/pf1_gzip.tmx");
+#endif
+#ifdef TMXPP_ZSTD
+    assets.emplace_back("assets/pf1_zstd.tmx");
+#endif
+#endif
+    for(const std::string& asset : assets) {
+        SCOPED_TRACE(asset);
+        expectSameMaps(parse(asset, tmx::ParseOptions::Backend::STREAMING), parse(asset, tmx::ParseOptions::Backend::DOM));
+    }
+}
+
+TEST(StreamingTest, Markup) {
+    std::string data =
+        "\xEF\xBB\xBF<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+        "<!DOCTYPE map SYSTEM \"http://mapeditor.org/dtd/1.0/map.dtd\">\r\n"
+        "<!-- comment before root -->\r\n"
+        "<map version='1.10' width=\"2\" height=\"2\">\r\n"
+        " <properties>\r\n"
+        "  <property name=\"a &amp; b\" value=\"&lt;&#65;&#x42;&gt;\"/>\r\n"
+        "  <property name=\"multiline\">line1\r\nline2</property>\r\n"
+        " </properties>\r\n"
+        " <unknown><nested attr=\"1\">text</nested><empty/></unknown>\r\n"
+        " <layer id=\"1\" name=\"layer\" width=\"2\" height=\"2\">\r\n"
+        "  <data encoding=\"csv\"><!-- comment -->1,2,\r\n<![CDATA[3,]]>4</data>\r\n"
+        " </layer>\r\n"
+        " <objectgroup id=\"2\" name=\"objects\">\r\n"
+        "  <object id=\"1\" x=\"1.5\" y=\"-2\"><text wrap=\"1\">Hello &quot;world&quot;</text></object>\r\n"
+        " </objectgroup>\r\n"
+        "</map>\r\n";
+
+    tmx::Map map;
+    map.parseFromData(data);
+    EXPECT_EQ(map.version(), "1.10");
+    EXPECT_EQ(map.property("a & b").stringValue(), "<AB>");
+    EXPECT_EQ(map.property("multiline").stringValue(), "line1\nline2");
+
+    ASSERT_EQ(map.layers().size(), 2);
+    const tmx::TileLayer& layer = map.layers()[0].tileLayer();
+    EXPECT_EQ(layer.at(0, 0), 1);
+    EXPECT_EQ(layer.at(1, 0), 2);
+    EXPECT_EQ(layer.at(0, 1), 3);
+    EXPECT_EQ(layer.at(1, 1), 4);
+
+    const tmx::Object& object = map.layers()[1].objectGroup().objects().at(0);
+    EXPECT_DOUBLE_EQ(object.position().x, 1.5);
+    EXPECT_DOUBLE_EQ(object.position().y, -2);
+    ASSERT_EQ(object.type(), tmx::Object::Type::TEXT);
+    EXPECT_EQ(object.text().text(), "Hello \"world\"");
+    EXPECT_TRUE(object.text().wrap());
+}
+
+TEST(StreamingTest, Errors) {
+    tmx::Map map;
+    EXPECT_THROW(map.parseFromData(""), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("<tileset/>"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("<map><layer></map>"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("<map width=\"2\""), tmx::Exception);
+    EXPECT_THROW(map.parseFromData("<map><properties>"), tmx::Exception);
+    // Unknown markup inside text must not stall the reader
+    std::string layer =
+        "<map width=\"2\" height=\"1\"><layer id=\"1\" width=\"2\" height=\"1\"><data encoding=\"csv\">1,";
+    EXPECT_THROW(map.parseFromData(layer + "<!x>2</data></layer></map>"), tmx::Exception);
+    EXPECT_THROW(map.parseFromData(layer + "<!- x ->2</data></layer></map>"), tmx::Exception);
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <tmxpp.hpp>
+#include <utility>
+
+class TemplateTest : public testing::Test {
+protected:
+    std::map<std::string, std::string> files = {
+        {"maps/level.tmx",
+            "<map version=\"1.10\" orientation=\"orthogonal\" width=\"4\" height=\"4\" tilewidth=\"16\" tileheight=\"16\">"
+            " <tileset firstgid=\"1\" name=\"embedded\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"10\" columns=\"5\">"
+            "  <image source=\"embedded.png\" width=\"80\" height=\"32\"/>"
+            " </tileset>"
+            " <tileset firstgid=\"11\" source=\"../tiles/tiles.tsx\"/>"
+            " <objectgroup id=\"1\" name=\"objects\">"
+            "  <object id=\"1\" template=\"enemy.tx\" x=\"10\" y=\"20\"/>"
+            "  <object id=\"2\" template=\"enemy.tx\" name=\"boss\" x=\"30\" y=\"40\" width=\"32\">"
+            "   <properties><property name=\"hp\" type=\"int\" value=\"100\"/></properties>"
+            "  </object>"
+            "  <object id=\"3\" template=\"wall.tx\" x=\"0\" y=\"0\"/>"
+            "  <object id=\"4\" template=\"wall.tx\" x=\"50\" y=\"0\" rotation=\"90\">"
+            "   <properties><property name=\"hp\" type=\"int\" value=\"5\"/></properties>"
+            "   <polyline points=\"0,0 8,8\"/>"
+            "  </object>"
+            "  <object id=\"5\" template=\"crate.tj\" x=\"5\" y=\"5\"/>"
+            "  <object id=\"6\" template=\"enemy.tx\" x=\"60\" y=\"20\"/>"
+            "  <object id=\"7\" template=\"wall.tx\" x=\"0\" y=\"50\"/>"
+            " </objectgroup>"
+            "</map>"},
+        {"maps/enemy.tx",
+            "<template>"
+            " <tileset firstgid=\"1\" source=\"../tiles/tiles.tsx\"/>"
+            " <object name=\"enemy\" type=\"monster\" gid=\"3\" width=\"16\" height=\"16\">"
+            "  <properties>"
+            "   <property name=\"hp\" type=\"int\" value=\"10\"/>"
+            "   <property name=\"speed\" type=\"float\" value=\"2.5\"/>"
+            "  </properties>"
+            " </object>"
+            "</template>"},
+        {"maps/wall.tx",
+            "<template>"
+            " <object name=\"wall\"><polygon points=\"0,0 16,0 16,16 0,16\"/></object>"
+            "</template>"},
+        {"maps/crate.tj",
+            R"({"type": "template", "object": {"name": "crate", "width": 8, "height": 8,
+                "properties": [{"name": "weight", "type": "int", "value": 5}]}})"},
+        {"tiles/tiles.tsx",
+            "<tileset version=\"1.10\" name=\"tiles\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"4\" columns=\"2\">"
+            " <image source=\"tiles.png\" width=\"32\" height=\"32\"/>"
+            "</tileset>"},
+    };
+    std::map<std::string, int> loads;
+
+    tmx::LoaderType loader() {
+        return [this](const std::filesystem::path& path) {
+            std::string name = path.lexically_normal().generic_string();
+            loads[name]++;
+            return tmx::Buffer(files.at(name));
+        };
+    }
+};
+
+TEST_F(TemplateTest, Instances) {
+    tmx::Map map;
+    map.parseFromFile("maps/level.tmx", loader());
+    const std::vector<tmx::Object>& objects = map.layers()[0].objectGroup().objects();
+    ASSERT_EQ(objects.size(), 7);
+
+    const tmx::Object& enemy = objects[0];
+    EXPECT_EQ(enemy.templateSource(), "enemy.tx");
+    EXPECT_EQ(enemy.name(), "enemy");
+    EXPECT_EQ(enemy.className(), "monster");
+    // Third tile of the template's tileset, which the map has at firstgid 11
+    EXPECT_EQ(enemy.gid(), 13);
+    EXPECT_DOUBLE_EQ(enemy.position().x, 10);
+    EXPECT_DOUBLE_EQ(enemy.size().x, 16);
+    EXPECT_EQ(enemy.property("hp").intValue(), 10);
+    EXPECT_EQ(enemy.properties().size(), 2);
+
+    const tmx::Object& boss = objects[1];
+    EXPECT_EQ(boss.name(), "boss");
+    EXPECT_EQ(boss.className(), "monster");
+    EXPECT_DOUBLE_EQ(boss.size().x, 32);
+    EXPECT_DOUBLE_EQ(boss.size().y, 16);
+    EXPECT_EQ(boss.property("hp").intValue(), 100);
+    EXPECT_FLOAT_EQ(boss.property("speed").floatValue(), 2.5);
+    EXPECT_EQ(boss.properties().size(), 2);
+
+    const tmx::Object& wall = objects[2];
+    ASSERT_EQ(wall.type(), tmx::Object::Type::POLYGON);
+    EXPECT_EQ(wall.polygon().size(), 4);
+    EXPECT_EQ(objects[3].type(), tmx::Object::Type::POLYLINE);
+    EXPECT_DOUBLE_EQ(objects[3].rotation(), 90);
+    EXPECT_EQ(objects[3].name(), "wall");
+    // Own properties over a template without any
+    EXPECT_EQ(objects[3].property("hp").intValue(), 5);
+    EXPECT_EQ(objects[3].properties().size(), 1);
+
+    const tmx::Object& crate = objects[4];
+    EXPECT_EQ(crate.name(), "crate");
+    EXPECT_DOUBLE_EQ(crate.size().y, 8);
+    EXPECT_EQ(crate.property("weight").intValue(), 5);
+
+    // Instances that don't override them share shape and properties of their template
+    EXPECT_EQ(&objects[5].properties(), &enemy.properties());
+    EXPECT_EQ(&objects[5].name(), &enemy.name());
+    EXPECT_EQ(&objects[6].polygon(), &wall.polygon());
+
+    EXPECT_EQ(loads["maps/enemy.tx"], 1);
+    std::vector<std::filesystem::path> sources = map.sourceFiles();
+    EXPECT_EQ(sources.size(), 5);
+    EXPECT_EQ(sources.back(), "maps/crate.tj");
+}
+
+TEST_F(TemplateTest, SharedCache) {
+    tmx::ParseOptions options;
+    options.templateCache = std::make_shared<tmx::TemplateCache>();
+    tmx::Map first;
+    first.parseFromFile("maps/level.tmx", loader(), options);
+    tmx::Map second;
+    second.parseFromFile("maps/level.tmx", loader(), options);
+
+    EXPECT_EQ(options.templateCache->size(), 3);
+    EXPECT_EQ(loads["maps/wall.tx"], 1);
+    EXPECT_EQ(&first.layers()[0].objectGroup().objects()[2].polygon(),
+        &second.layers()[0].objectGroup().objects()[2].polygon());
+
+    options.templateCache->clear();
+    EXPECT_EQ(options.templateCache->size(), 0);
+    tmx::TemplateCache moved = std::move(*options.templateCache);
+    EXPECT_THROW(tmx::Map().parseFromFile("maps/level.tmx", loader(), options), tmx::Exception);
+    // Templates stay alive as long as objects use them
+    EXPECT_EQ(first.layers()[0].objectGroup().objects()[2].polygon().size(), 4);
+}
+
+TEST_F(TemplateTest, SaveAndBake) {
+    tmx::Map map;
+    map.parseFromFile("maps/level.tmx", loader());
+
+    // Only overrides are written, the rest still comes from the template
+    files["maps/level.tmx"] = map.saveToData();
+    EXPECT_EQ(files["maps/level.tmx"].find("name=\"enemy\""), std::string::npos);
+    EXPECT_EQ(files["maps/level.tmx"].find("points=\"0,0 16,0"), std::string::npos);
+    tmx::Map saved;
+    saved.parseFromFile("maps/level.tmx", loader());
+
+    tmx::Map baked;
+    baked.loadBakedFromData(map.bake());
+
+    for(const tmx::Map* other : {&saved, &baked}) {
+        const std::vector<tmx::Object>& objects = other->layers()[0].objectGroup().objects();
+        ASSERT_EQ(objects.size(), 7);
+        EXPECT_EQ(objects[0].gid(), 13);
+        EXPECT_EQ(objects[1].name(), "boss");
+        EXPECT_DOUBLE_EQ(objects[1].size().x, 32);
+        EXPECT_EQ(objects[1].property("hp").intValue(), 100);
+        EXPECT_FLOAT_EQ(objects[1].property("speed").floatValue(), 2.5);
+        EXPECT_EQ(objects[2].polygon().size(), 4);
+        EXPECT_EQ(objects[3].polyline().size(), 2);
+        EXPECT_EQ(objects[3].property("hp").intValue(), 5);
+    }
+    EXPECT_EQ(saved.layers()[0].objectGroup().objects()[1].templateSource(), "enemy.tx");
+    EXPECT_EQ(baked.layers()[0].objectGroup().objects()[1].templateSource(), "enemy.tx");
+}
+
+TEST_F(TemplateTest, Cache) {
+    tmx::ParseOptions options;
+    options.cacheDirectory = std::filesystem::temp_directory_path() / "tmxpp_template_cache_test";
+    std::filesystem::remove_all(options.cacheDirectory);
+    tmx::Map parsed;
+    parsed.parseFromFile("maps/level.tmx", loader(), options);
+
+    int progressCalls = 0;
+    options.progress = [&progressCalls](const tmx::ParseProgress&) { progressCalls++; };
+    tmx::Map cached;
+    cached.parseFromFile("maps/level.tmx", loader(), options);
+    std::filesystem::remove_all(options.cacheDirectory);
+    // Cache hit only reports that it finished
+    EXPECT_EQ(progressCalls, 1);
+
+    // Templates are still known, so they can be watched and instances are saved as such
+    EXPECT_EQ(cached.sourceFiles(), parsed.sourceFiles());
+    EXPECT_EQ(cached.layers()[0].objectGroup().objects()[2].templateSource(), "wall.tx");
+    files["maps/level.tmx"] = cached.saveToData();
+    EXPECT_NE(files["maps/level.tmx"].find("template=\"wall.tx\""), std::string::npos);
+    tmx::Map saved;
+    saved.parseFromFile("maps/level.tmx", loader());
+    EXPECT_EQ(saved.layers()[0].objectGroup().objects()[2].polygon().size(), 4);
+    EXPECT_EQ(saved.sourceFiles(), parsed.sourceFiles());
+}
+
+TEST_F(TemplateTest, MissingTileset) {
+    files["maps/level.tmx"].replace(files["maps/level.tmx"].find("../tiles/tiles.tsx"), 18, "../tiles/other.tsx");
+    files["tiles/other.tsx"] = files["tiles/tiles.tsx"];
+    tmx::Map map;
+    EXPECT_THROW(map.parseFromFile("maps/level.tmx", loader()), tmx::Exception);
+}
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tmxpp.hpp>
+#include <vector>
+
+static tmx::TileGrid grid(const std::string& attributes, int tileWidth = 32, int tileHeight = 16) {
+    tmx::Map map;
+    map.parseFromData("<map version=\"1.10\" " + attributes + " width=\"10\" height=\"10\" tilewidth=\"" +
+                      std::to_string(tileWidth) + "\" tileheight=\"" + std::to_string(tileHeight) +
+                      "\"><layer id=\"1\" name=\"tiles\" width=\"1\" height=\"1\"><data encoding=\"csv\">0</data>"
+                      "</layer></map>");
+    return tmx::TileGrid(map);
+}
+
+struct GridCase {
+    tmx::TileGrid grid;
+    int tileWidth;
+    int tileHeight;
+};
+
+static std::vector<GridCase> allGrids() {
+    std::vector<GridCase> grids = {
+        {grid("orientation=\"orthogonal\""), 32, 16},
+        {grid("orientation=\"isometric\""), 32, 16},
+    };
+    for(std::string axis : {"x", "y"}) {
+        for(std::string index : {"even", "odd"}) {
+            std::string stagger = " staggeraxis=\"" + axis + "\" staggerindex=\"" + index + "\"";
+            grids.push_back({grid("orientation=\"staggered\"" + stagger), 32, 16});
+            grids.push_back({grid("orientation=\"hexagonal\" hexsidelength=\"16\"" + stagger, 32, 32), 32, 32});
+            grids.push_back({grid("orientation=\"hexagonal\" hexsidelength=\"6\"" + stagger, 28, 24), 28, 24});
+        }
+    }
+    return grids;
+}
+
+static tmx::Point center(const GridCase& test, tmx::IntPoint tile) {
+    tmx::Point corner = test.grid.tileToPixel(tile);
+    return {.x = corner.x + (test.tileWidth / 2.0), .y = corner.y + (test.tileHeight / 2.0)};
+}
+
+static void tiles(int from, int to, std::vector<int>& x, std::vector<int>& y) {
+    for(int tileY = from; tileY < to; tileY++) {
+        for(int tileX = from; tileX < to; tileX++) {
+            x.push_back(tileX);
+            y.push_back(tileY);
+        }
+    }
+}
+
+TEST(TileGridTest, Positions) {
+    EXPECT_DOUBLE_EQ(grid("orientation=\"orthogonal\"").tileToPixel({3, 2}).x, 96);
+    EXPECT_DOUBLE_EQ(grid("orientation=\"orthogonal\"").tileToPixel({3, 2}).y, 32);
+
+    // Tile 0, 0 is the top corner of an isometric map, nine tiles fit to its left
+    tmx::TileGrid isometric = grid("orientation=\"isometric\"");
+    EXPECT_DOUBLE_EQ(isometric.tileToPixel({0, 0}).x, 144);
+    EXPECT_DOUBLE_EQ(isometric.tileToPixel({1, 0}).x, 160);
+    EXPECT_DOUBLE_EQ(isometric.tileToPixel({1, 0}).y, 8);
+    EXPECT_EQ(isometric.pixelToTile({176, 16}).x, 1);
+    EXPECT_EQ(isometric.pixelToTile({176, 16}).y, 0);
+    EXPECT_EQ(isometric.pixelToTile({176, 1}).y, -1);
+
+    tmx::TileGrid staggered = grid("orientation=\"staggered\" staggeraxis=\"y\" staggerindex=\"odd\"");
+    EXPECT_DOUBLE_EQ(staggered.tileToPixel({0, 1}).x, 16);
+    EXPECT_DOUBLE_EQ(staggered.tileToPixel({0, 1}).y, 8);
+    EXPECT_DOUBLE_EQ(staggered.tileToPixel({1, 2}).x, 32);
+    EXPECT_DOUBLE_EQ(staggered.tileToPixel({1, 2}).y, 16);
+    // Corner of the bounding box of tile 0, 1 belongs to tile 0, 0
+    EXPECT_EQ(staggered.pixelToTile({17, 9}).x, 0);
+    EXPECT_EQ(staggered.pixelToTile({17, 9}).y, 0);
+
+    tmx::TileGrid hexagonal =
+        grid("orientation=\"hexagonal\" hexsidelength=\"16\" staggeraxis=\"y\" staggerindex=\"odd\"", 32, 32);
+    EXPECT_EQ(hexagonal.neighborCount(), 6);
+    EXPECT_DOUBLE_EQ(hexagonal.tileToPixel({0, 1}).x, 16);
+    EXPECT_DOUBLE_EQ(hexagonal.tileToPixel({0, 1}).y, 24);
+    EXPECT_DOUBLE_EQ(hexagonal.tileToPixel({2, 0}).x, 64);
+}
+
+TEST(TileGridTest, Batches) {
+    std::vector<int> x;
+    std::vector<int> y;
+    tiles(-3, 9, x, y);
+    for(const GridCase& test : allGrids()) {
+        std::vector<float> pixelX(x.size());
+        std::vector<float> pixelY(x.size());
+        test.grid.tileToPixel(x, y, pixelX, pixelY);
+        std::vector<int> tileX(x.size());
+        std::vector<int> tileY(x.size());
+        for(std::size_t i = 0; i < x.size(); i++) {
+            // Batches give the same result as single conversions, centers map back to their tile
+            EXPECT_FLOAT_EQ(pixelX[i], static_cast<float>(test.grid.tileToPixel({x[i], y[i]}).x));
+            EXPECT_FLOAT_EQ(pixelY[i], static_cast<float>(test.grid.tileToPixel({x[i], y[i]}).y));
+            tmx::Point middle = center(test, {x[i], y[i]});
+            pixelX[i] = static_cast<float>(middle.x);
+            pixelY[i] = static_cast<float>(middle.y);
+        }
+        test.grid.pixelToTile(pixelX, pixelY, tileX, tileY);
+        EXPECT_EQ(tileX, x);
+        EXPECT_EQ(tileY, y);
+    }
+}
+
+// Moving from the center of a tile towards the center of a neighbor crosses into the neighbor halfway
+TEST(TileGridTest, Neighbors) {
+    std::vector<int> x;
+    std::vector<int> y;
+    tiles(-2, 6, x, y);
+    std::size_t count = x.size();
+    for(const GridCase& test : allGrids()) {
+        const tmx::TileGrid& grid = test.grid;
+        std::vector<int> neighborX(count * grid.neighborCount());
+        std::vector<int> neighborY(count * grid.neighborCount());
+        grid.neighbors(x, y, neighborX, neighborY);
+
+        std::vector<float> pixelX;
+        std::vector<float> pixelY;
+        std::vector<int> expectedX;
+        std::vector<int> expectedY;
+        for(std::size_t i = 0; i < neighborX.size(); i++) {
+            tmx::Point from = center(test, {x[i % count], y[i % count]});
+            tmx::Point to = center(test, {neighborX[i], neighborY[i]});
+            for(double t : {0.45, 0.55}) {
+                pixelX.push_back(static_cast<float>(from.x + ((to.x - from.x) * t)));
+                pixelY.push_back(static_cast<float>(from.y + ((to.y - from.y) * t)));
+                expectedX.push_back(t < 0.5 ? x[i % count] : neighborX[i]);
+                expectedY.push_back(t < 0.5 ? y[i % count] : neighborY[i]);
+            }
+        }
+
+        std::vector<int> tileX(pixelX.size());
+        std::vector<int> tileY(pixelX.size());
+        grid.pixelToTile(pixelX, pixelY, tileX, tileY);
+        EXPECT_EQ(tileX, expectedX);
+        EXPECT_EQ(tileY, expectedY);
+    }
+}
+
+TEST(TileGridTest, Sizes) {
+    tmx::TileGrid grid = ::grid("orientation=\"orthogonal\"");
+    std::vector<int> x(3);
+    std::vector<int> y(2);
+    std::vector<float> pixels(3);
+    EXPECT_THROW(grid.tileToPixel(x, y, pixels, pixels), tmx::Exception);
+    std::vector<int> neighbors(3);
+    EXPECT_THROW(grid.neighbors(x, x, neighbors, neighbors), tmx::Exception);
+}
+
+static std::string cullingMap(const std::string& attributes, int tileWidth, int tileHeight) {
+    std::string size = "tilewidth=\"" + std::to_string(tileWidth) + "\" tileheight=\"" + std::to_string(tileHeight);
+    std::string tallSize =
+        "tilewidth=\"" + std::to_string(tileWidth) + "\" tileheight=\"" + std::to_string(tileHeight * 2);
+    std::string data = "<data encoding=\"csv\">1";
+    for(int i = 1; i < 100; i++) {
+        data += ",1";
+    }
+    data += "</data>";
+    return "<map version=\"1.10\" " + attributes + " width=\"10\" height=\"10\" " + size +
+           "\" parallaxoriginx=\"40\" parallaxoriginy=\"-20\">"
+           " <tileset firstgid=\"1\" name=\"tall\" " +
+           tallSize + "\" tilecount=\"1\" columns=\"1\"><tileoffset x=\"4\" y=\"-3\"/>"
+           "  <image source=\"tall.png\" " +
+           tallSize + "\"/></tileset>"
+                      " <layer id=\"1\" name=\"ground\" width=\"10\" height=\"10\">" +
+           data +
+           "</layer>"
+           " <group id=\"2\" name=\"group\" offsetx=\"7\" offsety=\"-5\" parallaxx=\"0.5\" parallaxy=\"0.8\">"
+           "  <layer id=\"3\" name=\"inner\" offsetx=\"-20\" offsety=\"3\" width=\"10\" height=\"10\">" +
+           data +
+           "</layer>"
+           " </group>"
+           " <layer id=\"4\" name=\"hidden\" visible=\"0\" width=\"10\" height=\"10\">" +
+           data +
+           "</layer>"
+           "</map>";
+}
+
+// Spans must list exactly the cells whose tile image overlaps the camera
+TEST(TileGridTest, VisibleCells) {
+    struct Case {
+        std::string attributes;
+        int tileWidth;
+        int tileHeight;
+    };
+    std::vector<Case> cases = {{"orientation=\"orthogonal\"", 32, 16}, {"orientation=\"isometric\"", 32, 16}};
+    for(std::string axis : {"x", "y"}) {
+        for(std::string index : {"even", "odd"}) {
+            std::string stagger = " staggeraxis=\"" + axis + "\" staggerindex=\"" + index + "\"";
+            cases.push_back({"orientation=\"staggered\"" + stagger, 32, 16});
+            cases.push_back({"orientation=\"hexagonal\" hexsidelength=\"6\"" + stagger, 28, 24});
+        }
+    }
+
+    std::vector<tmx::VisibleCells> result;
+    for(const Case& test : cases) {
+        tmx::Map map;
+        map.parseFromData(cullingMap(test.attributes, test.tileWidth, test.tileHeight));
+        tmx::TileGrid grid(map);
+        for(tmx::Point position : {tmx::Point{-50.3, -40.7}, tmx::Point{60.1, 30.6}, tmx::Point{150.2, 90.9}}) {
+            tmx::Point size = {.x = 100.5, .y = 70.5};
+            grid.visibleCells(map, position, size, result);
+            ASSERT_EQ(result.size(), 2);
+            EXPECT_EQ(result[0].layer, 0);
+            EXPECT_EQ(result[1].layer, 1);
+            EXPECT_DOUBLE_EQ(result[0].offset.x, 0);
+            EXPECT_NEAR(result[1].offset.x, -13 + (0.5 * (position.x + (size.x / 2) - 40)), 1e-9);
+            EXPECT_NEAR(result[1].offset.y, -2 + (0.2 * (position.y + (size.y / 2) + 20)), 1e-9);
+
+            for(const tmx::VisibleCells& cells : result) {
+                std::vector<bool> listed(100);
+                int previousY = 0;
+                for(const tmx::VisibleCells::Span& span : cells.spans) {
+                    EXPECT_GE(span.y, previousY);
+                    previousY = span.y;
+                    for(int x = span.x; x < span.end; x += span.step) {
+                        EXPECT_FALSE(listed[(span.y * 10) + x]);
+                        listed[(span.y * 10) + x] = true;
+                    }
+                }
+                for(int y = 0; y < 10; y++) {
+                    for(int x = 0; x < 10; x++) {
+                        tmx::Point corner = grid.tileToPixel({x, y});
+                        double left = corner.x + cells.offset.x + 4;
+                        double bottom = corner.y + cells.offset.y + test.tileHeight - 3;
+                        bool visible = left < position.x + size.x && left + test.tileWidth > position.x &&
+                                       bottom - (2 * test.tileHeight) < position.y + size.y && bottom > position.y;
+                        EXPECT_EQ(listed[(y * 10) + x], visible) << test.attributes << " " << x << ", " << y;
+                    }
+                }
+            }
+        }
+    }
+}
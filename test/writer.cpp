@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <tmxpp.hpp>
+
+static void expectSameMap(const tmx::Map& expected, const tmx::Map& actual) {
+    EXPECT_EQ(actual.version(), expected.version());
+    EXPECT_EQ(actual.orientation(), expected.orientation());
+    EXPECT_EQ(actual.width(), expected.width());
+    EXPECT_EQ(actual.height(), expected.height());
+    EXPECT_EQ(actual.tileWidth(), expected.tileWidth());
+    EXPECT_EQ(actual.tileHeight(), expected.tileHeight());
+
+    ASSERT_EQ(actual.tilesets().size(), expected.tilesets().size());
+    for(std::size_t i = 0; i < expected.tilesets().size(); i++) {
+        const tmx::Tileset& expectedTileset = expected.tilesets()[i];
+        const tmx::Tileset& actualTileset = actual.tilesets()[i];
+        EXPECT_EQ(actualTileset.firstGID(), expectedTileset.firstGID());
+        EXPECT_EQ(actualTileset.source(), expectedTileset.source());
+        EXPECT_EQ(actualTileset.name(), expectedTileset.name());
+        EXPECT_EQ(actualTileset.tileCount(), expectedTileset.tileCount());
+        EXPECT_EQ(actualTileset.columns(), expectedTileset.columns());
+        EXPECT_EQ(actualTileset.image().source(), expectedTileset.image().source());
+        EXPECT_EQ(actualTileset.tiles().size(), expectedTileset.tiles().size());
+    }
+
+    ASSERT_EQ(actual.layers().size(), expected.layers().size());
+    for(std::size_t i = 0; i < expected.layers().size(); i++) {
+        ASSERT_EQ(actual.layers()[i].type(), expected.layers()[i].type());
+        if(expected.layers()[i].type() == tmx::Layer::Type::TILE) {
+            const tmx::TileLayer& expectedLayer = expected.layers()[i].tileLayer();
+            const tmx::TileLayer& actualLayer = actual.layers()[i].tileLayer();
+            EXPECT_EQ(actualLayer.id(), expectedLayer.id());
+            EXPECT_EQ(actualLayer.name(), expectedLayer.name());
+            EXPECT_EQ(actualLayer.properties().size(), expectedLayer.properties().size());
+            EXPECT_EQ(actualLayer.data(), expectedLayer.data());
+        }
+    }
+}
+
+TEST(WriterTest, RoundTripEncodings) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1.tmx");
+
+    using Encoding = tmx::SaveOptions::Encoding;
+    using Compression = tmx::SaveOptions::Compression;
+    for(auto [encoding, compression] : {std::pair(Encoding::CSV, Compression::NONE),
+            std::pair(Encoding::BASE64, Compression::NONE), std::pair(Encoding::BASE64, Compression::ZLIB),
+            std::pair(Encoding::BASE64, Compression::GZIP), std::pair(Encoding::BASE64, Compression::ZSTD)}) {
+        tmx::SaveOptions options;
+        options.encoding = encoding;
+        options.compression = compression;
+        options.compressionLevel = 9;
+        std::string data = map.saveToData(options);
+
+        tmx::Map saved;
+        saved.parseFromData(data);
+        expectSameMap(map, saved);
+        EXPECT_EQ(saved.layers()[0].tileLayer().encoding(), encoding == Encoding::CSV ? "csv" : "base64");
+
+        // Written document is stable, saving the parsed copy again gives the same bytes
+        EXPECT_EQ(saved.saveToData(options), data);
+    }
+}
+
+TEST(WriterTest, SingleThread) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1.tmx");
+
+    tmx::SaveOptions options;
+    options.encoding = tmx::SaveOptions::Encoding::BASE64;
+    options.compression = tmx::SaveOptions::Compression::ZLIB;
+    std::string parallel = map.saveToData(options);
+    options.threads = 1;
+    EXPECT_EQ(map.saveToData(options), parallel);
+}
+
+TEST(WriterTest, ExternalTileset) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1_external.tmx");
+    map.saveToFile("assets/pf1_external_saved.tmx");
+
+    tmx::Map saved;
+    saved.parseFromFile("assets/pf1_external_saved.tmx");
+    std::filesystem::remove("assets/pf1_external_saved.tmx");
+    expectSameMap(map, saved);
+    EXPECT_EQ(saved.tilesets()[0].source(), "pf1_external.tsx");
+    EXPECT_EQ(saved.tilesets()[0].tileCount(), 132);
+}
+
+TEST(WriterTest, PropertiesAndObjects) {
+    std::string data =
+        "<map version=\"1.10\" orientation=\"staggered\" staggeraxis=\"y\" staggerindex=\"odd\" width=\"2\" "
+        "height=\"1\" tilewidth=\"8\" tileheight=\"8\" class=\"level\" backgroundcolor=\"#80112233\">"
+        " <properties>"
+        "  <property name=\"name\" value=\"a &amp; &quot;b&quot;\"/>"
+        "  <property name=\"lines\">first\nsecond &lt;</property>"
+        "  <property name=\"count\" type=\"int\" value=\"-7\"/>"
+        "  <property name=\"speed\" type=\"float\" value=\"1.5\"/>"
+        "  <property name=\"enabled\" type=\"bool\" value=\"true\"/>"
+        "  <property name=\"tint\" type=\"color\" value=\"#ff1a2b3c\"/>"
+        "  <property name=\"target\" type=\"object\" value=\"2\"/>"
+        "  <property name=\"nested\" type=\"class\"><properties>"
+        "   <property name=\"inner\" type=\"int\" value=\"3\"/>"
+        "  </properties></property>"
+        " </properties>"
+        " <layer id=\"1\" name=\"tiles\" class=\"ground\" width=\"2\" height=\"1\" opacity=\"0.5\" visible=\"0\" "
+        "offsetx=\"1.25\" parallaxx=\"0.5\">"
+        "  <data encoding=\"csv\">2147483649,7</data>"
+        " </layer>"
+        " <objectgroup id=\"2\" name=\"objects\" color=\"#ff00ff\" draworder=\"index\">"
+        "  <object id=\"1\" name=\"area\" class=\"trigger\" x=\"1\" y=\"2\" width=\"3\" height=\"4\" rotation=\"45\">"
+        "<ellipse/></object>"
+        "  <object id=\"2\" x=\"5\" y=\"6\"><point/></object>"
+        "  <object id=\"3\" x=\"0.1\" y=\"0.2\"><polygon points=\"0,0 1.5,-2 3,4\"/></object>"
+        "  <object id=\"4\" x=\"0\" y=\"0\" width=\"64\" height=\"16\">"
+        "<text fontfamily=\"serif\" bold=\"1\" halign=\"center\" color=\"#ff0000\">Hello &lt;world&gt;</text></object>"
+        " </objectgroup>"
+        "</map>";
+
+    tmx::Map map;
+    map.parseFromData(data);
+    tmx::Map saved;
+    saved.parseFromData(map.saveToData());
+
+    EXPECT_EQ(saved.orientation(), tmx::Map::Orientation::STAGGERED);
+    EXPECT_EQ(saved.staggerAxis(), tmx::Map::StaggerAxis::Y_AXIS);
+    EXPECT_EQ(saved.staggerIndex(), tmx::Map::StaggerIndex::ODD);
+    EXPECT_EQ(saved.className(), "level");
+    EXPECT_EQ(saved.backgroundColor().a, 0x80);
+    EXPECT_EQ(saved.backgroundColor().r, 0x11);
+    EXPECT_EQ(saved.backgroundColor().b, 0x33);
+
+    EXPECT_EQ(saved.property("name").stringValue(), "a & \"b\"");
+    EXPECT_EQ(saved.property("lines").stringValue(), "first\nsecond <");
+    EXPECT_EQ(saved.property("count").intValue(), -7);
+    EXPECT_FLOAT_EQ(saved.property("speed").floatValue(), 1.5F);
+    EXPECT_TRUE(saved.property("enabled").boolValue());
+    EXPECT_EQ(saved.property("tint").colorValue().r, 0x1a);
+    EXPECT_EQ(saved.property("target").type(), tmx::Type::OBJECT);
+    EXPECT_EQ(saved.property("target").objectValue(), 2);
+    EXPECT_EQ(saved.property("nested").classValue().property("inner").intValue(), 3);
+
+    const tmx::TileLayer& layer = saved.layers()[0].tileLayer();
+    EXPECT_EQ(layer.className(), "ground");
+    EXPECT_DOUBLE_EQ(layer.opacity(), 0.5);
+    EXPECT_FALSE(layer.visible());
+    EXPECT_DOUBLE_EQ(layer.offset().x, 1.25);
+    EXPECT_DOUBLE_EQ(layer.parallaxFactor().x, 0.5);
+    EXPECT_DOUBLE_EQ(layer.parallaxFactor().y, 1);
+    EXPECT_TRUE(layer.flipHorizontal(0, 0));
+    EXPECT_EQ(layer.at(0, 0), 1);
+    EXPECT_EQ(layer.at(1, 0), 7);
+
+    const tmx::ObjectGroup& objectGroup = saved.layers()[1].objectGroup();
+    EXPECT_EQ(objectGroup.drawOrder(), tmx::ObjectGroup::DrawOrder::INDEX);
+    EXPECT_EQ(objectGroup.color().g, 0);
+    EXPECT_EQ(objectGroup.color().b, 0xff);
+    ASSERT_EQ(objectGroup.objects().size(), 4);
+    const tmx::Object& ellipse = objectGroup.objects()[0];
+    EXPECT_EQ(ellipse.type(), tmx::Object::Type::ELLIPSE);
+    EXPECT_EQ(ellipse.className(), "trigger");
+    EXPECT_DOUBLE_EQ(ellipse.size().x, 3);
+    EXPECT_DOUBLE_EQ(ellipse.rotation(), 45);
+    EXPECT_EQ(objectGroup.objects()[1].type(), tmx::Object::Type::POINT);
+    EXPECT_DOUBLE_EQ(objectGroup.objects()[2].position().x, 0.1);
+    ASSERT_EQ(objectGroup.objects()[2].polygon().size(), 3);
+    EXPECT_DOUBLE_EQ(objectGroup.objects()[2].polygon()[1].x, 1.5);
+    EXPECT_DOUBLE_EQ(objectGroup.objects()[2].polygon()[1].y, -2);
+    const tmx::Text& text = objectGroup.objects()[3].text();
+    EXPECT_EQ(text.text(), "Hello <world>");
+    EXPECT_EQ(text.fontFamily(), "serif");
+    EXPECT_TRUE(text.bold());
+    EXPECT_EQ(text.halign(), tmx::Text::HAlign::CENTER);
+    EXPECT_EQ(text.color().r, 0xff);
+}
+
+TEST(WriterTest, Errors) {
+    tmx::Map map;
+    map.parseFromFile("assets/pf1.tmx");
+
+    tmx::SaveOptions options;
+    options.compression = tmx::SaveOptions::Compression::ZLIB;
+    EXPECT_THROW(static_cast<void>(map.saveToData(options)), tmx::Exception);
+    EXPECT_THROW(map.saveToFile("missing/directory/map.tmx"), tmx::Exception);
+}
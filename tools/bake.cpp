@@ -0,0 +1,20 @@
+#include <exception>
+#include <iostream>
+#include <tmxpp.hpp>
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.tmx> <output>\n";
+        return 1;
+    }
+
+    try {
+        tmx::Map map;
+        map.parseFromFile(argv[1]);
+        map.bakeToFile(argv[2]);
+    } catch(const std::exception& e) {
+        std::cerr << argv[1] << ": " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}